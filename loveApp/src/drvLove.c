@@ -25,17 +25,50 @@
     initialize the driver, the method drvLoveInit() is called from the
     startup script with the following calling sequence.
 
-        drvLoveInit( lovPort, serPort, serAddr )
+        drvLoveInit( lovPort, serPort, serAddr, protocol )
 
         Where:
             lovPort - Love port driver name (i.e. "L0" )
-            serPort - Serial port driver name (i.e. "S0" )
+            serPort - Serial port driver name (i.e. "S0" ), or a tty
+                      device opened directly by the driver with optional
+                      baud rate and framing (i.e. "/dev/ttyS0,19200,8N1" ),
+                      or a loveBroker socket (i.e. "unix:/tmp/love0,19200" ),
+                      or a tty served by the event-loop engine (i.e.
+                      "event:/dev/ttyS0,19200,8N1" )
             serAddr - Serial port driver address
-
-
-    Every controller must be configured prior to IOC initialization. Call
-    the method drvLoveConfig() from the startup script with the following
-    calling sequence.
+            protocol- Optional, "ASCII" (default) for the Love protocol
+                      or "RTU" for Modbus RTU (16A controllers only).
+
+    In Modbus RTU mode the command names map to holding registers (see the
+    RTU column of CmdTable). A read fetches every register of the same
+    16-register page in one request and hands the neighbours to their next
+    reader, so the drvInfo names and databases are unchanged.
+
+    A serPort beginning with '/' bypasses drvAsynSerialPort. The tty is
+    put in raw mode, fixed-length replies are collected by the kernel in
+    one wakeup (VMIN) and, on Linux, the UART is set to low latency.
+
+    A serPort beginning with "unix:" sends every frame to a loveBroker
+    process, which owns the tty and shares it between IOCs. Baud rate and
+    framing only describe the bus for the capacity model; the broker keeps
+    the inter-frame gap, so the driver does not add its own.
+
+    A serPort beginning with "event:" opens the tty directly and hands its
+    bus I/O to the event-loop engine (ASCII protocol, Linux). One engine
+    thread owns the ttys of all such ports through epoll and runs the
+    request and reply of each bus as a state machine with its own
+    inter-frame gap. Such a port has no asyn port thread. A record read
+    returns the cached value and queues one refresh of the register; the
+    engine thread decodes the reply, updates the cache and calls back the
+    records of the register (SCAN "I/O Intr" or asyn:READBACK). Writes are
+    queued the same way, a failed write alarms its records through the
+    same callback. Warm-up, downloads, snapshots, ramps and the other
+    slow-path work of all event ports run on a few shared worker threads.
+
+
+    Every controller is configured with the method drvLoveConfig(), from
+    the startup script or, to add or re-model a controller while the IOC
+    runs, from the IOC shell.
 
         drvLoveConfig( lovPort, addr, model )
 
@@ -44,12 +77,266 @@
             addr    - Controller address on RS485.
             model   - Controller model type, either 1600 or 16A.
 
+    A controller is taken off the bus at run time with the method
+    drvLoveRemove(). Its records are disconnected until it is configured
+    again. Either change is made on the port thread between transactions,
+    flushes the cached values and poll state of the address and leaves
+    every other controller polling.
+
+        drvLoveRemove( lovPort, addr )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" )
+            addr    - Controller address on RS485.
+
+    The commands, models and their register codes and sign encodings are
+    listed in loveModels.def, which is expanded into constant tables when
+    the driver is compiled. A new model is added there.
+
     Prior to initializing the drvLove driver, the serial port driver
     (drvAsynSerialPort) must be initialized.
 
     The method dbior can be called from the IOC shell to display the current
     status of the driver as well as individual controllers.
 
+    Set points and alarm limits of many controllers can be downloaded in
+    bulk with the method drvLoveDownload(). Each port executes its part of
+    the table on its own thread, so all buses are written in parallel.
+
+        drvLoveDownload( file, wait )
+
+        Where:
+            file    - Text file, one "lovPort addr register value" entry
+                      per line. Register is SP1, SP2, AlLo or AlHi and
+                      value is the raw (unscaled) controller value.
+            wait    - Non-zero to wait for completion and print the
+                      status of every entry.
+
+    The same download can be requested through the port's "Download"
+    asynInt32Array interface with (addr, register, value) triplets, where
+    register is 1 (SP1), 2 (SP2), 3 (AlLo) or 4 (AlHi).
+
+    Saved settings restored at boot (i.e. by autosave) can be reconciled
+    with the controllers instead of being written blindly. Call the method
+    drvLoveRestore() prior to iocInit.
+
+        drvLoveRestore( lovPort )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" )
+
+    Until the IOC is running, set point and alarm limit writes to the port
+    are only remembered. Once the IOC is running each port reads those
+    registers back, compares them with the saved values and writes only
+    the ones that differ.
+
+    Neither drvLoveInit() nor drvLoveConfig() talks to the controllers.
+    At the beginning of iocInit each port starts a background warm-up that
+    reads every register of its configured controllers, process variables
+    first, so that the first scan of each record is served from the
+    warm-up. The method drvLoveWarmup() reports the warm-up progress, or
+    starts a new warm-up once the IOC is running.
+
+        drvLoveWarmup( lovPort )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" ), or all ports
+                      when empty.
+
+    The last known register values of a port can be persisted to a local
+    file with the method drvLoveCache(), called prior to iocInit. At
+    iocInit the register cache is seeded from the file and, until the
+    warm-up has refreshed a register, reads of it return the saved value
+    with its original timestamp and a UDF/MINOR alarm. Once the IOC is
+    running the file is rewritten (atomically) every period seconds.
+
+        drvLoveCache( lovPort, file, period )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" )
+            file    - Cache file path
+            period  - Seconds between snapshots (default 60)
+
+    Every sample entering the register cache can also be appended to a
+    shared memory-mapped ring file with the method drvLoveHistory(),
+    called prior to iocInit. Local tools read the file without locks
+    using the per-record sequence numbers; values are delta encoded.
+
+        drvLoveHistory( lovPort, file, depth )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" )
+            file    - History file path
+            depth   - Ring size in samples (default 65536, rounded
+                      up to a power of two)
+
+    The fast and slow fanouts of every controller are triggered by a
+    per-port poll scheduler instead of the periodic scan tasks. Each
+    period is divided evenly among the configured controllers and every
+    slot is fired at its absolute deadline. The periods can be changed
+    with the method drvLovePoll(), called prior to iocInit.
+
+        drvLovePoll( lovPort, fast, slow )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" )
+            fast    - Fast group period in seconds (default 2, 0 = off)
+            slow    - Slow group period in seconds (default 10, 0 = off)
+
+    The capacity of each bus is estimated from its serial settings, the
+    frame sizes and the measured controller turnaround. A warning is
+    printed when the configured poll load exceeds 80% of it. Polled reads
+    that find their register refreshed since they were queued are merged
+    with that read, and those still queued one period after their poll
+    are dropped in favour of the next one.
+
+    Once per poll sweep the port publishes overview arrays (ListAddr,
+    ListValue, ListAlSts and ListAge) holding one entry per configured
+    controller, all sharing the timestamp of the sweep.
+
+    SP1 and SP2 can be ramped by the driver. Writing RampNTarget starts
+    a ramp from the present set point at RampNRate raw counts per minute;
+    every RampNPeriod milliseconds a ramp thread queues the next step on
+    the port thread, which writes the set point for the elapsed time.
+    The ramp thread of a port starts with its first ramp.
+    RampNState and RampNCurrent report the progress; writing 0 to
+    RampNState aborts the ramp.
+
+    A successful write updates the register cache, stamped with the time
+    of the reply and marked as written, and fires readback callbacks. A
+    written value is not taken for a reading: the next read of the
+    register goes to the bus. The method drvLoveVerify() enables reading
+    every written register back within the same hold of the port lock.
+
+        drvLoveVerify( lovPort, enable )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" ), or all ports
+                      when empty.
+            enable  - 1 to verify writes, 0 to stop
+
+    Bus time (wire, retry and lock wait) is charged to every register and
+    record that causes a transaction. The method drvLoveTop() prints the
+    largest consumers; the TopAddr, TopCmd, TopShare and CmdShare arrays
+    publish them with the bus load.
+
+        drvLoveTop( lovPort, count, reset )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" )
+            count   - Rows per table (default 10)
+            reset   - 1 to clear the counters after printing
+
+    Controllers whose polled records have no monitors can be dropped to a
+    background rate with drvLoveDemand(); they return to the full rate at
+    the next slot once a client subscribes.
+
+        drvLoveDemand( lovPort, idle )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" ), or all ports
+                      when empty.
+            idle    - Background poll period in seconds, 0 to disable
+
+    The "00" reply is decoded into both Value and AlSts. Every status or
+    data word read is compared with the previous one, and I/O Intr
+    asynUInt32Digital callbacks are made for the masks whose bits changed.
+
+    The poll, ramp and port threads of a port can be given a real-time
+    policy with the method drvLoveSched(), called prior to iocInit. The
+    wakeup latency of the poll and ramp threads and the dispatch delay of
+    the port thread are published as WakeLatency and DispatchLatency.
+
+        drvLoveSched( lovPort, priority, fifo, cpus, lock )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" )
+            priority- EPICS thread priority (0-99, 0 = unchanged)
+            fifo    - 1 for SCHED_FIFO (Linux, needs CAP_SYS_NICE)
+            cpus    - CPU list the threads are pinned to (i.e. "2,3"
+                      or "2-3", Linux), empty for no affinity
+            lock    - 1 to lock the port structure, transaction pool
+                      and history ring in memory
+
+    What a bus sustains can be measured on the live port with the method
+    drvLoveBench(). Bursts of real transactions are run on the port thread,
+    each holding it for at most window seconds before the records get the
+    bus back, and a table of throughput, latency percentiles, errors and
+    retries is printed for every address, gap and timeout.
+
+        drvLoveBench( lovPort, addr, command, count, window, gaps, timeouts )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" )
+            addr    - Controller address, 0 for every configured one
+            command - Register read (default "Value")
+            count   - Transactions per address and setting (default 100)
+            window  - Seconds per burst (default 0.2)
+            gaps    - Inter-frame gaps in seconds (i.e. "0.1,0.05,0.02"),
+                      empty for the protocol default
+            timeouts- Reply timeouts in seconds (i.e. "1,0.2"), empty for
+                      the default of 1 second
+
+    A time-aligned snapshot of selected registers of every configured
+    controller on every port is taken on a trigger: a write to the
+    Snapshot parameter of any port (i.e. from a record processed by an
+    EPICS event) or the method drvLoveSnapshot(). Each port reads its
+    controllers ahead of all other I/O and publishes SnapAddr, SnapCmd,
+    SnapValue and SnapTime (seconds from the trigger) stamped with the
+    trigger time; SnapSkew is the spread over all ports.
+
+        drvLoveSnapshot( registers, wait )
+
+        Where:
+            registers - Comma separated register names (i.e.
+                        "Value,AlSts"), empty to keep the last (default
+                        "Value")
+            wait      - Non-zero to wait and print the snapshot
+
+    Every register value carries the time its reply was received, which
+    records get with TSE=-2, also when the value is answered from the
+    cache. The age of a register in milliseconds is read with the drvInfo
+    name of the command followed by "Age" (i.e. "ValueAge"). Values older
+    than the staleness threshold set with drvLoveStale() are returned with
+    a TIMEOUT/MAJOR alarm and counted in Stale.
+
+        drvLoveStale( lovPort, seconds )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" ), or all ports
+                      when empty.
+            seconds - Staleness threshold, 0 to disable
+
+    The ASCII inter-frame gap, 0.1 second by default, is set per port
+    with the method drvLoveGap(). It is kept before every frame of the
+    port's thread or of the event-loop engine; a broker port keeps the
+    broker's gap and Modbus RTU its 3.5 character silence.
+
+        drvLoveGap( lovPort, seconds )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" ), or all ports
+                      when empty.
+            seconds - Gap before each ASCII frame, 0 for none
+
+    A port can be soaked for hours with the method drvLoveSoak(). Every
+    period the port creates and destroys record instances, samples the
+    resident memory and thread count of the IOC, the live instances, the
+    transaction pool overflow and the 99th percentile transaction time,
+    and compares them with the first period. A drift is reported as a
+    warning, a summary is printed at the end. Optionally a fraction of
+    the replies is turned into timeouts, corrupted frames and dropped
+    connections, which are closed and opened again on every transport.
+
+        drvLoveSoak( lovPort, period, hours, faults, churn )
+
+        Where:
+            lovPort - Love port driver name (i.e. "L0" )
+            period  - Seconds per sample (default 60), 0 to stop
+            hours   - Duration, 0 to run until stopped
+            faults  - Fraction of replies replaced by a fault (0-1)
+            churn   - Record instances created and destroyed per period
+
 
  Developer notes:
 
@@ -72,63 +359,358 @@
                    STX (0x02) character and message length < 7.
  2016-Sep-24  RLS  Fix for hanging on lockPort() at boot-up; remove
                    asynLockPortNotify interface
+ 2026-Oct-18       Added pooled transaction contexts. Request formatting
+                   and reply decoding are performed outside of the
+                   lockPort()/unlockPort() critical section.
+ 2026-Oct-18       Added register cache, port parameters and the bulk
+                   set point / alarm limit download engine.
+ 2026-Oct-18       Added boot-time read-compare-write restore mode.
+ 2026-Oct-18       Moved controller access out of drvLoveInit(); added
+                   the background warm-up.
+ 2026-Oct-18       Added the persisted last-known-value cache file.
+ 2026-Oct-18       Added the phase-staggered poll scheduler.
+ 2026-Oct-18       Added the bus capacity model and deadline-based
+                   load shedding.
+ 2026-Oct-18       Added the Modbus RTU protocol mode for 16A controllers.
+ 2026-Oct-18       Added the port-wide overview arrays.
+ 2026-Oct-18       Added the shared memory-mapped history file.
+ 2026-Oct-18       Added driver-side SP1/SP2 ramping.
+ 2026-Oct-18       Added the write-through cache and write verification.
+ 2026-Oct-18       Added the direct tty transport.
+ 2026-Oct-18       Added bus-time accounting.
+ 2026-Oct-18       Added demand-driven polling.
+ 2026-Oct-18       Added per-mask status bit callbacks.
+ 2026-Oct-18       Added real-time scheduling of the I/O threads.
+ 2026-Oct-18       Added the live bus benchmark.
+ 2026-Oct-18       Added event-triggered coordinated snapshots.
+ 2026-Oct-18       Added reply timestamps, register age and staleness
+                   alarms.
+ 2026-Oct-18       Added the bus broker transport.
+ 2026-Oct-18       Moved the command and per-model register tables to
+                   loveModels.def.
+ 2026-Oct-18       Added the event-loop I/O engine for direct tty ports.
+ 2026-Oct-18       Event ports keep their port thread, the engine only
+                   runs the bus I/O.
+ 2026-Oct-18       Added the soak monitor and fault injection.
+ 2026-Oct-18       Added run-time add, remove and re-model of controllers.
+ 2026-Oct-18       Soak faults are injected on the bus reads of every
+                   transport and a lost reply waits out its timeout.
+ 2026-Oct-18       drvLoveInit adds a port to the engine before it is
+                   registered and to the port list only when complete.
+ 2026-Oct-18       Event ports are non-blocking, records complete from
+                   the engine thread and slow-path work runs on shared
+                   workers.
+ 2026-Oct-18       Added drvLoveGap() to set the ASCII inter-frame gap.
+ 2026-Oct-18       Soak state is published as port parameters and a
+                   dropped connection is reopened on every transport.
+ 2026-Oct-18       Frame codec and model tables moved to loveFrame.c,
+                   shared with loveBroker.
+ 2026-Oct-18       The ramp thread starts with the first ramp target.
+ 2026-Oct-18       Idle polling reads the monitor lists under the
+                   record lock.
+ 2026-Oct-18       A run-time controller change that is not applied in
+                   time is cancelled and fails.
+ 2026-Oct-18       Written values carry the reply time and are no
+                   longer served to the next read.
  -----------------------------------------------------------------------------
 
 */
 
 
+/* CPU affinity of the I/O threads on Linux (must precede every include) */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+
 /* EPICS base version-specific definitions (must be performed first) */
 #include <epicsVersion.h>
 #define LT_EPICSBASE(v,r,l) (EPICS_VERSION<(v)||(EPICS_VERSION==(v)&&(EPICS_REVISION<(r)||(EPICS_REVISION==(r)&&EPICS_MODIFICATION<(l)))))
 
 
 /* Evaluate EPICS base */
-#if LT_EPICSBASE(3,14,6)
-    #error "EPICS base must be 3.14.6 or greater"
+#if LT_EPICSBASE(3,15,0)
+    #error "EPICS base must be 3.15.0 or greater"
 #endif
 
 /* System related include files */
+#include <ctype.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 
+/* Memory-mapped cache file reads on POSIX hosts */
+#if !defined(vxWorks) && !defined(_WIN32)
+    #define USE_MMAP
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+
+/* Direct tty transport on POSIX hosts */
+#if !defined(vxWorks) && !defined(_WIN32)
+    #define USE_TTY
+    #include <errno.h>
+    #include <poll.h>
+    #include <termios.h>
+    #include <sys/ioctl.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #if defined(__linux__)
+        #include <linux/serial.h>
+    #endif
+#endif
+
+
+/* Real-time policy and CPU affinity of the I/O threads on Linux */
+#if defined(__linux__)
+    #define USE_SCHED
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+
+/* Event-loop I/O engine for direct tty ports on Linux */
+#if defined(__linux__)
+    #define USE_EPOLL
+    #include <stdint.h>
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+#endif
+
+
 /* EPICS system related include files */
 #include <iocsh.h>
 #include <epicsStdio.h>
 #include <cantProceed.h>
 #include <epicsString.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
 #include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsAtomic.h>
+#include <epicsTypes.h>
+#include <alarm.h>
+#include <dbAccess.h>
+#include <dbCommon.h>
+#include <dbLock.h>
+#include <dbScan.h>
+#include <dbStaticLib.h>
+#include <initHooks.h>
 
 
 /* EPICS synApps/Asyn related include files */
 #include <asynDriver.h>
 #include <asynInt32.h>
+#include <asynInt32Array.h>
+#include <asynFloat64Array.h>
 #include <asynOctet.h>
+#include <asynOption.h>
 #include <asynDrvUser.h>
 #include <asynUInt32Digital.h>
 #include <epicsExport.h>
 
 
+/* Bus broker wire format */
+#include "loveBroker.h"
+
+
+/* Frame codec and register map shared with loveBroker */
+#include "loveFrame.h"
+
+
 /* Define symbolic constants */
 #define K_INSTRMAX ( 256 )
 #define K_COMTMO   ( 1.0 )
 #define K_TUNE     ( 0.1 )
+#define K_TRANSMAX ( 8 )
+#define K_MSGSIZE  ( 32 )
+#define K_CMDMAX   ( 16 )
+#define K_SLICE    ( 16 )
+#define K_LINEMAX  ( 128 )
+#define K_PRIMED   ( 30.0 )
+#define K_CACHETMO ( 60.0 )
+#define K_CACHEMAG ( 0x4C4F5643 )
+#define K_CACHEVER ( 1 )
+#define K_FASTPOLL ( 2.0 )
+#define K_SLOWPOLL ( 10.0 )
+#define K_FASTREAD ( 4 )
+#define K_SLOWREAD ( 3 )
+#define K_FRAME    ( 24 )
+#define K_TURN     ( 0.01 )
+#define K_LOADMAX  ( 0.8 )
+#define K_TRIGMAX  ( 4 )
+#define K_RTUFRAME ( 15 )
+#define K_RTUBLOCK ( 12 )
+#define K_RTUAGE   ( 1.0 )
+#define K_PAIRAGE  ( 1.0 )
+#define K_HISTMAG  ( 0x4C4F5648 )
+#define K_HISTVER  ( 1 )
+#define K_HISTDEP  ( 65536 )
+#define K_HISTKEY  ( 32 )
+#define K_HISTABS  ( 0x01 )
+#define K_HISTNAME ( 8 )
+#define K_RAMPMAX  ( 2 )
+#define K_RAMPPER  ( 1000 )
+#define K_RAMPMIN  ( 100 )
+#define K_TTYBAUD  ( 19200 )
+#define K_BROKERWAIT ( 5.0 )
+#define K_TOPMAX   ( 16 )
+#define K_CPUMAX   ( 64 )
+#define K_BENCHMAX ( 8 )
+#define K_BENCHCNT ( 100 )
+#define K_BENCHWIN ( 0.2 )
+#define K_SNAPREG  ( 4 )
+#define K_SNAPMAX  ( K_INSTRMAX * K_SNAPREG )
+#define K_ENGINEMAX ( 64 )
+#define K_WORKMAX  ( 4 )
+#define K_SOAKPER  ( 60.0 )
+#define K_SOAKSAMP ( 4096 )
+#define K_SOAKRSS  ( 1024 )
+#define K_SOAKLAT  ( 2.0 )
+#define K_CHGTMO   ( 10.0 )
 
 
 /* Forward struct declarations */
 typedef struct Port Port;
 typedef struct Inst Inst;
 typedef struct Instr Instr;
-typedef struct CmdStr CmdStr;
 typedef struct CmdTbl CmdTbl;
 typedef struct Serport Serport;
+typedef struct Trans Trans;
+typedef struct Reg Reg;
+typedef struct Step Step;
+typedef struct Batch Batch;
+typedef struct CacheHdr CacheHdr;
+typedef struct CacheRec CacheRec;
+typedef struct Cache Cache;
+typedef struct Group Group;
+typedef struct List List;
+typedef struct HistHdr HistHdr;
+typedef struct HistRec HistRec;
+typedef struct History History;
+typedef struct Ramp Ramp;
+typedef struct Tty Tty;
+typedef struct Acct Acct;
+typedef struct Top Top;
+typedef struct Rank Rank;
+typedef struct Lat Lat;
+typedef struct Sched Sched;
+typedef struct BenchRes BenchRes;
+typedef struct Bench Bench;
+typedef struct Snap Snap;
+typedef struct Shot Shot;
+typedef struct Job Job;
+typedef struct Work Work;
+typedef struct Bus Bus;
+typedef struct Engine Engine;
+typedef struct Soak Soak;
+typedef struct Change Change;
 typedef union Readback Readback;
 
 
-/* Define model enum */
-typedef enum {model1600,model16A} Model;
+typedef enum {protoAscii,protoRtu} Proto;
+
+
+/* Define port parameter enum */
+typedef enum
+{
+    parDownload,parDlTotal,parDlDone,parDlSkipped,parDlFailed,parDlBusy,parDlStatus,
+    parWarmTotal,parWarmDone,parWarmSkipped,parWarmFailed,parWarmBusy,
+    parFastPoll,parFastLate,parFastJitter,parSlowPoll,parSlowLate,parSlowJitter,
+    parBusCapacity,parBusLoad,parBusOccupancy,parShed,parMerged,
+    parListAddr,parListValue,parListAlSts,parListAge,
+    parVerifyFailed,
+    parTopAddr,parTopCmd,parTopShare,parCmdShare,
+    parIdleCount,
+    parWakeLatency,parDispatchLatency,
+    parSnapshot,parSnapSkew,parSnapAddr,parSnapCmd,parSnapValue,parSnapTime,
+    parStale,
+    parSoakBusy,parSoakPeriods,parSoakWarnings,parSoakFaults,parSoakReconnects,
+    parCount
+} Param;
+
+
+/* Define batch kind enum and the offsets of its progress parameters */
+typedef enum {batchDownload,batchWarmup,batchCount} BatchKind;
+typedef enum {bpTotal,bpDone,bpSkipped,bpFailed,bpBusy} BatchPar;
+
+
+/* Define poll group enum */
+typedef enum {groupFast,groupSlow,groupCount} GroupKind;
+
+
+/* Define measured thread latency enum */
+typedef enum {latPoll,latRamp,latPort,latCount} LatKind;
+
+
+/* Define event-loop engine bus state enum */
+typedef enum {busIdle,busGap,busRecv,busMute} BusState;
+
+
+/* Define event-loop engine job kind enum */
+typedef enum {jobSync,jobRead,jobWrite,jobVerify} JobKind;
+
+
+/* Define download entry status and operation enums */
+typedef enum {stepPending,stepDone,stepSkipped,stepFailed,stepRejected} StepSts;
+typedef enum {opWrite,opRestore,opRead} StepOp;
+
+
+/* Define set point ramp parameter and state enums */
+typedef enum {rpTarget,rpRate,rpPeriod,rpState,rpCurrent,rpCount} RampPar;
+typedef enum {rampIdle,rampActive,rampDone,rampFailed} RampState;
+
+
+/* Declare bus-time account, charged with the serial port lock held */
+struct Acct
+{
+    unsigned long count;
+    unsigned long retries;
+    double        wire;
+    double        retry;
+    double        wait;
+    double        mark;
+};
+
+
+/* Declare register cache structure */
+struct Reg
+{
+    int            isValid;
+    epicsInt32     value;
+    epicsTimeStamp stamp;
+    int            isPending;
+    epicsInt32     pending;
+    double         primed;
+    int            isStale;
+    int            isWritten;
+    Acct           acct;
+    int            isBits;
+    epicsUInt32    bits;
+    int            isQueued;
+};
+
+
+/* Declare set point ramp structure, guarded by the port ramp lock */
+struct Ramp
+{
+    int            addr;
+    int            idx;
+    asynUser*      pasynUser;
+    epicsInt32     pars[rpCount];
+    int            isQueued;
+    int            isOrigin;
+    epicsInt32     origin;
+    epicsTimeStamp start;
+    epicsTimeStamp next;
+    unsigned long  steps;
+    unsigned long  late;
+};
 
 
 /* Declare instrument info structure */
@@ -136,6 +718,376 @@ struct Instr
 {
     Model modidx;
     int   isConn;
+    int   isConfig;
+    int   isRemoved;
+    Reg   regs[K_CMDMAX];
+
+    int            trigCount;
+    int            trigGroup[K_TRIGMAX];
+    epicsTimeStamp trigStamp[K_TRIGMAX];
+
+    Ramp           ramps[K_RAMPMAX];
+
+    dbCommon**     watch[groupCount];
+    int            nWatch[groupCount];
+    int            isIdle[groupCount];
+    epicsTimeStamp polled[groupCount];
+};
+
+
+/* Declare download entry structure */
+struct Step
+{
+    int        index;
+    int        line;
+    int        addr;
+    int        cmdidx;
+    epicsInt32 value;
+    StepOp     op;
+    int        prio;
+    StepSts    sts;
+};
+
+
+/* Declare download batch structure */
+struct Batch
+{
+    Port*        pport;
+    BatchKind    kind;
+    asynUser*    pasynUser;
+    epicsEventId done;
+    int          count;
+    int          size;
+    int          next;
+    int          nDone;
+    int          nSkipped;
+    int          nFailed;
+    int          restore;
+    int          refs;
+    Step*        psteps;
+    epicsInt32*  pstatus;
+};
+
+
+/* Declare value cache file header and record structures */
+struct CacheHdr
+{
+    epicsUInt32 magic;
+    epicsUInt32 version;
+    epicsUInt32 cmdCount;
+    epicsUInt32 count;
+};
+
+struct CacheRec
+{
+    epicsUInt16 addr;
+    epicsUInt8  cmdidx;
+    epicsUInt8  modidx;
+    epicsInt32  value;
+    epicsUInt32 secPastEpoch;
+    epicsUInt32 nsec;
+};
+
+
+/* Declare value cache structure */
+struct Cache
+{
+    char*        file;
+    char*        tmpFile;
+    double       period;
+    asynUser*    pasynUser;
+    epicsEventId snapped;
+    int          nSeeded;
+    int          nSaves;
+    int          nFailed;
+    int          count;
+    CacheRec     recs[K_INSTRMAX * K_CMDMAX];
+};
+
+
+/* Declare shared history file header and record structures */
+struct HistHdr
+{
+    epicsUInt32 magic;
+    epicsUInt32 version;
+    epicsUInt32 hdrSize;
+    epicsUInt32 recSize;
+    epicsUInt32 depth;
+    epicsUInt32 cmdCount;
+    epicsUInt32 keyEvery;
+    epicsUInt32 head;
+    char        cmds[K_CMDMAX][K_HISTNAME];
+};
+
+struct HistRec
+{
+    epicsUInt32 seq;
+    epicsUInt16 addr;
+    epicsUInt8  cmdidx;
+    epicsUInt8  flags;
+    epicsInt32  value;
+    epicsUInt32 secPastEpoch;
+    epicsUInt32 nsec;
+};
+
+
+/* Declare shared history structure, writers are serialized by its lock */
+struct History
+{
+    char*         file;
+    epicsMutexId  lock;
+    void*         pdata;
+    size_t        size;
+    HistHdr*      phdr;
+    HistRec*      precs;
+    epicsUInt32   depth;
+    epicsUInt32   head;
+    epicsInt32    last[K_INSTRMAX][K_CMDMAX];
+    epicsUInt8    left[K_INSTRMAX][K_CMDMAX];
+};
+
+
+/* Declare poll group structure */
+struct Group
+{
+    double         period;
+    double         offset;
+    int            reads;
+    Param          trigger;
+    Param          late;
+    Param          jitter;
+    int            count;
+    int            slot;
+    int            addrs[K_INSTRMAX];
+    int            isLast;
+    epicsTimeStamp start;
+    epicsTimeStamp next;
+    epicsTimeStamp last;
+    double         cycleLate;
+    double         cycleJitter;
+    unsigned long  fires;
+    unsigned long  overruns;
+    double         lateSum;
+    double         lateMax;
+    double         jitterSum;
+    double         jitterMax;
+};
+
+
+/* Declare port-wide overview structure, one entry per configured controller */
+struct List
+{
+    asynUser*      pasynUser;
+    int            isQueued;
+    int            count;
+    unsigned long  sweeps;
+    epicsTimeStamp stamp;
+    epicsInt32     addrs[K_INSTRMAX];
+    epicsInt32     alsts[K_INSTRMAX];
+    epicsFloat64   values[K_INSTRMAX];
+    epicsFloat64   ages[K_INSTRMAX];
+};
+
+
+/* Declare top bus consumers, shares in percent of the line since the last update */
+struct Top
+{
+    int            count;
+    epicsTimeStamp stamp;
+    epicsInt32     addrs[K_TOPMAX];
+    epicsInt32     cmds[K_TOPMAX];
+    epicsFloat64   shares[K_TOPMAX];
+    epicsFloat64   cmdShares[K_CMDMAX];
+};
+
+
+/* Declare thread latency, the peak is cleared at every bus update */
+struct Lat
+{
+    unsigned long count;
+    double        sum;
+    double        max;
+    double        peak;
+};
+
+
+/* Declare real-time scheduling settings of the poll, ramp and port threads */
+struct Sched
+{
+    int            prio;
+    int            isFifo;
+    int            nCpus;
+    char           cpus[K_CPUMAX];
+    int            isLock;
+    int            isLocked;
+    size_t         size;
+    int            nFailed;
+    asynUser*      pasynUser;
+    int            isQueued;
+    int            isApplied;
+    epicsTimeStamp queued;
+    double         held;
+    epicsMutexId   lock;
+    Lat            lats[latCount];
+};
+
+
+/* Declare event-loop engine structures, guarded by the engine lock */
+struct Bus
+{
+    int            isEngine;
+    BusState       state;
+    double         gap;
+    epicsTimeStamp due;
+    epicsTimeStamp last;
+    epicsTimeStamp tsTry;
+    Job*           phead;
+    Job*           ptail;
+    Job*           pcur;
+    Job*           pfree;
+    epicsEventId   done;
+    int            isWorking;
+    unsigned long  nJobs;
+    unsigned long  nTimeouts;
+};
+
+struct Engine
+{
+    int            epfd;
+    int            wakefd;
+    epicsMutexId   lock;
+    epicsThreadId  tid;
+    int            nPorts;
+    Port*          pports[K_ENGINEMAX];
+    unsigned long  nLoops;
+    unsigned long  nEvents;
+    Work*          pwork;
+    epicsEventId   workWake;
+    int            nWorkers;
+    unsigned long  nWork;
+};
+
+
+/* Declare live bus benchmark, one result per address, gap and timeout */
+struct BenchRes
+{
+    int    addr;
+    double gap;
+    double timeout;
+    int    count;
+    int    nErrors;
+    int    retries;
+    double busy;
+    double min;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+};
+
+struct Bench
+{
+    Port*        pport;
+    asynUser*    pasynUser;
+    epicsEventId done;
+    int          cmdidx;
+    int          count;
+    double       window;
+    int          nCells;
+    int          cell;
+    double*      plats;
+    BenchRes*    pres;
+};
+
+
+/* Declare coordinated snapshot shared by every port, guarded by its lock */
+struct Snap
+{
+    epicsMutexId   lock;
+    epicsEventId   done;
+    int            nCmds;
+    int            cmds[K_SNAPREG];
+    epicsInt32     seq;
+    int            pending;
+    unsigned long  nJoined;
+    epicsTimeStamp stamp;
+    int            nSamples;
+    epicsTimeStamp first;
+    epicsTimeStamp last;
+};
+
+
+/* Declare the part of a snapshot taken by one port, owned by its port thread */
+struct Shot
+{
+    asynUser*      pasynUser;
+    int            count;
+    int            nFailed;
+    int            nSamples;
+    epicsTimeStamp first;
+    epicsTimeStamp last;
+    epicsInt32     addrs[K_SNAPMAX];
+    epicsInt32     cmds[K_SNAPMAX];
+    epicsFloat64   values[K_SNAPMAX];
+    epicsFloat64   times[K_SNAPMAX];
+};
+
+
+/* Declare soak monitor, samples are added by whichever thread ends a transaction */
+struct Soak
+{
+    epicsMutexId   lock;
+    epicsEventId   wake;
+    asynUser*      pasynUser;
+    asynDrvUser*   pdrvUser;
+    void*          drvPvt;
+    int            isRunning;
+    double         period;
+    double         hours;
+    double         faults;
+    double         faultAcc;
+    int            churn;
+    epicsTimeStamp start;
+    int            nLat;
+    double         lats[K_SOAKSAMP];
+    unsigned long  nTrans;
+    unsigned long  nErrors;
+    unsigned long  nFaults;
+    unsigned long  nReconnects;
+    unsigned long  nChurn;
+    int            nWindows;
+    int            nWarnings;
+    long           baseRss;
+    long           rss;
+    long           baseThreads;
+    long           threads;
+    int            baseInsts;
+    int            insts;
+    int            baseOverflow;
+    double         baseP99;
+    double         p99;
+};
+
+
+/* Declare run-time controller change, applied on the port thread */
+struct Change
+{
+    Port*        pport;
+    int          addr;
+    int          modidx;
+    asynUser*    pasynUser;
+    asynUser*    pdevUser;
+    epicsEventId done;
+};
+
+
+/* Declare drvLoveTop() ranking entry */
+struct Rank
+{
+    const char* name;
+    int         addr;
+    int         cmdidx;
+    Acct        acct;
 };
 
 
@@ -151,6 +1103,63 @@ struct Serport
     asynUser*   pasynUser;
     asynOctet*  pasynOctet;
     void*       pasynOctetPvt;
+    asynOption* pasynOption;
+    void*       pasynOptionPvt;
+    asynCommon* pasynCommon;
+    void*       pasynCommonPvt;
+    Tty*        ptty;
+};
+
+
+/* Declare direct tty transport structure, presented through asynOctet */
+struct Tty
+{
+    int           fd;
+    char*         pdev;
+    int           baud;
+    int           bits;
+    char          parity;
+    int           stop;
+    int           vmin;
+    int           isLowLatency;
+    int           isBroker;
+    int           isEngine;
+    int           isPending;
+    unsigned int  seq;
+    size_t        repLen;
+    size_t        repPos;
+    unsigned char rep[LOVEBROKER_FRAMEMAX];
+    unsigned long nReconnects;
+    epicsMutexId  lock;
+    int           inpEosLen;
+    char          inpEos;
+    int           outEosLen;
+    char          outEos;
+    unsigned long nReads;
+    unsigned long nWakeups;
+};
+
+
+/* Declare transaction context structure */
+struct Trans
+{
+    int            inUse;
+    int            isHeap;
+    asynStatus     sts;
+    size_t         outLen;
+    size_t         rawLen;
+    char           outMsg[K_MSGSIZE];
+    char           rawMsg[K_MSGSIZE];
+    char           inpMsg[K_MSGSIZE];
+    epicsTimeStamp tsTake;
+    epicsTimeStamp tsLock;
+    epicsTimeStamp tsUnlock;
+    epicsTimeStamp tsReply;
+    Inst*          pinst;
+    int            retries;
+    double         retryTime;
+    double         gap;
+    double         timeout;
 };
 
 
@@ -161,16 +1170,62 @@ struct Port
 
     char*         name;
     int           isConn;
+    Proto         proto;
     Serport*      pserport;
     asynUser*     pasynUser;
     asynInterface asynInt32;
+    asynInterface asynInt32Array;
+    asynInterface asynFloat64Array;
     asynInterface asynUInt32;
     asynInterface asynCommon;
     asynInterface asynDrvUser;
     asynInterface asynLockPort;
-    char          outMsg[20];
-    char          inpMsg[20];
-    char          tmpMsg[20];
+    void*         asynInt32Pvt;
+    void*         asynInt32ArrayPvt;
+    void*         asynFloat64ArrayPvt;
+    void*         asynUInt32Pvt;
+    epicsInt32    params[parCount];
+    int           isEos;
+    int           warmup;
+    int           restore;
+    int           busy[batchCount];
+    Batch*        pbatch[batchCount];
+    Cache*        pcache;
+    History*      phist;
+    int           verify;
+    int           nVerifyFailed;
+    epicsMutexId  rampLock;
+    epicsEventId  rampWake;
+    epicsThreadId rampTid;
+    epicsMutexId  cacheLock;
+    Group         groups[groupCount];
+    List          list;
+    Top           top;
+    epicsTimeStamp acctStamp;
+    epicsMutexId  instLock;
+    Inst*         pinsts;
+    double        idle;
+    int           nIdle;
+    double        stale;
+    double        gap;
+    int           nStale;
+    Sched         sched;
+    Bus           bus;
+    Shot          shot;
+    Trans         trans[K_TRANSMAX];
+    int           transOverflow;
+    int           nInsts;
+    Soak*         psoak;
+    unsigned long lockCount;
+    double        lockTime;
+    double        lockMax;
+    double        charTime;
+    double        turnaround;
+    int           isOverload;
+    epicsTimeStamp busStamp;
+    double        busTime;
+    int           nShed;
+    int           nMerged;
     Instr         instr[K_INSTRMAX];
 };
 
@@ -178,30 +1233,63 @@ struct Port
 /* Define record instance struct */
 struct Inst
 {
+    int addr;
+    int cmdidx;
+    int param;
+    int ramp;
+    int isAge;
+    int isDone;
+    epicsTimeStamp done;
     Instr* pinfo;
     Port* pport;
-    const CmdStr* pcmd;
-    asynStatus (*read)(Inst* pinst,epicsInt32* value);
-    asynStatus (*write)(Inst* pinst,epicsInt32* value);
+    Acct acct;
+    const char* owner;
+    Inst* pnext;
+    asynStatus (*read)(Inst* pinst,Trans* ptrans,epicsInt32* value);
+    asynStatus (*write)(Inst* pinst,Trans* ptrans,epicsInt32* value);
+};
+
+
+/* Declare event-loop engine job, one bus transaction of a slow-path caller or a record */
+struct Job
+{
+    Job*          pnext;
+    Port*         pport;
+    Trans*        ptrans;
+    int           tries;
+    asynStatus    sts;
+    epicsEventId  done;
+    JobKind       kind;
+    Inst*         pinst;
+    int           modidx;
+    epicsInt32    value;
+    int           verify;
+    Trans         trans;
 };
 
 
-/* Define command strings struct */
-struct CmdStr
+/* Declare slow-path request of an event port, run by a shared worker thread */
+struct Work
 {
-    const char* read;
-    const char* write;
+    Work*             pnext;
+    Port*             pport;
+    asynUser*         pasynUser;
+    userCallback      callback;
+    asynQueuePriority prio;
 };
 
+
+/* Define command table struct, the model and register tables are in loveFrame.c */
 struct CmdTbl
 {
     const char* pname;
-    asynStatus (*read)(Inst* pinst,epicsInt32* value);
-    asynStatus (*write)(Inst* pinst,epicsInt32* value);
-    CmdStr strings[2];
+    asynStatus (*read)(Inst* pinst,Trans* ptrans,epicsInt32* value);
+    asynStatus (*write)(Inst* pinst,Trans* ptrans,epicsInt32* value);
+    int warm;
+    int reg;
+    int wreg;
 };
 
-
 /* Define readback struct */
 union Readback
 {
@@ -227,6 +1315,8 @@ union Readback
 
 /* Define local variants */
 static Port* pports = NULL;
+static Snap snap;
+static Engine engine;
 
 static char* errCodes[] =
 {
@@ -245,50 +1335,258 @@ static char* errCodes[] =
 
 
 /* Define table and forward references for command response methods */
-static asynStatus getValue(Inst* pinst,epicsInt32* value);
-static asynStatus getStatus(Inst* pinst,epicsInt32* value);
-static asynStatus getSignedValue(Inst* pinst,epicsInt32* value);
-static asynStatus getData(Inst* pinst,epicsInt32* value);
-static asynStatus putData(Inst* pinst,epicsInt32* value);
-static asynStatus doNull(Inst* pinst,epicsInt32* value);
+static asynStatus getValue(Inst* pinst,Trans* ptrans,epicsInt32* value);
+static asynStatus getStatus(Inst* pinst,Trans* ptrans,epicsInt32* value);
+static asynStatus getSignedValue(Inst* pinst,Trans* ptrans,epicsInt32* value);
+static asynStatus getData(Inst* pinst,Trans* ptrans,epicsInt32* value);
+static asynStatus putData(Inst* pinst,Trans* ptrans,epicsInt32* value);
+static asynStatus doNull(Inst* pinst,Trans* ptrans,epicsInt32* value);
 
 static const CmdTbl CmdTable[] =
 {
-    /*Command  Read             Write    1600              16A      */
-    {"Value",  getValue,        doNull,  {{  "00",   NULL},{  "00",   NULL}}},
-    {"SP1",    getSignedValue,  putData, {{"0100", "0200"},{"0101", "0200"}}},
-    {"SP2",    getSignedValue,  putData, {{"0102", "0202"},{"0105", "0204"}}},
-    {"AlLo",   getSignedValue,  putData, {{"0104", "0204"},{"0106", "0207"}}},
-    {"AlHi",   getSignedValue,  putData, {{"0105", "0205"},{"0107", "0208"}}},
-    {"Peak",   getSignedValue,  doNull,  {{"011A",   NULL},{"011D",   NULL}}},
-    {"Valley", getSignedValue,  doNull,  {{"011B",   NULL},{"011E",   NULL}}},
-    {"AlSts",  getStatus,       doNull,  {{  "00",   NULL},{  "00",   NULL}}},
-    {"AlMode", getData,         doNull,  {{"0337",   NULL},{"031D",   NULL}}},
-    {"InpTyp", getData,         doNull,  {{"0323",   NULL},{"0317",   NULL}}},
-    {"ComSts", getData,         doNull,  {{"032A",   NULL},{"0324",   NULL}}},
-    {"Decpts", getData,         doNull,  {{"0324",   NULL},{"031A",   NULL}}}
+#define LOVE_CMD(name,read,write,warm,rtuRd,rtuWr) {#name,read,write,warm,rtuRd,rtuWr},
+#include "loveModels.def"
 };
 static const int cmdCount = (sizeof(CmdTable) / sizeof(CmdTbl));
 
 
+/* Download register codes (asynInt32Array "Download" interface) */
+static const char* dlRegs[] = {NULL,"SP1","SP2","AlLo","AlHi"};
+static const int dlRegCount = (sizeof(dlRegs) / sizeof(char*));
+
+static const char* ParamName[parCount] =
+{
+    "Download", "DlTotal", "DlDone", "DlSkipped", "DlFailed", "DlBusy", "DlStatus",
+    "WarmTotal", "WarmDone", "WarmSkipped", "WarmFailed", "WarmBusy",
+    "FastPoll", "FastLate", "FastJitter", "SlowPoll", "SlowLate", "SlowJitter",
+    "BusCapacity", "BusLoad", "BusOccupancy", "Shed", "Merged",
+    "ListAddr", "ListValue", "ListAlSts", "ListAge",
+    "VerifyFailed",
+    "TopAddr", "TopCmd", "TopShare", "CmdShare",
+    "IdleCount",
+    "WakeLatency", "DispatchLatency",
+    "Snapshot", "SnapSkew", "SnapAddr", "SnapCmd", "SnapValue", "SnapTime",
+    "Stale",
+    "SoakBusy", "SoakPeriods", "SoakWarnings", "SoakFaults", "SoakReconnects"
+};
+
+static const char* groupNames[groupCount] = {"Fast","Slow"};
+
+static const char* latNames[latCount] = {"poll wakeup","ramp wakeup","port dispatch"};
+
+static const Param batchBase[batchCount] = {parDlTotal,parWarmTotal};
+
+static const char* stepNames[] = {"pending","done","skipped","failed","rejected"};
+
+/* Ramp parameters are per controller, one set for each set point */
+static const char* rampRegs[K_RAMPMAX] = {"SP1","SP2"};
+static const char* rampNames[K_RAMPMAX][rpCount] =
+{
+    {"Ramp1Target", "Ramp1Rate", "Ramp1Period", "Ramp1State", "Ramp1Current"},
+    {"Ramp2Target", "Ramp2Rate", "Ramp2Period", "Ramp2State", "Ramp2Current"}
+};
+
+
 /* Public forward references */
-int drvLoveInit(const char* lovPort,const char* serPort,int serAddr);
+int drvLoveInit(const char* lovPort,const char* serPort,int serAddr,const char* protocol);
 int drvLoveConfig(const char* lovPort,int addr,const char *model);
+int drvLoveRemove(const char* lovPort,int addr);
+int drvLoveDownload(const char* file,int wait);
+int drvLoveRestore(const char* lovPort);
+int drvLoveWarmup(const char* lovPort);
+int drvLoveCache(const char* lovPort,const char* file,double period);
+int drvLovePoll(const char* lovPort,double fast,double slow);
+int drvLoveHistory(const char* lovPort,const char* file,int depth);
+int drvLoveVerify(const char* lovPort,int enable);
+int drvLoveTop(const char* lovPort,int count,int reset);
+int drvLoveDemand(const char* lovPort,double idle);
+int drvLoveSched(const char* lovPort,int priority,int fifo,const char* cpus,int lock);
+int drvLoveBench(const char* lovPort,int addr,const char* command,int count,double window,const char* gaps,const char* timeouts);
+int drvLoveSnapshot(const char* registers,int wait);
+int drvLoveStale(const char* lovPort,double seconds);
+int drvLoveGap(const char* lovPort,double seconds);
+int drvLoveSoak(const char* lovPort,double period,double hours,double faults,int churn);
 
 
 /* Forward references for support methods */
 static asynStatus initSerialPort(Port* plov,const char* serPort,int serAddr);
 static void exceptCallback(asynUser* pasynUser,asynException exception);
-
-
-static asynStatus processWriteResponse(Port* pport);
-static asynStatus executeCommand(Port* pport,asynUser* pasynUser);
-static asynStatus sendCommand(void* ppvt,asynUser* pasynUser,int retry);
-static asynStatus recvReply(void* ppvt,asynUser* pasynUser,char* data,size_t maxchars);
+static asynStatus initTtyPort(Port* plov,const char* serPort);
+static void freeTty(Port* plov);
+
+
+static Trans* takeTrans(Port* pport);
+static void initTrans(Trans* ptrans);
+static void giveTrans(Port* pport,Trans* ptrans);
+
+static int findCommand(const char* name);
+static void initInst(Inst* pinst,Port* pport,int addr,int cmdidx);
+static const LoveCodes* instCmd(const Inst* pinst);
+static void setCache(Inst* pinst,epicsInt32 value,const epicsTimeStamp* pstamp);
+static void stampRead(Port* pport,Inst* pinst,asynUser* pasynUser);
+static asynStatus readAge(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32* value);
+static void clearCache(Inst* pinst);
+static void writeThrough(Port* pport,Inst* pinst,epicsInt32 value,const epicsTimeStamp* pstamp);
+static void readbackCallback(Port* pport,int addr,int cmdidx,epicsInt32 value);
+static void errorCallback(Port* pport,int addr,int cmdidx,int alarm);
+static epicsUInt32 bitsUpdate(Reg* preg,int cmdidx,epicsUInt32 value);
+static void bitsCallback(Port* pport,int addr,int cmdidx,epicsUInt32 value,epicsUInt32 changed,const epicsTimeStamp* pstamp);
+static void pairStatus(Port* pport,Inst* pinst,Trans* ptrans);
+static void setParam(Port* pport,Param par,epicsInt32 value);
+static void callbackArray(Port* pport,Param par,epicsInt32* data,size_t count);
+
+static Batch* createBatch(Port* pport,BatchKind kind);
+static void holdBatch(Batch* pbatch);
+static void freeBatch(Batch* pbatch);
+static asynStatus addStep(Batch* pbatch,StepOp op,int line,int addr,int cmdidx,epicsInt32 value);
+static int cmpStep(const void* p1,const void* p2);
+static void setBatchParam(Batch* pbatch,int field,epicsInt32 value);
+static void prepareBatch(Batch* pbatch);
+static asynQueuePriority batchPriority(Batch* pbatch);
+static asynStatus startBatch(Batch* pbatch);
+static void collectRestore(Batch* pbatch);
+static int deferWrite(Port* pport,Inst* pinst,epicsInt32 value);
+static asynStatus startWarmup(Port* pport);
+static void initHook(initHookState state);
+static void processBatch(asynUser* pasynUser);
+static void runStep(Batch* pbatch,Step* pstep);
+static int readPrimed(Inst* pinst,epicsInt32* value);
+
+static void* mapCache(const char* file,size_t* psize);
+static void unmapCache(void* pdata,size_t size);
+static void loadCache(Port* pport);
+static void snapCache(asynUser* pasynUser);
+static asynStatus saveCache(Port* pport);
+static void cacheThread(void* parm);
+static int readStale(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32* value);
+
+static void initGroup(Group* pgrp,GroupKind kind,double period);
+static void startCycle(Port* pport,Group* pgrp,const epicsTimeStamp* pnow,int isFirst);
+static void firePoll(Port* pport,Group* pgrp,const epicsTimeStamp* pnow);
+static void triggerPoll(Port* pport,Param par,int addr,epicsInt32 value);
+static void pollThread(void* parm);
+static int skipPoll(Port* pport,Instr* pinfo,int grp,const epicsTimeStamp* pnow);
+static void addWatch(Instr* pinfo,int grp,dbCommon* precord);
+
+static double calcCharTime(Port* pport);
+static double estimateCapacity(Port* pport);
+static double estimateLoad(Port* pport);
+static void checkLoad(Port* pport);
+static void updateBus(Port* pport,const epicsTimeStamp* pnow);
+static int findQueued(Port* pport,Inst* pinst,epicsTimeStamp* pqueued,double* pperiod);
+static int shedRead(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32* value);
+
+static void* mapHistory(const char* file,size_t size);
+static void addHistory(Port* pport,int addr,int cmdidx,epicsInt32 value,const epicsTimeStamp* pstamp);
+
+static asynStatus writeRamp(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32 value);
+static void rampStep(asynUser* pasynUser);
+static void rampCallback(Port* pport,Ramp* pramp,RampPar par);
+static void startRamp(Port* pport,int onlyActive);
+static void rampThread(void* parm);
+
+static Group* sweepGroup(Port* pport);
+static void buildList(asynUser* pasynUser);
+static void refreshList(Port* pport);
+static void callbackList(Port* pport,Param par,void* data,size_t count,const epicsTimeStamp* pstamp);
+
+static void chargeTrans(Port* pport,Trans* ptrans,asynStatus sts,double held);
+static void buildTop(Port* pport);
+static void publishTop(Port* pport);
+static void resetAcct(Port* pport);
+static void scanRecords(Port* pport);
+static int cmpRank(const void* p1,const void* p2);
+static void printRank(Rank* pranks,int count,int max,double elapsed);
+
+static int parseCpus(Sched* psched,const char* cpus);
+static unsigned int schedPriority(Port* pport,unsigned int prio);
+static void applySched(Port* pport,const char* who);
+static void lockMemory(Port* pport);
+static void noteLatency(Port* pport,LatKind kind,double delay);
+static void probeSched(Port* pport);
+static void schedPort(asynUser* pasynUser);
+static void publishLatency(Port* pport);
+
+static int parseList(const char* list,double* pvals,double dflt);
+static Bench* createBench(Port* pport,int cmdidx,int count,double window,int nCells);
+static void freeBench(Bench* pbench);
+static void runBench(asynUser* pasynUser);
+static asynStatus benchTransact(Bench* pbench,BenchRes* pres,asynUser* pasynUser);
+static void finishCell(Bench* pbench,BenchRes* pres);
+static int cmpDouble(const void* p1,const void* p2);
+
+static asynStatus engineAdd(Port* pport);
+static void engineStart(Port* pport);
+static void engineDrop(Port* pport);
+static void engineThread(void* parm);
+static void engineSubmit(Port* pport,Job* pjob);
+static double engineStep(Port* pport,const epicsTimeStamp* pnow,Job** ppdone);
+static void engineRecv(Port* pport,const epicsTimeStamp* pnow,Job** ppdone);
+static void engineDone(Port* pport,asynStatus sts,const epicsTimeStamp* pnow,Job** ppdone);
+static asynStatus engineTransact(Port* pport,Trans* ptrans);
+static asynStatus engineQueue(Port* pport,Inst* pinst,JobKind kind,epicsInt32 value);
+static asynStatus engineFrame(Port* pport,Job* pjob);
+static void engineFinish(Port* pport,Job* pjob);
+static void engineFree(Port* pport,Job* pjob);
+static asynStatus engineRead(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32* value);
+static asynStatus engineWrite(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32 value);
+static asynStatus queuePort(Port* pport,asynUser* pasynUser,userCallback callback,asynQueuePriority prio);
+static asynStatus cancelPort(Port* pport,asynUser* pasynUser,int* pwasQueued);
+static void workThread(void* parm);
+
+static int changeInstr(Port* pport,int addr,int modidx);
+static void applyChange(asynUser* pasynUser);
+static void flushInstr(Port* pport,Instr* pinfo);
+
+static void soakThread(void* parm);
+static void soakSample(Port* pport,asynStatus sts,double held);
+static int soakKind(Soak* psoak);
+static asynStatus soakFault(Port* pport,asynUser* pasynUser,char* data,size_t* pbytes,const epicsTimeStamp* pstart);
+static void soakDrop(Port* pport);
+static void soakChurn(Soak* psoak);
+static void soakMeasure(long* prss,long* pthreads);
+static void soakCheck(Port* pport);
+static void soakPublish(Port* pport);
+
+static asynStatus startSnapshot(void);
+static void takeShot(asynUser* pasynUser);
+static void finishShot(Port* pport);
+
+static asynStatus readCommand(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32* value);
+static asynStatus writeCommand(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32 value);
+static asynStatus verifyWrite(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32 value);
+static asynStatus transact(Port* pport,Trans* ptrans,asynUser* pasynUser,int addr);
+static void noteTransaction(Port* pport,Trans* ptrans,asynStatus sts,double delay,size_t outLen);
+static asynStatus processWriteResponse(Port* pport,Trans* ptrans);
+static asynStatus buildCommand(Port* pport,Trans* ptrans,int addr);
+static asynStatus executeCommand(Port* pport,Trans* ptrans,asynUser* pasynUser);
+static asynStatus sendCommand(void* ppvt,Trans* ptrans,asynUser* pasynUser,int retry);
+static asynStatus recvReply(void* ppvt,Trans* ptrans,asynUser* pasynUser);
+static asynStatus readSerport(Port* pport,char* data,size_t maxchars,size_t* pbytes,int* peom);
 
 static asynStatus setDefaultEos(Port* plov);
 static asynStatus evalMessage(size_t* pcount,char* pinp,asynUser* pasynUser,char* pout);
-static void calcChecksum(size_t count,const char* pdata,unsigned char* pcs);
+
+static int rtuBlock(int modidx,int cmdidx,int* plo,int* phi);
+static epicsInt32 rtuDecode(int cmdidx,const unsigned char* pdata);
+static asynStatus rtuRead(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32* value);
+static asynStatus rtuWrite(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32 value,epicsTimeStamp* pstamp);
+static asynStatus rtuTransact(Port* pport,Trans* ptrans,asynUser* pasynUser,size_t inpLen);
+static asynStatus rtuRecv(Port* pport,Trans* ptrans,asynUser* pasynUser,size_t inpLen);
+
+static asynStatus dropTty(Port* pport);
+
+static asynStatus ttyWrite(void* drvPvt,asynUser* pasynUser,const char* data,size_t numchars,size_t* nbytesTransfered);
+static asynStatus ttyRead(void* drvPvt,asynUser* pasynUser,char* data,size_t maxchars,size_t* nbytesTransfered,int* eomReason);
+static asynStatus ttyFlush(void* drvPvt,asynUser* pasynUser);
+static asynStatus ttySetInputEos(void* drvPvt,asynUser* pasynUser,const char* eos,int eoslen);
+static asynStatus ttyGetInputEos(void* drvPvt,asynUser* pasynUser,char* eos,int eossize,int* eoslen);
+static asynStatus ttySetOutputEos(void* drvPvt,asynUser* pasynUser,const char* eos,int eoslen);
+static asynStatus ttyGetOutputEos(void* drvPvt,asynUser* pasynUser,char* eos,int eossize,int* eoslen);
+static asynStatus ttySetOption(void* drvPvt,asynUser* pasynUser,const char* key,const char* val);
+static asynStatus ttyGetOption(void* drvPvt,asynUser* pasynUser,const char* key,char* val,int sizeval);
+static asynOctet ttyOctet = {ttyWrite,ttyRead,ttyFlush,NULL,NULL,ttySetInputEos,ttyGetInputEos,ttySetOutputEos,ttyGetOutputEos};
+static asynOption ttyOption = {ttySetOption,ttyGetOption};
 
 
 /* Forward references for asynCommon methods */
@@ -314,6 +1612,16 @@ static asynStatus readInt32(void* ppvt,asynUser* pasynUser,epicsInt32* value);
 static asynStatus writeInt32(void* ppvt,asynUser* pasynUser,epicsInt32 value);
 
 
+/* Forward references for asynInt32Array methods */
+static asynStatus readInt32Array(void* ppvt,asynUser* pasynUser,epicsInt32* value,size_t nelements,size_t* nIn);
+static asynStatus writeInt32Array(void* ppvt,asynUser* pasynUser,epicsInt32* value,size_t nelements);
+
+
+/* Forward references for asynFloat64Array methods */
+static asynStatus readFloat64Array(void* ppvt,asynUser* pasynUser,epicsFloat64* value,size_t nelements,size_t* nIn);
+static asynStatus writeFloat64Array(void* ppvt,asynUser* pasynUser,epicsFloat64* value,size_t nelements);
+
+
 /* Forward references for asynUInt32Digital methods */
 static asynStatus readUInt32(void* ppvt,asynUser* pasynUser,epicsUInt32* value,epicsUInt32 mask);
 static asynStatus writeUInt32(void* ppvt,asynUser* pasynUser,epicsUInt32 value,epicsUInt32 mask);
@@ -327,28 +1635,46 @@ static asynStatus writeUInt32(void* ppvt,asynUser* pasynUser,epicsUInt32 value,e
 /****************************************************************************
  * Define public interface methods
  ****************************************************************************/
-int drvLoveInit(const char* lovPort,const char* serPort,int serAddr)
+int drvLoveInit(const char* lovPort,const char* serPort,int serAddr,const char* protocol)
 {
+    static int hooked = 0;
     asynStatus sts;
     int len,attr;
+    Proto proto;
     Port* plov;
     Serport* pser;
     asynUser* pasynUser;
     asynInt32* pasynInt32;
+    asynInt32Array* pasynInt32Array;
+    asynFloat64Array* pasynFloat64Array;
     asynUInt32Digital* pasynUInt32;
 
-    len = sizeof(Port) + sizeof(Serport) + sizeof(asynInt32) + sizeof(asynUInt32Digital);
+    if( (protocol == NULL) || (strlen(protocol) == 0) || (epicsStrCaseCmp(protocol,"ASCII") == 0) )
+        proto = protoAscii;
+    else if( epicsStrCaseCmp(protocol,"RTU") == 0 )
+        proto = protoRtu;
+    else
+    {
+        printf("drvLoveInit::unsupported protocol \"%s\"\n",protocol);
+        return( -1 );
+    }
+
+    len = sizeof(Port) + sizeof(Serport) + sizeof(asynInt32) + sizeof(asynInt32Array) + sizeof(asynFloat64Array) + sizeof(asynUInt32Digital);
     len += strlen(lovPort) + strlen(serPort) + 2;
     plov = callocMustSucceed(len,sizeof(char),"drvLoveInit");
 
     pser = (Serport*)(plov + 1);
     pasynInt32 = (asynInt32*)(pser + 1);
-    pasynUInt32 = (asynUInt32Digital*)(pasynInt32 + 1);
+    pasynInt32Array = (asynInt32Array*)(pasynInt32 + 1);
+    pasynFloat64Array = (asynFloat64Array*)(pasynInt32Array + 1);
+    pasynUInt32 = (asynUInt32Digital*)(pasynFloat64Array + 1);
     plov->name = (char*)(pasynUInt32 + 1);
     pser->name = plov->name + strlen(lovPort) + 1;
 
     plov->isConn = 0;
+    plov->proto = proto;
     plov->pserport = pser;
+    plov->gap = K_TUNE;
     strcpy(plov->name,lovPort);
 
     sts = initSerialPort(plov,serPort,serAddr);
@@ -359,17 +1685,46 @@ int drvLoveInit(const char* lovPort,const char* serPort,int serAddr)
         return( -1 );
     }
 
-    attr = (pser->canBlock)?(ASYN_MULTIDEVICE|ASYN_CANBLOCK):ASYN_MULTIDEVICE;
-    sts = pasynManager->registerPort(lovPort,attr,pser->autoConnect,0,0);
+    /* The engine takes the tty of an event port before the port exists for asyn */
+    if( pser->ptty && pser->ptty->isEngine && ISNOTOK(engineAdd(plov)) )
+    {
+        printf("drvLoveInit::failure to add %s to the event engine\n",lovPort);
+        pasynManager->freeAsynUser(pser->pasynUser);
+        freeTty(plov);
+        free(plov);
+        return( -1 );
+    }
+
+    attr = (pser->canBlock)?(ASYN_MULTIDEVICE|ASYN_CANBLOCK):ASYN_MULTIDEVICE;
+    sts = pasynManager->registerPort(lovPort,attr,pser->autoConnect,0,0);
     if( ISNOTOK(sts) )
     {
         printf("drvLoveInit::failure to register love port %s\n",lovPort);
-        pasynManager->disconnect(pser->pasynUser);
+        if( pser->ptty == NULL )
+            pasynManager->disconnect(pser->pasynUser);
+        if( plov->bus.isEngine )
+            engineDrop(plov);
         pasynManager->freeAsynUser(pser->pasynUser);
+        freeTty(plov);
         free(plov);
         return( -1 );
     }
 
+    /* Everything the interfaces and the port list walk exists once the port is registered */
+    plov->rampLock = epicsMutexMustCreate();
+    plov->cacheLock = epicsMutexMustCreate();
+    plov->rampWake = epicsEventMustCreate(epicsEventEmpty);
+    plov->instLock = epicsMutexMustCreate();
+    plov->sched.lock = epicsMutexMustCreate();
+    plov->sched.size = len;
+    epicsTimeGetCurrent(&plov->acctStamp);
+    plov->top.stamp = plov->acctStamp;
+
+    /* EOS is set with the first transaction, controllers are read at iocInit */
+    plov->warmup = 1;
+    initGroup(&plov->groups[groupFast],groupFast,K_FASTPOLL);
+    initGroup(&plov->groups[groupSlow],groupSlow,K_SLOWPOLL);
+
     plov->asynCommon.interfaceType = asynCommonType;
     plov->asynCommon.pinterface = &common;
     plov->asynCommon.drvPvt = plov;
@@ -405,6 +1760,53 @@ int drvLoveInit(const char* lovPort,const char* serPort,int serAddr)
         return( -1 );
     }
 
+    sts = pasynManager->registerInterruptSource(lovPort,&plov->asynInt32,&plov->asynInt32Pvt);
+    if( ISNOTOK(sts) )
+    {
+        printf("drvLoveInit::failure to register asynInt32 interrupt source\n");
+        return( -1 );
+    }
+
+    pasynInt32Array->read = readInt32Array;
+    pasynInt32Array->write = writeInt32Array;
+    plov->asynInt32Array.interfaceType = asynInt32ArrayType;
+    plov->asynInt32Array.pinterface = pasynInt32Array;
+    plov->asynInt32Array.drvPvt = plov;
+
+    sts = pasynInt32ArrayBase->initialize(lovPort,&plov->asynInt32Array);
+    if( ISNOTOK(sts) )
+    {
+        printf("drvLoveInit::failure to initialize asynInt32ArrayBase\n");
+        return( -1 );
+    }
+
+    sts = pasynManager->registerInterruptSource(lovPort,&plov->asynInt32Array,&plov->asynInt32ArrayPvt);
+    if( ISNOTOK(sts) )
+    {
+        printf("drvLoveInit::failure to register asynInt32Array interrupt source\n");
+        return( -1 );
+    }
+
+    pasynFloat64Array->read = readFloat64Array;
+    pasynFloat64Array->write = writeFloat64Array;
+    plov->asynFloat64Array.interfaceType = asynFloat64ArrayType;
+    plov->asynFloat64Array.pinterface = pasynFloat64Array;
+    plov->asynFloat64Array.drvPvt = plov;
+
+    sts = pasynFloat64ArrayBase->initialize(lovPort,&plov->asynFloat64Array);
+    if( ISNOTOK(sts) )
+    {
+        printf("drvLoveInit::failure to initialize asynFloat64ArrayBase\n");
+        return( -1 );
+    }
+
+    sts = pasynManager->registerInterruptSource(lovPort,&plov->asynFloat64Array,&plov->asynFloat64ArrayPvt);
+    if( ISNOTOK(sts) )
+    {
+        printf("drvLoveInit::failure to register asynFloat64Array interrupt source\n");
+        return( -1 );
+    }
+
     pasynUInt32->read = readUInt32;
     pasynUInt32->write = writeUInt32;
     plov->asynUInt32.interfaceType = asynUInt32DigitalType;
@@ -418,6 +1820,13 @@ int drvLoveInit(const char* lovPort,const char* serPort,int serAddr)
         return( -1 );
     }
 
+    sts = pasynManager->registerInterruptSource(lovPort,&plov->asynUInt32,&plov->asynUInt32Pvt);
+    if( ISNOTOK(sts) )
+    {
+        printf("drvLoveInit::failure to register asynUInt32Digital interrupt source\n");
+        return( -1 );
+    }
+
     pasynUser = pasynManager->createAsynUser(NULL,NULL);
     if( pasynUser )
     {
@@ -439,17 +1848,51 @@ int drvLoveInit(const char* lovPort,const char* serPort,int serAddr)
         return( -1 );
     }
 
-    pasynManager->exceptionCallbackAdd(pser->pasynUser,exceptCallback);
+    if( pser->ptty == NULL )
+        pasynManager->exceptionCallbackAdd(pser->pasynUser,exceptCallback);
+
+    /* The overview arrays are built on the port thread once per sweep */
+    plov->list.pasynUser = pasynManager->createAsynUser(buildList,NULL);
+    plov->list.pasynUser->userPvt = plov;
+    plov->list.pasynUser->timeout = K_COMTMO;
+    if( ISNOTOK(pasynManager->connectDevice(plov->list.pasynUser,lovPort,-1)) )
+    {
+        printf("drvLoveInit::failure to connect overview with device %s\n",lovPort);
+        return( -1 );
+    }
+
+    /* Scheduling is applied to, and latency probed on, the port thread */
+    plov->sched.pasynUser = pasynManager->createAsynUser(schedPort,NULL);
+    plov->sched.pasynUser->userPvt = plov;
+    plov->sched.pasynUser->timeout = K_COMTMO;
+    if( ISNOTOK(pasynManager->connectDevice(plov->sched.pasynUser,lovPort,-1)) )
+    {
+        printf("drvLoveInit::failure to connect scheduler with device %s\n",lovPort);
+        return( -1 );
+    }
+
+    plov->shot.pasynUser = pasynManager->createAsynUser(takeShot,NULL);
+    plov->shot.pasynUser->userPvt = plov;
+    plov->shot.pasynUser->timeout = K_COMTMO;
+    if( ISNOTOK(pasynManager->connectDevice(plov->shot.pasynUser,lovPort,-1)) )
+    {
+        printf("drvLoveInit::failure to connect snapshot with device %s\n",lovPort);
+        return( -1 );
+    }
 
+    /* Linked and handed to the engine only when fully built */
+    if( plov->bus.isEngine )
+        engineStart(plov);
     if( pports )
         plov->pport = pports;
     pports = plov;
 
-    sts = setDefaultEos(plov);
-    if( ISNOTOK(sts) )
+    if( hooked == 0 )
     {
-        printf("drvLoveInit::failure to set %s EOS\n",lovPort);
-        return( -1 );
+        hooked = 1;
+        snap.lock = epicsMutexMustCreate();
+        snap.done = epicsEventMustCreate(epicsEventEmpty);
+        initHookRegister(initHook);
     }
 
     return( 0 );
@@ -458,20 +1901,39 @@ int drvLoveInit(const char* lovPort,const char* serPort,int serAddr)
 
 int drvLoveConfig(const char* lovPort,int addr,const char* model)
 {
+    int i;
     Port* pport;
 
+    if( (addr < 1) || (addr > K_INSTRMAX) )
+    {
+        printf("drvLoveConfig::illegal addr %d\n",addr);
+        return( -1 );
+    }
+
     for( pport = pports; pport; pport = pport->pport )
         if( epicsStrCaseCmp(pport->name,lovPort) == 0 )
         {
-            if( epicsStrCaseCmp("1600",model) == 0 )
-                pport->instr[addr-1].modidx = model1600;
-            else if( epicsStrCaseCmp("16A",model) == 0 )
-                pport->instr[addr-1].modidx = model16A;
-            else
+            for( i = 0; i < modelCount; ++i )
+                if( epicsStrCaseCmp(loveModelTable[i].pname,model) == 0 )
+                    break;
+            if( i == modelCount )
+            {
+                printf("drvLoveConfig::unsupported model \"%s\"\n",model);
+                return( -1 );
+            }
+            if( (pport->proto == protoRtu) && (loveModelTable[i].isRtu == 0) )
             {
-                printf("drvLoveConfig::unsupported model \"%s\"",model);
+                printf("drvLoveConfig::model \"%s\" does not support Modbus RTU\n",model);
                 return( -1 );
             }
+
+            /* Once the IOC runs the port thread owns the table */
+            if( interruptAccept )
+                return( changeInstr(pport,addr,i) );
+
+            pport->instr[addr-1].modidx = (Model)i;
+            pport->instr[addr-1].isConfig = 1;
+            checkLoad(pport);
             return( 0 );
         }
 
@@ -480,500 +1942,6160 @@ int drvLoveConfig(const char* lovPort,int addr,const char* model)
 }
 
 
-/****************************************************************************
- * Define private interface suppport methods
- ****************************************************************************/
-static asynStatus initSerialPort(Port* plov,const char* serPort,int serAddr)
-{
-    asynStatus sts;
-    asynUser* pasynUser;
-    Serport* pser = plov->pserport;
-    asynInterface* pasynIface;
 
-    pasynUser = pasynManager->createAsynUser(NULL,NULL);
-    if( pasynUser == NULL )
-        return( asynError );
+int drvLoveRemove(const char* lovPort,int addr)
+{
+    Port* pport;
 
-    sts = pasynManager->connectDevice(pasynUser,serPort,serAddr);
-    if( ISNOTOK(sts) )
+    if( (addr < 1) || (addr > K_INSTRMAX) )
     {
-        printf("initSerialPort::failure to connect with device %s @ %d\n",serPort,serAddr);
-        pasynManager->freeAsynUser(pasynUser);
-        return( asynError );
+        printf("drvLoveRemove::illegal addr %d\n",addr);
+        return( -1 );
     }
 
-    sts = pasynManager->isMultiDevice(pasynUser,serPort,&pser->multiDevice);
-    if( ISNOTOK(sts) )
+    for( pport = pports; pport; pport = pport->pport )
+        if( epicsStrCaseCmp(pport->name,lovPort) == 0 )
+            break;
+    if( pport == NULL )
     {
-        printf("initSerialPort::failure to determine if %s @ %d is multi device\n",serPort,serAddr);
-        pasynManager->disconnect(pasynUser);
-        pasynManager->freeAsynUser(pasynUser);
-        return( asynError );
+        printf("drvLoveRemove::failure to locate port %s\n",lovPort);
+        return( -1 );
     }
 
-    if(pser->multiDevice)
+    if( pport->instr[addr-1].isConfig == 0 )
     {
-        printf("initSerialPort::%s cannot be configured as multi device\n",serPort);
-        pasynManager->disconnect(pasynUser);
-        pasynManager->freeAsynUser(pasynUser);
-        return( asynError );
+        printf("drvLoveRemove::%s addr %d is not configured\n",pport->name,addr);
+        return( -1 );
     }
 
-    sts = pasynManager->canBlock(pasynUser,&pser->canBlock);
-    if( ISNOTOK(sts) )
-    {
-        printf("initSerialPort::failure to determine if %s @ %d can block\n",serPort,serAddr);
-        pasynManager->disconnect(pasynUser);
-        pasynManager->freeAsynUser(pasynUser);
-        return( asynError );
-    }
+    if( interruptAccept )
+        return( changeInstr(pport,addr,-1) );
 
-    sts = pasynManager->isAutoConnect(pasynUser,&pser->autoConnect);
-    if( ISNOTOK(sts) )
+    pport->instr[addr-1].isConfig = 0;
+    checkLoad(pport);
+    return( 0 );
+}
+
+int drvLoveDownload(const char* file,int wait)
+{
+    FILE* fp;
+    int i,j,line,count,nports;
+    long value;
+    char buf[K_LINEMAX],name[K_LINEMAX],reg[K_LINEMAX],saddr[K_LINEMAX];
+    Port* pport;
+    Batch* pbatch;
+    Batch** pbatches;
+
+    if( file == NULL )
     {
-        printf("initSerialPort::failure to determine if %s @ %d is autoconnect\n",serPort,serAddr);
-        pasynManager->disconnect(pasynUser);
-        pasynManager->freeAsynUser(pasynUser);
-        return( asynError );
+        printf("drvLoveDownload::missing file name\n");
+        return( -1 );
     }
 
-    pasynIface = pasynManager->findInterface(pasynUser,asynOctetType,1);
-    if( pasynIface )
+    if( pports == NULL )
     {
-        pser->pasynOctet = (asynOctet*)pasynIface->pinterface;
-        pser->pasynOctetPvt = pasynIface->drvPvt;
+        printf("drvLoveDownload::no ports configured\n");
+        return( -1 );
     }
-    else
+
+    fp = fopen(file,"r");
+    if( fp == NULL )
     {
-        printf("initSerialPort::failure to find interface %s\n",asynOctetType);
-        pasynManager->disconnect(pasynUser);
-        pasynManager->freeAsynUser(pasynUser);
-        return( asynError );
+        printf("drvLoveDownload::failure to open %s\n",file);
+        return( -1 );
     }
 
-    pser->addr = serAddr;
-    pser->pasynUser = pasynUser;
-    pser->isConn = 1;
-    strcpy(pser->name,serPort);
-    pasynUser->userPvt = plov;
-    pasynUser->timeout = K_COMTMO;
+    for( nports = 0, pport = pports; pport; pport = pport->pport )
+        ++nports;
+    pbatches = callocMustSucceed(nports,sizeof(Batch*),"drvLoveDownload");
 
-    return( asynSuccess );
-}
+    count = 0;
+    for( line = 1; fgets(buf,sizeof(buf),fp); ++line )
+    {
+        if( (buf[0] == '#') || (sscanf(buf,"%127s %127s %127s %ld",name,saddr,reg,&value) != 4) )
+            continue;
 
+        for( i = 0, pport = pports; pport; pport = pport->pport, ++i )
+            if( epicsStrCaseCmp(pport->name,name) == 0 )
+                break;
 
-static asynStatus evalMessage(size_t* pcount,char* pinp,asynUser* pasynUser,char* pout)
-{
-    size_t len;
-    asynStatus sts;
+        if( pport == NULL )
+        {
+            printf("drvLoveDownload::%s line %d unknown port %s\n",file,line,name);
+            continue;
+        }
 
-    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::evalMessage\n");
+        if( pbatches[i] == NULL )
+            pbatches[i] = createBatch(pport,batchDownload);
 
-    /* Evaluate message contents,length,... */
-    if( *pinp != '\002' )
-    {
-        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::evalMessage start char missing\n");
-        return( asynError );
+        if( ISNOTOK(addStep(pbatches[i],opWrite,line,(int)strtol(saddr,NULL,0),findCommand(reg),(epicsInt32)value)) )
+            printf("drvLoveDownload::%s line %d rejected \"%s %s\"\n",file,line,saddr,reg);
+        ++count;
     }
+    fclose(fp);
 
-    if( *pcount < 7 )
-    {
-        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::evalMessage message length (%d) error\n",*pcount);
-        return( asynError );
-    }
+    if( count == 0 )
+        printf("drvLoveDownload::no entries in %s\n",file);
 
-    /* Process message given size */
-    if( *pcount == 7 )
+    for( i = 0; i < nports; ++i )
     {
-        int errNum;
-
-        len = *pcount - 4;      /* Minus STX, FILTER, ADDR */
-        errNum = atol( pinp + 5 );
-        sts = asynError;
+        if( pbatches[i] == NULL )
+            continue;
 
-        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::evalMessage error message received \"%s\"\n",errCodes[errNum]);
+        /* Hold the batch, a later download releases it from pport->pbatch */
+        holdBatch(pbatches[i]);
+        if( ISNOTOK(startBatch(pbatches[i])) )
+        {
+            printf("drvLoveDownload::failure to start download on %s\n",pbatches[i]->pport->name);
+            freeBatch(pbatches[i]);
+            freeBatch(pbatches[i]);
+            pbatches[i] = NULL;
+        }
     }
-    else
-    {
-        unsigned int  csMsg;
-        unsigned char csPos, csVal;
 
-        len   = *pcount - 3;    /* Minus STX and CHECKSUM */
-        csPos = *pcount - 2;    /* Checksum position */
-        calcChecksum(len,&pinp[1],&csVal);
-        sscanf(&pinp[csPos],"%2x",&csMsg);
+    for( i = 0; wait && (i < nports); ++i )
+    {
+        pbatch = pbatches[i];
+        if( pbatch == NULL )
+            continue;
 
-        if( (unsigned int)csMsg != (unsigned int)csVal )
+        epicsEventMustWait(pbatch->done);
+        printf("%s: %d entries, %d done, %d skipped, %d failed\n",pbatch->pport->name,pbatch->count,pbatch->nDone,pbatch->nSkipped,pbatch->nFailed);
+        for( j = 0; j < pbatch->count; ++j )
         {
-            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::evalMessage checksum failed\n");
-            return( asynError );
+            Step* pstep = &pbatch->psteps[j];
+            printf("    line %d addr %d %s %d %s\n",pstep->line,pstep->addr,(pstep->cmdidx < 0)?"?":CmdTable[pstep->cmdidx].pname,pstep->value,stepNames[pstep->sts]);
         }
-
-        len = len - 3;
-        sts = asynSuccess;
-
-        asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::evalMessage message received\n");
     }
 
-    memcpy(pout,&pinp[4],len);
-    pout[len] = '\0';
-    *pcount = len;
+    for( i = 0; i < nports; ++i )
+        freeBatch(pbatches[i]);
+    free(pbatches);
 
-    return( sts );
+    return( (count)?0:-1 );
 }
 
 
-static void calcChecksum(size_t count,const char* pdata,unsigned char* pcs)
+int drvLoveRestore(const char* lovPort)
 {
-    int i;
-    unsigned long cs;
-
-    cs = 0;
-    for( i = 0; i < count; ++i )
-        cs += pdata[i];
-    *pcs = (unsigned char)(cs & 0xFF);
+    Port* pport;
 
-    return;
-}
+    if( interruptAccept )
+    {
+        printf("drvLoveRestore::must be called before iocInit\n");
+        return( -1 );
+    }
 
+    if( lovPort == NULL )
+    {
+        printf("drvLoveRestore::missing port name\n");
+        return( -1 );
+    }
 
-static asynStatus setDefaultEos(Port* plov)
-{
-    asynStatus sts;
-    char inpEos = '\006';
-    char outEos = '\003';
-    Serport* pser = plov->pserport;
+    for( pport = pports; pport; pport = pport->pport )
+        if( epicsStrCaseCmp(pport->name,lovPort) == 0 )
+            break;
 
-    sts = pser->pasynOctet->setInputEos(pser->pasynOctetPvt,pser->pasynUser,&inpEos,1);
-    if( ISOK(sts) )
-        printf("drvLove::setDefaultEos Input EOS set to \\0%d\n",inpEos);
-    else
-        printf("drvLove::setDefaultEos Input EOS set failed to \\0%d\n",inpEos);
+    if( pport == NULL )
+    {
+        printf("drvLoveRestore::failure to locate port %s\n",lovPort);
+        return( -1 );
+    }
 
-    sts = pser->pasynOctet->setOutputEos(pser->pasynOctetPvt,pser->pasynUser,&outEos,1);
-    if( ISOK(sts) )
-        printf("drvLove::setDefaultEos Output EOS set to \\0%d\n",outEos);
-    else
-        printf("drvLove::setDefaultEos Output EOS set failed to \\0%d\n",outEos);
+    pport->restore = 1;
 
-    return( sts );
+    return( 0 );
 }
 
 
-static void exceptCallback(asynUser* pasynUser,asynException exception)
+int drvLoveWarmup(const char* lovPort)
 {
-    asynStatus sts;
-    int isConn;
-    Port* plov = pasynUser->userPvt;
-    Serport* pser = plov->pserport;
-
-    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::exceptionCallback\n");
+    Port* pport;
+    Batch* pbatch;
 
-    sts = pasynManager->isConnected(pasynUser,&isConn);
-    if( ISNOTOK(sts) )
+    for( pport = pports; pport; pport = pport->pport )
     {
-        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::exceptionCallback failure to determine if %s is connected to %s\n",plov->name,pser->name);
-        return;
+        if( lovPort && strlen(lovPort) && epicsStrCaseCmp(pport->name,lovPort) )
+            continue;
+
+        pbatch = pport->pbatch[batchWarmup];
+        if( epicsAtomicGetIntT(&pport->busy[batchWarmup]) )
+            printf("%s: warm-up busy, %d of %d registers done, %d failed\n",pport->name,pport->params[parWarmDone],pport->params[parWarmTotal],pport->params[parWarmFailed]);
+        else if( interruptAccept == 0 )
+            printf("%s: warm-up starts at iocInit\n",pport->name);
+        else if( ISNOTOK(startWarmup(pport)) )
+            printf("%s: failure to start warm-up\n",pport->name);
+        else
+        {
+            if( pbatch )
+                printf("%s: previous warm-up %d of %d registers done, %d failed\n",pport->name,pport->params[parWarmDone],pport->params[parWarmTotal],pport->params[parWarmFailed]);
+            printf("%s: warm-up started\n",pport->name);
+        }
+        if( lovPort && strlen(lovPort) )
+            return( 0 );
     }
 
-    if( isConn )
-        return;
-
-    if( plov->isConn == 0 )
-        return;
+    if( lovPort && strlen(lovPort) )
+    {
+        printf("drvLoveWarmup::failure to locate port %s\n",lovPort);
+        return( -1 );
+    }
 
-    plov->isConn = 0;
-    pasynManager->exceptionDisconnect(plov->pasynUser);
+    return( 0 );
 }
 
 
-static asynStatus lockPort(void* drvPvt,asynUser* pasynUser)
+int drvLoveCache(const char* lovPort,const char* file,double period)
 {
-    asynStatus sts;
-    Port* plov = (Port*)drvPvt;
-    Serport* pser = plov->pserport;
-
-    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::lockPort\n");
+    Port* pport;
+    Cache* pcache;
 
-    sts = pasynManager->lockPort(pser->pasynUser);
-    if( ISNOTOK(sts) )
-        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pser->name,pser->pasynUser->errorMessage);
+    if( interruptAccept )
+    {
+        printf("drvLoveCache::must be called before iocInit\n");
+        return( -1 );
+    }
 
-    return( sts );
-}
+    if( (lovPort == NULL) || (file == NULL) || (strlen(file) == 0) )
+    {
+        printf("drvLoveCache::missing port name or file\n");
+        return( -1 );
+    }
 
+    for( pport = pports; pport; pport = pport->pport )
+        if( epicsStrCaseCmp(pport->name,lovPort) == 0 )
+            break;
 
-static asynStatus unlockPort(void* drvPvt,asynUser* pasynUser)
+    if( pport == NULL )
+    {
+        printf("drvLoveCache::failure to locate port %s\n",lovPort);
+        return( -1 );
+    }
+
+    if( pport->pcache )
+    {
+        printf("drvLoveCache::cache already configured for port %s\n",lovPort);
+        return( -1 );
+    }
+
+    pcache = callocMustSucceed(1,sizeof(Cache) + (2 * strlen(file)) + 6,"drvLoveCache");
+    pcache->file = (char*)(pcache + 1);
+    pcache->tmpFile = pcache->file + strlen(file) + 1;
+    strcpy(pcache->file,file);
+    sprintf(pcache->tmpFile,"%s.tmp",file);
+    pcache->period = (period > 0.0)?period:K_CACHETMO;
+    pcache->snapped = epicsEventMustCreate(epicsEventEmpty);
+
+    pcache->pasynUser = pasynManager->createAsynUser(snapCache,NULL);
+    pcache->pasynUser->userPvt = pport;
+    pcache->pasynUser->timeout = K_COMTMO;
+    if( ISNOTOK(pasynManager->connectDevice(pcache->pasynUser,pport->name,-1)) )
+    {
+        printf("drvLoveCache::failure to connect to port %s\n",lovPort);
+        pasynManager->freeAsynUser(pcache->pasynUser);
+        epicsEventDestroy(pcache->snapped);
+        free(pcache);
+        return( -1 );
+    }
+
+    pport->pcache = pcache;
+
+    return( 0 );
+}
+
+
+int drvLovePoll(const char* lovPort,double fast,double slow)
+{
+    Port* pport;
+
+    if( interruptAccept )
+    {
+        printf("drvLovePoll::must be called before iocInit\n");
+        return( -1 );
+    }
+
+    if( (fast < 0.0) || (slow < 0.0) )
+    {
+        printf("drvLovePoll::illegal period\n");
+        return( -1 );
+    }
+
+    for( pport = pports; pport; pport = pport->pport )
+        if( lovPort && (epicsStrCaseCmp(pport->name,lovPort) == 0) )
+            break;
+
+    if( pport == NULL )
+    {
+        printf("drvLovePoll::failure to locate port %s\n",(lovPort)?lovPort:"");
+        return( -1 );
+    }
+
+    pport->groups[groupFast].period = fast;
+    pport->groups[groupSlow].period = slow;
+    pport->isOverload = 0;
+    checkLoad(pport);
+
+    return( 0 );
+}
+
+
+int drvLoveHistory(const char* lovPort,const char* file,int depth)
+{
+    int i;
+    Port* pport;
+    History* phist;
+    epicsUInt32 size;
+
+    if( interruptAccept )
+    {
+        printf("drvLoveHistory::must be called before iocInit\n");
+        return( -1 );
+    }
+
+    if( (lovPort == NULL) || (file == NULL) || (strlen(file) == 0) )
+    {
+        printf("drvLoveHistory::missing port name or file\n");
+        return( -1 );
+    }
+
+    for( pport = pports; pport; pport = pport->pport )
+        if( epicsStrCaseCmp(pport->name,lovPort) == 0 )
+            break;
+
+    if( pport == NULL )
+    {
+        printf("drvLoveHistory::failure to locate port %s\n",lovPort);
+        return( -1 );
+    }
+
+    if( pport->phist )
+    {
+        printf("drvLoveHistory::history already configured for port %s\n",lovPort);
+        return( -1 );
+    }
+
+    /* A power of two keeps the slot of a sequence number stable across wrap */
+    for( size = 1; size < (epicsUInt32)((depth > 0)?depth:K_HISTDEP); size <<= 1 )
+        ;
+
+    phist = callocMustSucceed(1,sizeof(History) + strlen(file) + 1,"drvLoveHistory");
+    phist->file = (char*)(phist + 1);
+    strcpy(phist->file,file);
+    phist->depth = size;
+    phist->size = sizeof(HistHdr) + (size * sizeof(HistRec));
+
+    phist->pdata = mapHistory(file,phist->size);
+    if( phist->pdata == NULL )
+    {
+        printf("drvLoveHistory::failure to map %s\n",file);
+        free(phist);
+        return( -1 );
+    }
+
+    phist->phdr = (HistHdr*)phist->pdata;
+    phist->precs = (HistRec*)(phist->phdr + 1);
+    phist->lock = epicsMutexMustCreate();
+
+    /* Readers ignore the file until the magic number is in place */
+    memset(phist->pdata,0,phist->size);
+    phist->phdr->version = K_HISTVER;
+    phist->phdr->hdrSize = sizeof(HistHdr);
+    phist->phdr->recSize = sizeof(HistRec);
+    phist->phdr->depth = phist->depth;
+    phist->phdr->cmdCount = (epicsUInt32)cmdCount;
+    phist->phdr->keyEvery = K_HISTKEY;
+    for( i = 0; i < cmdCount; ++i )
+        strncpy(phist->phdr->cmds[i],CmdTable[i].pname,K_HISTNAME - 1);
+    epicsAtomicWriteMemoryBarrier();
+    phist->phdr->magic = K_HISTMAG;
+
+    pport->phist = phist;
+
+    return( 0 );
+}
+
+
+int drvLoveVerify(const char* lovPort,int enable)
+{
+    Port* pport;
+
+    for( pport = pports; pport; pport = pport->pport )
+    {
+        if( lovPort && strlen(lovPort) && epicsStrCaseCmp(pport->name,lovPort) )
+            continue;
+
+        pport->verify = (enable != 0);
+        printf("drvLoveVerify::%s write verification %s\n",pport->name,(pport->verify)?"enabled":"disabled");
+        if( lovPort && strlen(lovPort) )
+            return( 0 );
+    }
+
+    if( lovPort && strlen(lovPort) )
+    {
+        printf("drvLoveVerify::failure to locate port %s\n",lovPort);
+        return( -1 );
+    }
+
+    return( 0 );
+}
+
+
+int drvLoveDemand(const char* lovPort,double idle)
+{
+    Port* pport;
+
+    if( idle < 0.0 )
+    {
+        printf("drvLoveDemand::illegal idle period\n");
+        return( -1 );
+    }
+
+    for( pport = pports; pport; pport = pport->pport )
+    {
+        if( lovPort && strlen(lovPort) && epicsStrCaseCmp(pport->name,lovPort) )
+            continue;
+
+        pport->idle = idle;
+        if( idle > 0.0 )
+            printf("drvLoveDemand::%s unwatched controllers polled every %.1f sec\n",pport->name,idle);
+        else
+            printf("drvLoveDemand::%s demand-driven polling disabled\n",pport->name);
+        if( lovPort && strlen(lovPort) )
+            return( 0 );
+    }
+
+    if( lovPort && strlen(lovPort) )
+    {
+        printf("drvLoveDemand::failure to locate port %s\n",lovPort);
+        return( -1 );
+    }
+
+    return( 0 );
+}
+
+int drvLoveStale(const char* lovPort,double seconds)
+{
+    Port* pport;
+
+    if( seconds < 0.0 )
+    {
+        printf("drvLoveStale::illegal threshold\n");
+        return( -1 );
+    }
+
+    for( pport = pports; pport; pport = pport->pport )
+    {
+        if( lovPort && strlen(lovPort) && epicsStrCaseCmp(pport->name,lovPort) )
+            continue;
+
+        pport->stale = seconds;
+        if( seconds > 0.0 )
+            printf("drvLoveStale::%s values older than %.1f sec are in alarm\n",pport->name,seconds);
+        else
+            printf("drvLoveStale::%s staleness alarm disabled\n",pport->name);
+        if( lovPort && strlen(lovPort) )
+            return( 0 );
+    }
+
+    if( lovPort && strlen(lovPort) )
+    {
+        printf("drvLoveStale::failure to locate port %s\n",lovPort);
+        return( -1 );
+    }
+
+    return( 0 );
+}
+
+int drvLoveGap(const char* lovPort,double seconds)
+{
+    Port* pport;
+
+    if( (seconds < 0.0) || (seconds > K_COMTMO) )
+    {
+        printf("drvLoveGap::illegal gap\n");
+        return( -1 );
+    }
+
+    for( pport = pports; pport; pport = pport->pport )
+    {
+        if( lovPort && strlen(lovPort) && epicsStrCaseCmp(pport->name,lovPort) )
+            continue;
+
+        /* Frames already in the gap keep the old one */
+        pport->gap = seconds;
+        if( pport->bus.isEngine )
+        {
+            epicsMutexMustLock(engine.lock);
+            pport->bus.gap = seconds;
+            epicsMutexUnlock(engine.lock);
+        }
+        checkLoad(pport);
+        printf("drvLoveGap::%s %.3f sec before each ASCII frame\n",pport->name,seconds);
+        if( lovPort && strlen(lovPort) )
+            return( 0 );
+    }
+
+    if( lovPort && strlen(lovPort) )
+    {
+        printf("drvLoveGap::failure to locate port %s\n",lovPort);
+        return( -1 );
+    }
+
+    return( 0 );
+}
+
+int drvLoveSched(const char* lovPort,int priority,int fifo,const char* cpus,int lock)
+{
+    Port* pport;
+    Sched* psched;
+
+    if( (lovPort == NULL) || (strlen(lovPort) == 0) )
+    {
+        printf("drvLoveSched::usage drvLoveSched( lovPort, priority, fifo, cpus, lock )\n");
+        return( -1 );
+    }
+
+    if( (priority < 0) || (priority > epicsThreadPriorityMax) )
+    {
+        printf("drvLoveSched::illegal priority %d\n",priority);
+        return( -1 );
+    }
+
+    if( interruptAccept )
+    {
+        printf("drvLoveSched::must be called before iocInit\n");
+        return( -1 );
+    }
+
+#ifndef USE_SCHED
+    if( fifo || (cpus && strlen(cpus)) )
+        printf("drvLoveSched::SCHED_FIFO and CPU affinity not supported on this host, ignored\n");
+    fifo = 0;
+    cpus = NULL;
+#endif
+#ifndef USE_MMAP
+    if( lock )
+        printf("drvLoveSched::memory locking not supported on this host, ignored\n");
+    lock = 0;
+#endif
+
+    for( pport = pports; pport; pport = pport->pport )
+    {
+        if( epicsStrCaseCmp(pport->name,lovPort) )
+            continue;
+
+        psched = &pport->sched;
+        if( parseCpus(psched,cpus) )
+        {
+            printf("drvLoveSched::illegal CPU list \"%s\"\n",cpus);
+            return( -1 );
+        }
+
+        psched->prio = priority;
+        psched->isFifo = (fifo != 0);
+        psched->isLock = (lock != 0);
+        return( 0 );
+    }
+
+    printf("drvLoveSched::failure to locate port %s\n",lovPort);
+    return( -1 );
+}
+
+int drvLoveBench(const char* lovPort,int addr,const char* command,int count,double window,const char* gaps,const char* timeouts)
+{
+    int i,j,k,n,cmdidx,nGaps,nTmos,nAddrs;
+    int addrs[K_INSTRMAX];
+    double gapList[K_BENCHMAX],tmoList[K_BENCHMAX];
+    Port* pport;
+    Bench* pbench;
+    BenchRes* pres;
+
+    if( (lovPort == NULL) || (strlen(lovPort) == 0) )
+    {
+        printf("drvLoveBench::usage drvLoveBench( lovPort, addr, command, count, window, gaps, timeouts )\n");
+        return( -1 );
+    }
+
+    for( pport = pports; pport; pport = pport->pport )
+        if( epicsStrCaseCmp(pport->name,lovPort) == 0 )
+            break;
+    if( pport == NULL )
+    {
+        printf("drvLoveBench::failure to locate port %s\n",lovPort);
+        return( -1 );
+    }
+
+    cmdidx = findCommand((command && strlen(command))?command:"Value");
+    if( cmdidx < 0 )
+    {
+        printf("drvLoveBench::unknown command %s\n",command);
+        return( -1 );
+    }
+
+    nGaps = parseList(gaps,gapList,-1.0);
+    nTmos = parseList(timeouts,tmoList,K_COMTMO);
+    if( (nGaps < 0) || (nTmos < 0) )
+    {
+        printf("drvLoveBench::illegal gap or timeout list\n");
+        return( -1 );
+    }
+
+    /* Addresses whose model has no read for the register are left out */
+    for( nAddrs = 0, i = 1; i <= K_INSTRMAX; ++i )
+    {
+        Instr* pinfo = &pport->instr[i - 1];
+
+        if( (pinfo->isConfig == 0) || (addr && (addr != i)) )
+            continue;
+        if( (pport->proto == protoAscii) && (loveRegTable[pinfo->modidx][cmdidx].read == NULL) )
+            continue;
+        if( (pport->proto == protoRtu) && (CmdTable[cmdidx].reg < 0) )
+            continue;
+        addrs[nAddrs++] = i;
+    }
+    if( nAddrs == 0 )
+    {
+        printf("drvLoveBench::%s no configured controller reads %s\n",pport->name,CmdTable[cmdidx].pname);
+        return( -1 );
+    }
+
+    count = (count > 0)?count:K_BENCHCNT;
+    pbench = createBench(pport,cmdidx,count,(window > 0.0)?window:K_BENCHWIN,nAddrs * nGaps * nTmos);
+    for( n = 0, i = 0; i < nAddrs; ++i )
+        for( j = 0; j < nGaps; ++j )
+            for( k = 0; k < nTmos; ++k, ++n )
+            {
+                pbench->pres[n].addr = addrs[i];
+                pbench->pres[n].gap = gapList[j];
+                pbench->pres[n].timeout = tmoList[k];
+            }
+
+    if( ISNOTOK(queuePort(pport,pbench->pasynUser,runBench,asynQueuePriorityLow)) )
+    {
+        printf("drvLoveBench::%s failure to queue request\n",pport->name);
+        freeBench(pbench);
+        return( -1 );
+    }
+
+    printf("drvLoveBench::%s %s, %d transactions per setting, %.3f sec bursts\n",pport->name,CmdTable[cmdidx].pname,count,pbench->window);
+    epicsEventMustWait(pbench->done);
+
+    printf("    addr model    gap    tmo     n   err retry   tps/sec     min     p50     p90     p99     max msec\n");
+    for( i = 0; i < pbench->nCells; ++i )
+    {
+        pres = &pbench->pres[i];
+        printf("    %4d %-5s %6.3f %6.3f %5d %5d %5d %9.1f %7.2f %7.2f %7.2f %7.2f %7.2f\n",pres->addr,
+               loveModelTable[pport->instr[pres->addr - 1].modidx].pname,pres->gap,pres->timeout,pres->count,pres->nErrors,pres->retries,
+               (pres->busy > 0.0)?(pres->count / pres->busy):0.0,pres->min * 1000.0,pres->p50 * 1000.0,pres->p90 * 1000.0,pres->p99 * 1000.0,pres->max * 1000.0);
+    }
+
+    freeBench(pbench);
+    return( 0 );
+}
+
+int drvLoveSnapshot(const char* registers,int wait)
+{
+    int i,n,cmdidx;
+    int cmds[K_SNAPREG];
+    char name[K_LINEMAX];
+    const char* p;
+    Port* pport;
+    Shot* pshot;
+
+    if( pports == NULL )
+    {
+        printf("drvLoveSnapshot::no ports configured\n");
+        return( -1 );
+    }
+
+    for( n = 0, p = registers; p && *p; ++n )
+    {
+        for( i = 0; *p && (*p != ',') && (i < (K_LINEMAX - 1)); )
+            name[i++] = *p++;
+        name[i] = '\0';
+        if( *p == ',' )
+            ++p;
+
+        cmdidx = findCommand(name);
+        if( (cmdidx < 0) || (n == K_SNAPREG) )
+        {
+            printf("drvLoveSnapshot::illegal register \"%s\", at most %d registers\n",name,K_SNAPREG);
+            return( -1 );
+        }
+        cmds[n] = cmdidx;
+    }
+
+    if( n )
+    {
+        epicsMutexMustLock(snap.lock);
+        if( snap.pending )
+        {
+            epicsMutexUnlock(snap.lock);
+            printf("drvLoveSnapshot::snapshot in progress, registers unchanged\n");
+            return( -1 );
+        }
+        memcpy(snap.cmds,cmds,n * sizeof(int));
+        snap.nCmds = n;
+        epicsMutexUnlock(snap.lock);
+    }
+
+    if( ISNOTOK(startSnapshot()) )
+    {
+        printf("drvLoveSnapshot::failure to start snapshot\n");
+        return( -1 );
+    }
+    if( wait == 0 )
+        return( 0 );
+
+    epicsEventMustWait(snap.done);
+    printf("Snapshot %d, %d samples, skew %.6f sec\n",snap.seq,snap.nSamples,(snap.nSamples)?epicsTimeDiffInSeconds(&snap.last,&snap.first):0.0);
+    for( pport = pports; pport; pport = pport->pport )
+    {
+        pshot = &pport->shot;
+        printf("    %s: %d samples, %d failed\n",pport->name,pshot->count,pshot->nFailed);
+        for( i = 0; i < pshot->count; ++i )
+            if( pshot->times[i] < 0.0 )
+                printf("        addr %d %-6s failed\n",pshot->addrs[i],CmdTable[pshot->cmds[i]].pname);
+            else
+                printf("        addr %d %-6s %g at %.6f sec\n",pshot->addrs[i],CmdTable[pshot->cmds[i]].pname,pshot->values[i],pshot->times[i]);
+    }
+
+    return( 0 );
+}
+
+int drvLoveSoak(const char* lovPort,double period,double hours,double faults,int churn)
+{
+    int addr;
+    Port* pport;
+    Soak* psoak;
+    asynInterface* pasynInterface;
+
+    for( pport = pports; pport; pport = pport->pport )
+        if( lovPort && (epicsStrCaseCmp(pport->name,lovPort) == 0) )
+            break;
+    if( pport == NULL )
+    {
+        printf("drvLoveSoak::failure to locate port %s\n",(lovPort)?lovPort:"");
+        return( -1 );
+    }
+
+    if( (faults < 0.0) || (faults > 1.0) || (hours < 0.0) || (churn < 0) )
+    {
+        printf("drvLoveSoak::illegal fault fraction, duration or churn\n");
+        return( -1 );
+    }
+
+    psoak = pport->psoak;
+    if( period <= 0.0 )
+    {
+        if( (psoak == NULL) || (psoak->isRunning == 0) )
+        {
+            printf("drvLoveSoak::%s no soak running\n",pport->name);
+            return( -1 );
+        }
+        psoak->period = 0.0;
+        epicsEventSignal(psoak->wake);
+        return( 0 );
+    }
+
+    if( psoak && psoak->isRunning )
+    {
+        printf("drvLoveSoak::%s soak already running\n",pport->name);
+        return( -1 );
+    }
+
+    /* Instances are churned on the first configured controller */
+    for( addr = 1; addr <= K_INSTRMAX; ++addr )
+        if( pport->instr[addr - 1].isConfig )
+            break;
+    if( churn && (addr > K_INSTRMAX) )
+    {
+        printf("drvLoveSoak::%s no configured controller to churn\n",pport->name);
+        return( -1 );
+    }
+
+    if( psoak == NULL )
+    {
+        psoak = callocMustSucceed(1,sizeof(Soak),"drvLoveSoak");
+        psoak->lock = epicsMutexMustCreate();
+        psoak->wake = epicsEventMustCreate(epicsEventEmpty);
+        psoak->pasynUser = pasynManager->createAsynUser(NULL,NULL);
+        if( ISNOTOK(pasynManager->connectDevice(psoak->pasynUser,pport->name,(churn)?addr:1)) )
+        {
+            printf("drvLoveSoak::failure to connect to port %s\n",pport->name);
+            pasynManager->freeAsynUser(psoak->pasynUser);
+            epicsEventDestroy(psoak->wake);
+            epicsMutexDestroy(psoak->lock);
+            free(psoak);
+            return( -1 );
+        }
+        pasynInterface = pasynManager->findInterface(psoak->pasynUser,asynDrvUserType,1);
+        psoak->pdrvUser = (asynDrvUser*)pasynInterface->pinterface;
+        psoak->drvPvt = pasynInterface->drvPvt;
+        pport->psoak = psoak;
+    }
+
+    epicsMutexMustLock(psoak->lock);
+    psoak->period = period;
+    psoak->hours = hours;
+    psoak->faultAcc = 0.0;
+    psoak->churn = churn;
+    psoak->nLat = 0;
+    psoak->nTrans = psoak->nErrors = psoak->nFaults = psoak->nReconnects = psoak->nChurn = 0;
+    psoak->nWindows = psoak->nWarnings = 0;
+    psoak->p99 = 0.0;
+    epicsTimeGetCurrent(&psoak->start);
+    psoak->isRunning = 1;
+    psoak->faults = faults;
+    epicsMutexUnlock(psoak->lock);
+    soakPublish(pport);
+
+    epicsThreadMustCreate("loveSoak",epicsThreadPriorityLow,epicsThreadGetStackSize(epicsThreadStackSmall),soakThread,pport);
+    if( hours > 0.0 )
+        printf("drvLoveSoak::%s sampling every %.1f sec for %.1f hours, %.1f%% faults, %d instances per period\n",pport->name,period,hours,faults * 100.0,churn);
+    else
+        printf("drvLoveSoak::%s sampling every %.1f sec until stopped, %.1f%% faults, %d instances per period\n",pport->name,period,faults * 100.0,churn);
+
+    return( 0 );
+}
+
+
+int drvLoveTop(const char* lovPort,int count,int reset)
+{
+    int i,n,addr,cmdidx;
+    double elapsed;
+    epicsTimeStamp now;
+    Port* pport;
+    Inst* pinst;
+    Rank* pranks;
+    Rank cmds[K_CMDMAX];
+
+    for( pport = pports; pport; pport = pport->pport )
+        if( lovPort && (epicsStrCaseCmp(pport->name,lovPort) == 0) )
+            break;
+
+    if( pport == NULL )
+    {
+        printf("drvLoveTop::failure to locate port %s\n",(lovPort)?lovPort:"");
+        return( -1 );
+    }
+
+    if( count <= 0 )
+        count = 10;
+
+    epicsTimeGetCurrent(&now);
+    elapsed = epicsTimeDiffInSeconds(&now,&pport->acctStamp);
+    printf("%s bus time over the last %.1f sec\n",pport->name,elapsed);
+
+    /* Each controller register */
+    memset(cmds,0,sizeof(cmds));
+    pranks = callocMustSucceed(K_INSTRMAX * cmdCount,sizeof(Rank),"drvLoveTop");
+    for( n = 0, addr = 1; addr <= K_INSTRMAX; ++addr )
+        for( cmdidx = 0; cmdidx < cmdCount; ++cmdidx )
+        {
+            Acct* pacct = &pport->instr[addr - 1].regs[cmdidx].acct;
+
+            if( pacct->count == 0 )
+                continue;
+            pranks[n].addr = addr;
+            pranks[n].cmdidx = cmdidx;
+            pranks[n++].acct = *pacct;
+
+            cmds[cmdidx].addr = -1;
+            cmds[cmdidx].cmdidx = cmdidx;
+            cmds[cmdidx].acct.count += pacct->count;
+            cmds[cmdidx].acct.retries += pacct->retries;
+            cmds[cmdidx].acct.wire += pacct->wire;
+            cmds[cmdidx].acct.retry += pacct->retry;
+            cmds[cmdidx].acct.wait += pacct->wait;
+        }
+    printf("  By register\n");
+    printRank(pranks,n,count,elapsed);
+    free(pranks);
+
+    /* Each command summed over the controllers */
+    for( n = 0, i = 0; i < cmdCount; ++i )
+        if( cmds[i].acct.count )
+            cmds[n++] = cmds[i];
+    printf("  By command\n");
+    printRank(cmds,n,count,elapsed);
+
+    /* Each record, named at iocInit from its link */
+    epicsMutexMustLock(pport->instLock);
+    for( n = 0, pinst = pport->pinsts; pinst; pinst = pinst->pnext )
+        ++n;
+    pranks = callocMustSucceed((n)?n:1,sizeof(Rank),"drvLoveTop");
+    for( n = 0, pinst = pport->pinsts; pinst; pinst = pinst->pnext )
+    {
+        if( pinst->acct.count == 0 )
+            continue;
+        pranks[n].name = pinst->owner;
+        pranks[n].addr = pinst->addr;
+        pranks[n].cmdidx = pinst->cmdidx;
+        pranks[n++].acct = pinst->acct;
+    }
+    epicsMutexUnlock(pport->instLock);
+    printf("  By record\n");
+    printRank(pranks,n,count,elapsed);
+    free(pranks);
+
+    if( reset )
+    {
+        resetAcct(pport);
+        printf("drvLoveTop::%s counters reset\n",pport->name);
+    }
+
+    return( 0 );
+}
+
+/****************************************************************************
+ * Define private interface suppport methods
+ ****************************************************************************/
+static asynStatus initSerialPort(Port* plov,const char* serPort,int serAddr)
+{
+    asynStatus sts;
+    asynUser* pasynUser;
+    Serport* pser = plov->pserport;
+    asynInterface* pasynIface;
+
+    /* A device path, broker socket or event port selects the built-in tty transport */
+    if( (serPort[0] == '/') || (strncmp(serPort,"unix:",5) == 0) || (strncmp(serPort,"event:",6) == 0) )
+        return( initTtyPort(plov,serPort) );
+
+    pasynUser = pasynManager->createAsynUser(NULL,NULL);
+    if( pasynUser == NULL )
+        return( asynError );
+
+    sts = pasynManager->connectDevice(pasynUser,serPort,serAddr);
+    if( ISNOTOK(sts) )
+    {
+        printf("initSerialPort::failure to connect with device %s @ %d\n",serPort,serAddr);
+        pasynManager->freeAsynUser(pasynUser);
+        return( asynError );
+    }
+
+    sts = pasynManager->isMultiDevice(pasynUser,serPort,&pser->multiDevice);
+    if( ISNOTOK(sts) )
+    {
+        printf("initSerialPort::failure to determine if %s @ %d is multi device\n",serPort,serAddr);
+        pasynManager->disconnect(pasynUser);
+        pasynManager->freeAsynUser(pasynUser);
+        return( asynError );
+    }
+
+    if(pser->multiDevice)
+    {
+        printf("initSerialPort::%s cannot be configured as multi device\n",serPort);
+        pasynManager->disconnect(pasynUser);
+        pasynManager->freeAsynUser(pasynUser);
+        return( asynError );
+    }
+
+    sts = pasynManager->canBlock(pasynUser,&pser->canBlock);
+    if( ISNOTOK(sts) )
+    {
+        printf("initSerialPort::failure to determine if %s @ %d can block\n",serPort,serAddr);
+        pasynManager->disconnect(pasynUser);
+        pasynManager->freeAsynUser(pasynUser);
+        return( asynError );
+    }
+
+    sts = pasynManager->isAutoConnect(pasynUser,&pser->autoConnect);
+    if( ISNOTOK(sts) )
+    {
+        printf("initSerialPort::failure to determine if %s @ %d is autoconnect\n",serPort,serAddr);
+        pasynManager->disconnect(pasynUser);
+        pasynManager->freeAsynUser(pasynUser);
+        return( asynError );
+    }
+
+    pasynIface = pasynManager->findInterface(pasynUser,asynOctetType,1);
+    if( pasynIface )
+    {
+        pser->pasynOctet = (asynOctet*)pasynIface->pinterface;
+        pser->pasynOctetPvt = pasynIface->drvPvt;
+    }
+    else
+    {
+        printf("initSerialPort::failure to find interface %s\n",asynOctetType);
+        pasynManager->disconnect(pasynUser);
+        pasynManager->freeAsynUser(pasynUser);
+        return( asynError );
+    }
+
+    /* Optional, only used to estimate the bus capacity */
+    pasynIface = pasynManager->findInterface(pasynUser,asynOptionType,1);
+    if( pasynIface )
+    {
+        pser->pasynOption = (asynOption*)pasynIface->pinterface;
+        pser->pasynOptionPvt = pasynIface->drvPvt;
+    }
+
+    /* Only used by the soak to drop the connection */
+    pasynIface = pasynManager->findInterface(pasynUser,asynCommonType,1);
+    if( pasynIface )
+    {
+        pser->pasynCommon = (asynCommon*)pasynIface->pinterface;
+        pser->pasynCommonPvt = pasynIface->drvPvt;
+    }
+
+    pser->addr = serAddr;
+    pser->pasynUser = pasynUser;
+    pser->isConn = 1;
+    strcpy(pser->name,serPort);
+    pasynUser->userPvt = plov;
+    pasynUser->timeout = K_COMTMO;
+
+    return( asynSuccess );
+}
+
+
+static int findCommand(const char* name)
+{
+    int i;
+
+    for( i = 0; i < cmdCount; ++i )
+        if( epicsStrCaseCmp(CmdTable[i].pname,name) == 0 )
+            return( i );
+
+    return( -1 );
+}
+
+
+static void initInst(Inst* pinst,Port* pport,int addr,int cmdidx)
+{
+    pinst->addr   = addr;
+    pinst->cmdidx = cmdidx;
+    pinst->param  = -1;
+    pinst->ramp   = -1;
+    pinst->isDone = 0;
+    pinst->pport  = pport;
+    pinst->pinfo  = &pport->instr[addr-1];
+    pinst->read   = CmdTable[cmdidx].read;
+    pinst->write  = CmdTable[cmdidx].write;
+}
+
+
+static const LoveCodes* instCmd(const Inst* pinst)
+{
+    /* Looked up on every use, the model of an address can change at run time */
+    return( &loveRegTable[pinst->pinfo->modidx][pinst->cmdidx] );
+}
+
+static void setCache(Inst* pinst,epicsInt32 value,const epicsTimeStamp* pstamp)
+{
+    epicsUInt32 changed;
+    Reg* preg = &pinst->pinfo->regs[pinst->cmdidx];
+
+    /* Value, stamp, history record and changed bits of a register change together */
+    epicsMutexMustLock(pinst->pport->cacheLock);
+    preg->value = value;
+    preg->stamp = *pstamp;
+    preg->isStale = 0;
+    preg->isWritten = 0;
+    preg->isValid = 1;
+    addHistory(pinst->pport,pinst->addr,pinst->cmdidx,value,&preg->stamp);
+    changed = bitsUpdate(preg,pinst->cmdidx,(epicsUInt32)value);
+    epicsMutexUnlock(pinst->pport->cacheLock);
+
+    bitsCallback(pinst->pport,pinst->addr,pinst->cmdidx,(epicsUInt32)value,changed,pstamp);
+}
+
+static void stampRead(Port* pport,Inst* pinst,asynUser* pasynUser)
+{
+    epicsTimeStamp now;
+    Reg* preg = &pinst->pinfo->regs[pinst->cmdidx];
+
+    /* The record gets the time of the reply, not of its processing (TSE=-2) */
+    pasynUser->timestamp = preg->stamp;
+    if( (pport->stale <= 0.0) || (pasynUser->alarmSeverity >= epicsSevMajor) )
+        return;
+
+    epicsTimeGetCurrent(&now);
+    if( epicsTimeDiffInSeconds(&now,&preg->stamp) > pport->stale )
+    {
+        pasynUser->alarmStatus = epicsAlarmTimeout;
+        pasynUser->alarmSeverity = epicsSevMajor;
+        epicsAtomicIncrIntT(&pport->nStale);
+    }
+}
+
+static asynStatus readAge(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32* value)
+{
+    double age;
+    epicsTimeStamp now;
+    Reg* preg = &pinst->pinfo->regs[pinst->cmdidx];
+
+    pasynUser->alarmStatus = epicsAlarmNone;
+    pasynUser->alarmSeverity = epicsSevNone;
+    if( preg->isValid == 0 )
+    {
+        *value = -1;
+        pasynUser->alarmStatus = epicsAlarmUDF;
+        pasynUser->alarmSeverity = epicsSevInvalid;
+        return( asynSuccess );
+    }
+
+    epicsTimeGetCurrent(&now);
+    age = epicsTimeDiffInSeconds(&now,&preg->stamp);
+    *value = (epicsInt32)((age * 1000.0) + 0.5);
+    if( (pport->stale > 0.0) && (age > pport->stale) )
+    {
+        pasynUser->alarmStatus = epicsAlarmTimeout;
+        pasynUser->alarmSeverity = epicsSevMajor;
+    }
+
+    return( asynSuccess );
+}
+
+
+static void clearCache(Inst* pinst)
+{
+    pinst->pinfo->regs[pinst->cmdidx].isValid = 0;
+}
+
+
+static void writeThrough(Port* pport,Inst* pinst,epicsInt32 value,const epicsTimeStamp* pstamp)
+{
+    Reg* preg = &pinst->pinfo->regs[pinst->cmdidx];
+
+    /* The acknowledged value is shown at once, but it was not read back: no read is answered from it */
+    setCache(pinst,value,pstamp);
+    epicsMutexMustLock(pport->cacheLock);
+    preg->isWritten = 1;
+    preg->primed = 0.0;
+    epicsMutexUnlock(pport->cacheLock);
+
+    readbackCallback(pport,pinst->addr,pinst->cmdidx,value);
+}
+
+
+static void readbackCallback(Port* pport,int addr,int cmdidx,epicsInt32 value)
+{
+    Inst* pinst;
+    ELLLIST* plist;
+    interruptNode* pnode;
+    asynInt32Interrupt* pint;
+
+    pasynManager->interruptStart(pport->asynInt32Pvt,&plist);
+    for( pnode = (interruptNode*)ellFirst(plist); pnode; pnode = (interruptNode*)ellNext(&pnode->node) )
+    {
+        pint = (asynInt32Interrupt*)pnode->drvPvt;
+        pinst = (Inst*)pint->pasynUser->drvUser;
+        if( pinst && (pinst->param < 0) && (pinst->ramp < 0) && (pinst->isAge == 0) && (pinst->addr == addr) && (pinst->cmdidx == cmdidx) )
+        {
+            pint->pasynUser->timestamp = pport->instr[addr - 1].regs[cmdidx].stamp;
+            pint->pasynUser->auxStatus = asynSuccess;
+            pint->pasynUser->alarmStatus = epicsAlarmNone;
+            pint->pasynUser->alarmSeverity = epicsSevNone;
+            pint->callback(pint->userPvt,pint->pasynUser,value);
+        }
+    }
+    pasynManager->interruptEnd(pport->asynInt32Pvt);
+}
+
+
+static void errorCallback(Port* pport,int addr,int cmdidx,int alarm)
+{
+    Inst* pinst;
+    ELLLIST* plist;
+    interruptNode* pnode;
+    asynInt32Interrupt* pint;
+    Reg* preg = &pport->instr[addr - 1].regs[cmdidx];
+
+    /* An event port request that failed after its record completed, the value is unchanged */
+    pasynManager->interruptStart(pport->asynInt32Pvt,&plist);
+    for( pnode = (interruptNode*)ellFirst(plist); pnode; pnode = (interruptNode*)ellNext(&pnode->node) )
+    {
+        pint = (asynInt32Interrupt*)pnode->drvPvt;
+        pinst = (Inst*)pint->pasynUser->drvUser;
+        if( pinst && (pinst->param < 0) && (pinst->ramp < 0) && (pinst->isAge == 0) && (pinst->addr == addr) && (pinst->cmdidx == cmdidx) )
+        {
+            epicsTimeGetCurrent(&pint->pasynUser->timestamp);
+            pint->pasynUser->auxStatus = asynError;
+            pint->pasynUser->alarmStatus = alarm;
+            pint->pasynUser->alarmSeverity = epicsSevInvalid;
+            pint->callback(pint->userPvt,pint->pasynUser,preg->value);
+        }
+    }
+    pasynManager->interruptEnd(pport->asynInt32Pvt);
+}
+
+
+static epicsUInt32 bitsUpdate(Reg* preg,int cmdidx,epicsUInt32 value)
+{
+    epicsUInt32 changed;
+
+    /* Only status and data words are bit fields */
+    if( (CmdTable[cmdidx].read != getStatus) && (CmdTable[cmdidx].read != getData) )
+        return( 0 );
+
+    /* Called under cacheLock, so two replies never both see the old bits */
+    changed = (preg->isBits)?(preg->bits ^ value):0xFFFFFFFF;
+    preg->bits = value;
+    preg->isBits = 1;
+
+    return( changed );
+}
+
+
+static void bitsCallback(Port* pport,int addr,int cmdidx,epicsUInt32 value,epicsUInt32 changed,const epicsTimeStamp* pstamp)
+{
+    Inst* pinst;
+    ELLLIST* plist;
+    interruptNode* pnode;
+    asynUInt32DigitalInterrupt* pint;
+
+    /* Each mask hears about its own bits only, and only when they change */
+    if( changed == 0 )
+        return;
+
+    pasynManager->interruptStart(pport->asynUInt32Pvt,&plist);
+    for( pnode = (interruptNode*)ellFirst(plist); pnode; pnode = (interruptNode*)ellNext(&pnode->node) )
+    {
+        pint = (asynUInt32DigitalInterrupt*)pnode->drvPvt;
+        pinst = (Inst*)pint->pasynUser->drvUser;
+        if( pinst && (pinst->param < 0) && (pinst->addr == addr) && (pinst->cmdidx == cmdidx) && (changed & pint->mask) )
+        {
+            pint->pasynUser->timestamp = *pstamp;
+            pint->callback(pint->userPvt,pint->pasynUser,value & pint->mask);
+        }
+    }
+    pasynManager->interruptEnd(pport->asynUInt32Pvt);
+}
+
+
+static void pairStatus(Port* pport,Inst* pinst,Trans* ptrans)
+{
+    Inst pair;
+    epicsInt32 value;
+
+    /* The "00" reply carries both the value and the status word */
+    if( (pinst->cmdidx != cmdValue) && (pinst->cmdidx != cmdAlSts) )
+        return;
+
+    pair = *pinst;
+    pair.cmdidx = (pinst->cmdidx == cmdValue)?cmdAlSts:cmdValue;
+    pair.read = CmdTable[pair.cmdidx].read;
+    if( ISNOTOK(pair.read(&pair,ptrans,&value)) )
+        return;
+
+    setCache(&pair,value,&ptrans->tsReply);
+    pport->instr[pinst->addr - 1].regs[pair.cmdidx].primed = K_PAIRAGE;
+}
+
+static void setParam(Port* pport,Param par,epicsInt32 value)
+{
+    Inst* pinst;
+    ELLLIST* plist;
+    interruptNode* pnode;
+    asynInt32Interrupt* pint;
+
+    pport->params[par] = value;
+
+    pasynManager->interruptStart(pport->asynInt32Pvt,&plist);
+    for( pnode = (interruptNode*)ellFirst(plist); pnode; pnode = (interruptNode*)ellNext(&pnode->node) )
+    {
+        pint = (asynInt32Interrupt*)pnode->drvPvt;
+        pinst = (Inst*)pint->pasynUser->drvUser;
+        if( pinst && (pinst->param == par) )
+            pint->callback(pint->userPvt,pint->pasynUser,value);
+    }
+    pasynManager->interruptEnd(pport->asynInt32Pvt);
+}
+
+
+static void callbackArray(Port* pport,Param par,epicsInt32* data,size_t count)
+{
+    Inst* pinst;
+    ELLLIST* plist;
+    interruptNode* pnode;
+    asynInt32ArrayInterrupt* pint;
+
+    pasynManager->interruptStart(pport->asynInt32ArrayPvt,&plist);
+    for( pnode = (interruptNode*)ellFirst(plist); pnode; pnode = (interruptNode*)ellNext(&pnode->node) )
+    {
+        pint = (asynInt32ArrayInterrupt*)pnode->drvPvt;
+        pinst = (Inst*)pint->pasynUser->drvUser;
+        if( pinst && (pinst->param == par) )
+            pint->callback(pint->userPvt,pint->pasynUser,data,count);
+    }
+    pasynManager->interruptEnd(pport->asynInt32ArrayPvt);
+}
+
+
+static asynStatus evalMessage(size_t* pcount,char* pinp,asynUser* pasynUser,char* pout)
+{
+    int sts,errNum;
+    size_t len;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::evalMessage\n");
+
+    /* Evaluate message contents,length,... */
+    sts = loveFrameCheck(pinp,*pcount,&errNum);
+    switch( sts )
+    {
+    case LOVEFRAME_NOSTX:
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::evalMessage start char missing\n");
+        return( asynError );
+    case LOVEFRAME_SHORT:
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::evalMessage message length (%d) error\n",(int)*pcount);
+        return( asynError );
+    case LOVEFRAME_CHECKSUM:
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::evalMessage checksum failed\n");
+        return( asynError );
+    case LOVEFRAME_NAK:
+        len = *pcount - 4;      /* Minus STX, FILTER, ADDR */
+        if( (errNum >= 0) && (errNum < (int)(sizeof(errCodes) / sizeof(errCodes[0]))) )
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::evalMessage error message received \"%s\"\n",errCodes[errNum]);
+        else
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::evalMessage error message received \"%02d\"\n",errNum);
+        break;
+    default:
+        len = *pcount - 6;      /* Minus STX, FILTER, ADDR and CHECKSUM */
+        asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::evalMessage message received\n");
+        break;
+    }
+
+    memcpy(pout,&pinp[4],len);
+    pout[len] = '\0';
+    *pcount = len;
+
+    return( (sts == LOVEFRAME_OK)?asynSuccess:asynError );
+}
+
+
+
+static asynStatus setDefaultEos(Port* plov)
+{
+    asynStatus sts;
+    char inpEos = '\006';
+    char outEos = '\003';
+    Serport* pser = plov->pserport;
+
+    /* RTU frames are binary and delimited by length */
+    if( plov->proto == protoRtu )
+    {
+        sts = pser->pasynOctet->setInputEos(pser->pasynOctetPvt,pser->pasynUser,NULL,0);
+        if( ISOK(sts) )
+            sts = pser->pasynOctet->setOutputEos(pser->pasynOctetPvt,pser->pasynUser,NULL,0);
+        if( ISNOTOK(sts) )
+            printf("drvLove::setDefaultEos failure to clear EOS for Modbus RTU\n");
+
+        plov->isEos = ISOK(sts);
+        return( sts );
+    }
+
+    sts = pser->pasynOctet->setInputEos(pser->pasynOctetPvt,pser->pasynUser,&inpEos,1);
+    if( ISOK(sts) )
+        printf("drvLove::setDefaultEos Input EOS set to \\0%d\n",inpEos);
+    else
+        printf("drvLove::setDefaultEos Input EOS set failed to \\0%d\n",inpEos);
+
+    sts = pser->pasynOctet->setOutputEos(pser->pasynOctetPvt,pser->pasynUser,&outEos,1);
+    if( ISOK(sts) )
+        printf("drvLove::setDefaultEos Output EOS set to \\0%d\n",outEos);
+    else
+        printf("drvLove::setDefaultEos Output EOS set failed to \\0%d\n",outEos);
+
+    plov->isEos = ISOK(sts);
+
+    return( sts );
+}
+
+
+static void exceptCallback(asynUser* pasynUser,asynException exception)
+{
+    asynStatus sts;
+    int isConn;
+    Port* plov = pasynUser->userPvt;
+    Serport* pser = plov->pserport;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::exceptionCallback\n");
+
+    sts = pasynManager->isConnected(pasynUser,&isConn);
+    if( ISNOTOK(sts) )
+    {
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::exceptionCallback failure to determine if %s is connected to %s\n",plov->name,pser->name);
+        return;
+    }
+
+    if( isConn )
+        return;
+
+    if( plov->isConn == 0 )
+        return;
+
+    plov->isConn = 0;
+    pasynManager->exceptionDisconnect(plov->pasynUser);
+}
+
+
+static asynStatus lockPort(void* drvPvt,asynUser* pasynUser)
+{
+    asynStatus sts;
+    Port* plov = (Port*)drvPvt;
+    Serport* pser = plov->pserport;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::lockPort\n");
+
+    if( pser->ptty )
+    {
+        epicsMutexMustLock(pser->ptty->lock);
+        return( asynSuccess );
+    }
+
+    sts = pasynManager->lockPort(pser->pasynUser);
+    if( ISNOTOK(sts) )
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pser->name,pser->pasynUser->errorMessage);
+
+    return( sts );
+}
+
+
+static asynStatus unlockPort(void* drvPvt,asynUser* pasynUser)
+{
+    asynStatus sts;
+    Port* plov = (Port*)drvPvt;
+    Serport* pser = plov->pserport;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::unlockPort\n");
+
+    if( pser->ptty )
+    {
+        epicsMutexUnlock(pser->ptty->lock);
+        return( asynSuccess );
+    }
+
+    sts = pasynManager->unlockPort(pser->pasynUser);
+    if( ISNOTOK(sts) )
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::unlockPort %s error %s\n",pser->name,pser->pasynUser->errorMessage);
+
+    return( asynSuccess );
+}
+
+
+static Trans* takeTrans(Port* pport)
+{
+    int i;
+    Trans* ptrans;
+
+    for( i = 0; i < K_TRANSMAX; ++i )
+    {
+        ptrans = &pport->trans[i];
+        if( epicsAtomicCmpAndSwapIntT(&ptrans->inUse,0,1) == 0 )
+            break;
+    }
+
+    if( i == K_TRANSMAX )
+    {
+        epicsAtomicIncrIntT(&pport->transOverflow);
+        ptrans = callocMustSucceed(1,sizeof(Trans),"drvLove::takeTrans");
+        ptrans->inUse  = 1;
+        ptrans->isHeap = 1;
+    }
+
+    initTrans(ptrans);
+
+    return( ptrans );
+}
+
+
+static void initTrans(Trans* ptrans)
+{
+    ptrans->sts       = asynSuccess;
+    ptrans->rawLen    = 0;
+    ptrans->outMsg[0] = '\0';
+    ptrans->inpMsg[0] = '\0';
+    ptrans->pinst     = NULL;
+    ptrans->retries   = 0;
+    ptrans->retryTime = 0.0;
+    ptrans->gap       = -1.0;
+    ptrans->timeout   = K_COMTMO;
+    epicsTimeGetCurrent(&ptrans->tsTake);
+    ptrans->tsReply   = ptrans->tsTake;
+}
+
+
+static void giveTrans(Port* pport,Trans* ptrans)
+{
+    if( ptrans->isHeap )
+        free(ptrans);
+    else
+        epicsAtomicSetIntT(&ptrans->inUse,0);
+}
+
+
+static asynStatus readCommand(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32* value)
+{
+    asynStatus sts;
+    Trans* ptrans;
+    epicsTimeStamp stamp;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::readCommand\n");
+
+    if( pport->proto == protoRtu )
+        return( rtuRead(pport,pinst,pasynUser,value) );
+
+    if( instCmd(pinst)->read == NULL )
+        return( asynError );
+
+    ptrans = takeTrans(pport);
+    ptrans->pinst = pinst;
+    sprintf(ptrans->outMsg,"%s",instCmd(pinst)->read);
+
+    sts = transact(pport,ptrans,pasynUser,pinst->addr);
+    if( ISOK(sts) )
+        sts = pinst->read(pinst,ptrans,value);
+    if( ISOK(sts) )
+        pairStatus(pport,pinst,ptrans);
+    stamp = ptrans->tsReply;
+    giveTrans(pport,ptrans);
+
+    if( ISOK(sts) )
+        setCache(pinst,*value,&stamp);
+
+    return( sts );
+}
+
+
+static asynStatus writeCommand(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32 value)
+{
+    int verify;
+    asynStatus sts;
+    Trans* ptrans;
+    epicsInt32 data;
+    epicsTimeStamp stamp;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::writeCommand\n");
+
+    /* The port lock is recursive, the readback shares the hold of the write */
+    verify = pport->verify;
+    if( verify )
+        lockPort(pport,pasynUser);
+
+    if( pport->proto == protoRtu )
+        sts = rtuWrite(pport,pinst,pasynUser,value,&stamp);
+    else
+    {
+        ptrans = takeTrans(pport);
+        ptrans->pinst = pinst;
+
+        /* The formatter may rewrite its value, verify against the requested one */
+        data = value;
+        sts = pinst->write(pinst,ptrans,&data);
+        if( ISOK(sts) )
+            sts = transact(pport,ptrans,pasynUser,pinst->addr);
+        if( ISOK(sts) )
+            sts = processWriteResponse(pport,ptrans);
+        stamp = ptrans->tsReply;
+        giveTrans(pport,ptrans);
+    }
+
+    if( verify )
+    {
+        if( ISOK(sts) )
+            sts = verifyWrite(pport,pinst,pasynUser,value);
+        unlockPort(pport,pasynUser);
+    }
+
+    /* A verified write was cached by its readback, an unverified one is cached as written */
+    if( ISOK(sts) && verify )
+        readbackCallback(pport,pinst->addr,pinst->cmdidx,value);
+    else if( ISOK(sts) )
+        writeThrough(pport,pinst,value,&stamp);
+
+    return( sts );
+}
+
+
+static asynStatus verifyWrite(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32 value)
+{
+    asynStatus sts;
+    epicsInt32 readback;
+
+    sts = readCommand(pport,pinst,pasynUser,&readback);
+    if( ISNOTOK(sts) )
+    {
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::verifyWrite %s addr %d %s readback failed\n",pport->name,pinst->addr,CmdTable[pinst->cmdidx].pname);
+        epicsAtomicIncrIntT(&pport->nVerifyFailed);
+        return( sts );
+    }
+
+    if( readback != value )
+    {
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::verifyWrite %s addr %d %s wrote %d read back %d\n",pport->name,pinst->addr,CmdTable[pinst->cmdidx].pname,value,readback);
+        epicsSnprintf(pport->pasynUser->errorMessage,pport->pasynUser->errorMessageSize,"%s wrote %d read back %d",CmdTable[pinst->cmdidx].pname,value,readback);
+        epicsAtomicIncrIntT(&pport->nVerifyFailed);
+        return( asynError );
+    }
+
+    return( asynSuccess );
+}
+
+
+static void noteTransaction(Port* pport,Trans* ptrans,asynStatus sts,double delay,size_t outLen)
+{
+    double held,turn;
+
+    held = epicsTimeDiffInSeconds(&ptrans->tsUnlock,&ptrans->tsLock);
+    pport->lockCount++;
+    pport->lockTime += held;
+    if( held > pport->lockMax )
+        pport->lockMax = held;
+    if( ptrans->pinst && (ptrans->pinst->cmdidx >= 0) )
+        chargeTrans(pport,ptrans,sts,held);
+    if( pport->psoak )
+        soakSample(pport,sts,held);
+    if( ISOK(sts) )
+    {
+        /* Turnaround is what remains after the delay and the frames on the wire */
+        turn = held - delay - ((outLen + ptrans->rawLen) * pport->charTime);
+        turn = (turn > 0.0)?turn:0.0;
+        pport->turnaround = (pport->turnaround > 0.0)?((0.9 * pport->turnaround) + (0.1 * turn)):turn;
+    }
+}
+
+
+static asynStatus transact(Port* pport,Trans* ptrans,asynUser* pasynUser,int addr)
+{
+    asynStatus sts;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::transact\n");
+
+    sts = buildCommand(pport,ptrans,addr);
+    if( ISNOTOK(sts) )
+        return( ptrans->sts = sts );
+
+    if( pport->bus.isEngine )
+        sts = engineTransact(pport,ptrans);
+    else
+    {
+        lockPort(pport,pasynUser);
+        epicsTimeGetCurrent(&ptrans->tsLock);
+        if( pport->isEos == 0 )
+            setDefaultEos(pport);
+        sts = executeCommand(pport,ptrans,pasynUser);
+        epicsTimeGetCurrent(&ptrans->tsUnlock);
+        pport->pserport->pasynUser->timeout = K_COMTMO;
+        noteTransaction(pport,ptrans,sts,ptrans->gap,strlen(ptrans->outMsg));
+        unlockPort(pport,pasynUser);
+    }
+
+    if( ISOK(sts) )
+        sts = evalMessage(&ptrans->rawLen,ptrans->rawMsg,pasynUser,ptrans->inpMsg);
+
+    return( ptrans->sts = sts );
+}
+
+
+static asynStatus executeCommand(Port* pport,Trans* ptrans,asynUser* pasynUser)
+{
+    int i;
+    asynStatus sts;
+    epicsTimeStamp tsTry,now;
+    Serport* pser = pport->pserport;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::executeCommand\n");
+    pasynUser->timeout = K_COMTMO;
+    pser->pasynUser->timeout = ptrans->timeout;
+    if( ptrans->gap < 0.0 )
+        ptrans->gap = (pser->ptty && pser->ptty->isBroker)?0.0:pport->gap;
+
+    for( i = 0; i < 3; ++i )
+    {
+        /* Attempts that timed out are charged as retry cost */
+        epicsTimeGetCurrent(&now);
+        if( i )
+        {
+            ptrans->retryTime += epicsTimeDiffInSeconds(&now,&tsTry);
+            ptrans->retries++;
+        }
+        tsTry = now;
+
+        epicsThreadSleep( ptrans->gap );
+
+        sts = sendCommand(pport,ptrans,pasynUser,i);
+        if( ISOK(sts) )
+            asynPrint(pasynUser,ASYN_TRACEIO_FILTER,"drvLove::executeCommand write \"%s\"\n",ptrans->outMsg);
+        else
+        {
+            if( sts == asynTimeout )
+            {
+                asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::executeCommand write timeout, retrying\n");
+                continue;
+            }
+
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::executeCommand write failure - Sent \"%s\" \n",ptrans->outMsg);
+            return( sts );
+        }
+
+        sts = recvReply(pport,ptrans,pasynUser);
+        if( ISOK(sts) )
+        {
+            epicsTimeGetCurrent(&ptrans->tsReply);
+            asynPrint(pasynUser,ASYN_TRACEIO_FILTER,"drvLove::executeCommand read \"%s\"\n",ptrans->rawMsg);
+        }
+        else
+        {
+            if( sts == asynTimeout )
+            {
+                asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::executeCommand read timeout, retrying\n");
+                continue;
+            }
+
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::executeCommand read failure - Sent \"%s\" Rcvd \"%s\" \n",ptrans->outMsg,ptrans->rawMsg);
+            return( sts );
+        }
+
+        return( asynSuccess );
+    }
+
+    asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::executeCommand retries exceeded\n");
+    return( asynError );
+}
+
+
+static asynStatus processWriteResponse(Port* pport,Trans* ptrans)
+{
+    int resp;
+
+
+    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::processWriteResponse\n" );
+
+    sscanf(ptrans->inpMsg,"%2d",&resp);
+    if( resp )
+    {
+        asynPrint(pport->pasynUser,ASYN_TRACE_ERROR,"drvLove::processWriteResponse write command failed\n" );
+        return( asynError );
+    }
+
+    return( asynSuccess );
+}
+
+
+static asynStatus buildCommand(Port* pport,Trans* ptrans,int addr)
+{
+    if( (addr < 1) || (addr > K_INSTRMAX) )
+        return( asynError );
+
+    if( loveFrameBuild(ptrans->outMsg,sizeof(ptrans->outMsg),addr,ptrans->outMsg) < 0 )
+        return( asynOverflow );
+
+    return( asynSuccess );
+}
+
+
+static asynStatus sendCommand(void* ppvt,Trans* ptrans,asynUser* pasynUser,int retry)
+{
+    asynStatus sts;
+    size_t len,bytesXfer;
+    Port* plov = (Port*)ppvt;
+    Serport* pser = plov->pserport;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::sendCommand - retries(%d)\n",retry);
+
+    len = strlen(ptrans->outMsg);
+    sts = pser->pasynOctet->write(pser->pasynOctetPvt,pser->pasynUser,ptrans->outMsg,len,&bytesXfer);
+    if( ISOK(sts) )
+        asynPrint(pasynUser,ASYN_TRACEIO_FILTER,"drvLove::sendCommand - retries(%d),data \"%s\"\n",retry,ptrans->outMsg);
+    else
+    {
+        if( sts == asynTimeout )
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::sendCommand - retries(%d) asynTimeout\n",retry);
+        else if( sts == asynOverflow )
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::sendCommand - retries(%d) asynOverflow\n",retry);
+        else if( sts == asynError )
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::sendCommand - retries(%d) asynError\n",retry);
+        else
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::sendCommand - retries(%d) failed - unknown Asyn error\n",retry);
+    }
+
+    return( sts );
+}
+
+
+static asynStatus recvReply(void* ppvt,Trans* ptrans,asynUser* pasynUser)
+{
+    int eom;
+    asynStatus sts;
+    size_t bytesXfer;
+    Port* plov = (Port*)ppvt;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::recvReplay\n");
+
+    sts = readSerport(plov,ptrans->rawMsg,sizeof(ptrans->rawMsg) - 1,&bytesXfer,&eom);
+    if( ISOK(sts) )
+    {
+        ptrans->rawMsg[bytesXfer] = '\0';
+        ptrans->rawLen = bytesXfer;
+
+        if( eom != ASYN_EOM_EOS )
+        {
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::recvReply eos failure\n");
+            return( asynError );
+        }
+
+        asynPrint(pasynUser,ASYN_TRACEIO_FILTER,"drvLove::recvReply %d \"%s\"\n",(int)bytesXfer,ptrans->rawMsg);
+    }
+    else
+    {
+        if( sts == asynTimeout )
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::recvReply asynTimeout\n");
+        else if( sts == asynOverflow )
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::recvReply asynOverflow\n");
+        else if( sts == asynError )
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::recvReply asynError\n");
+        else
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::recvReply failed - unknown Asyn error\n");
+    }
+
+    return( sts );
+}
+
+static asynStatus readSerport(Port* pport,char* data,size_t maxchars,size_t* pbytes,int* peom)
+{
+    asynStatus sts;
+    epicsTimeStamp start;
+    Serport* pser = pport->pserport;
+
+    /* All ASCII and RTU replies pass here, which is where the soak injects its faults */
+    epicsTimeGetCurrent(&start);
+    sts = pser->pasynOctet->read(pser->pasynOctetPvt,pser->pasynUser,data,maxchars,pbytes,peom);
+    if( ISOK(sts) && pport->psoak && (pport->psoak->faults > 0.0) )
+        sts = soakFault(pport,pser->pasynUser,data,pbytes,&start);
+
+    return( sts );
+}
+
+
+/****************************************************************************
+ * Define private batch (download, restore, warm-up) methods
+ ****************************************************************************/
+static Batch* createBatch(Port* pport,BatchKind kind)
+{
+    asynStatus sts;
+    Batch* pbatch;
+    asynUser* pasynUser;
+
+    pbatch = callocMustSucceed(1,sizeof(Batch),"drvLove::createBatch");
+    pbatch->pport = pport;
+    pbatch->kind = kind;
+    pbatch->refs = 1;
+    pbatch->done = epicsEventMustCreate(epicsEventEmpty);
+
+    pasynUser = pasynManager->createAsynUser(processBatch,NULL);
+    pasynUser->userPvt = pbatch;
+    pasynUser->timeout = K_COMTMO;
+    pbatch->pasynUser = pasynUser;
+
+    sts = pasynManager->connectDevice(pasynUser,pport->name,-1);
+    if( ISNOTOK(sts) )
+        printf("drvLove::createBatch failure to connect with device %s\n",pport->name);
+
+    return( pbatch );
+}
+
+
+/* A batch is released by its last holder, drvLoveDownload holds it while printing */
+static void holdBatch(Batch* pbatch)
+{
+    epicsAtomicIncrIntT(&pbatch->refs);
+}
+
+static void freeBatch(Batch* pbatch)
+{
+    if( (pbatch == NULL) || (epicsAtomicDecrIntT(&pbatch->refs) > 0) )
+        return;
+
+    pasynManager->disconnect(pbatch->pasynUser);
+    pasynManager->freeAsynUser(pbatch->pasynUser);
+    epicsEventDestroy(pbatch->done);
+    free(pbatch->psteps);
+    free(pbatch->pstatus);
+    free(pbatch);
+}
+
+
+static asynStatus addStep(Batch* pbatch,StepOp op,int line,int addr,int cmdidx,epicsInt32 value)
+{
+    Step* pstep;
+
+    if( pbatch->count == pbatch->size )
+    {
+        Step* psteps;
+        epicsInt32* pstatus;
+
+        pbatch->size = (pbatch->size)?(2 * pbatch->size):K_SLICE;
+        psteps = callocMustSucceed(pbatch->size,sizeof(Step),"drvLove::addStep");
+        pstatus = callocMustSucceed(pbatch->size,sizeof(epicsInt32),"drvLove::addStep");
+        if( pbatch->count )
+        {
+            memcpy(psteps,pbatch->psteps,pbatch->count * sizeof(Step));
+            free(pbatch->psteps);
+            free(pbatch->pstatus);
+        }
+        pbatch->psteps = psteps;
+        pbatch->pstatus = pstatus;
+    }
+
+    pstep = &pbatch->psteps[pbatch->count];
+    pstep->index  = pbatch->count++;
+    pstep->line   = line;
+    pstep->addr   = addr;
+    pstep->cmdidx = cmdidx;
+    pstep->value  = value;
+    pstep->op     = op;
+    pstep->prio   = 0;
+    pstep->sts    = stepPending;
+
+    if( (cmdidx < 0) || ((op != opRead) && (CmdTable[cmdidx].write == doNull)) )
+    {
+        pstep->cmdidx = -1;
+        pstep->sts = stepRejected;
+        return( asynError );
+    }
+
+    if( (addr < 1) || (addr > K_INSTRMAX) || (pbatch->pport->instr[addr-1].isConfig == 0) )
+    {
+        pstep->sts = stepRejected;
+        return( asynError );
+    }
+
+    if( op == opRead )
+        pstep->prio = CmdTable[cmdidx].warm;
+
+    return( asynSuccess );
+}
+
+
+static int cmpStep(const void* p1,const void* p2)
+{
+    const Step* ps1 = (const Step*)p1;
+    const Step* ps2 = (const Step*)p2;
+
+    if( ps1->prio != ps2->prio )
+        return( ps1->prio - ps2->prio );
+    if( ps1->addr != ps2->addr )
+        return( ps1->addr - ps2->addr );
+    if( ps1->cmdidx != ps2->cmdidx )
+        return( ps1->cmdidx - ps2->cmdidx );
+    return( ps1->index - ps2->index );
+}
+
+
+static void setBatchParam(Batch* pbatch,int field,epicsInt32 value)
+{
+    setParam(pbatch->pport,(Param)(batchBase[pbatch->kind] + field),value);
+}
+
+
+static void prepareBatch(Batch* pbatch)
+{
+    int i;
+    Step* psteps = pbatch->psteps;
+
+    pbatch->nSkipped = 0;
+    pbatch->nFailed = 0;
+
+    /* Order by priority and controller and drop entries superseded later on */
+    qsort(psteps,pbatch->count,sizeof(Step),cmpStep);
+    for( i = 0; i < pbatch->count; ++i )
+    {
+        if( (i > 0) && (psteps[i].sts == stepPending) && (psteps[i-1].sts == stepPending) &&
+            (psteps[i].addr == psteps[i-1].addr) && (psteps[i].cmdidx == psteps[i-1].cmdidx) )
+        {
+            psteps[i-1].sts = stepSkipped;
+            pbatch->pstatus[psteps[i-1].index] = stepSkipped;
+            ++pbatch->nSkipped;
+        }
+
+        pbatch->pstatus[psteps[i].index] = psteps[i].sts;
+        if( psteps[i].sts == stepRejected )
+            ++pbatch->nFailed;
+    }
+
+    setBatchParam(pbatch,bpTotal,pbatch->count);
+    setBatchParam(pbatch,bpDone,0);
+    setBatchParam(pbatch,bpSkipped,pbatch->nSkipped);
+    setBatchParam(pbatch,bpFailed,pbatch->nFailed);
+}
+
+
+static asynQueuePriority batchPriority(Batch* pbatch)
+{
+    /* The first warm-up phase (scaling and primary values) goes ahead of records */
+    if( (pbatch->next < pbatch->count) && (pbatch->psteps[pbatch->next].op == opRead) && (pbatch->psteps[pbatch->next].prio == 0) )
+        return( asynQueuePriorityHigh );
+
+    return( asynQueuePriorityMedium );
+}
+
+
+static asynStatus startBatch(Batch* pbatch)
+{
+    asynStatus sts;
+    Port* pport = pbatch->pport;
+
+    if( epicsAtomicCmpAndSwapIntT(&pport->busy[pbatch->kind],0,1) != 0 )
+        return( asynError );
+
+    prepareBatch(pbatch);
+    setBatchParam(pbatch,bpBusy,1);
+
+    sts = queuePort(pport,pbatch->pasynUser,processBatch,batchPriority(pbatch));
+    if( ISNOTOK(sts) )
+    {
+        setBatchParam(pbatch,bpBusy,0);
+        epicsAtomicSetIntT(&pport->busy[pbatch->kind],0);
+    }
+
+    return( sts );
+}
+
+
+static void collectRestore(Batch* pbatch)
+{
+    int i,j;
+    Reg* preg;
+    Port* pport = pbatch->pport;
+
+    /* Under the cache lock, so no deferred write can be missed, also from the records of an event port */
+    epicsMutexMustLock(pport->cacheLock);
+    pport->restore = 0;
+
+    for( i = 0; i < K_INSTRMAX; ++i )
+        for( j = 0; j < cmdCount; ++j )
+        {
+            preg = &pport->instr[i].regs[j];
+            if( preg->isPending == 0 )
+                continue;
+
+            preg->isPending = 0;
+            addStep(pbatch,opRestore,0,i + 1,j,preg->pending);
+        }
+    epicsMutexUnlock(pport->cacheLock);
+
+    asynPrint(pbatch->pasynUser,ASYN_TRACE_FLOW,"drvLove::collectRestore %s %d saved values\n",pport->name,pbatch->count);
+}
+
+
+static int deferWrite(Port* pport,Inst* pinst,epicsInt32 value)
+{
+    int isDeferred;
+    Reg* preg;
+
+    if( pinst->write != putData )
+        return( 0 );
+
+    epicsMutexMustLock(pport->cacheLock);
+    isDeferred = pport->restore;
+    if( isDeferred )
+    {
+        preg = &pinst->pinfo->regs[pinst->cmdidx];
+        preg->pending = value;
+        preg->isPending = 1;
+    }
+    epicsMutexUnlock(pport->cacheLock);
+
+    return( isDeferred );
+}
+
+
+static asynStatus startWarmup(Port* pport)
+{
+    int i,j;
+    asynStatus sts;
+    Batch* pbatch;
+
+    pbatch = createBatch(pport,batchWarmup);
+    for( i = 0; i < K_INSTRMAX; ++i )
+        if( pport->instr[i].isConfig )
+            for( j = 0; j < cmdCount; ++j )
+                addStep(pbatch,opRead,0,i + 1,j,0);
+
+    if( pbatch->count == 0 )
+    {
+        freeBatch(pbatch);
+        return( asynSuccess );
+    }
+
+    sts = startBatch(pbatch);
+    if( ISNOTOK(sts) )
+        freeBatch(pbatch);
+
+    return( sts );
+}
+
+
+static void initHook(initHookState state)
+{
+    Port* pport;
+    Batch* pbatch;
+
+    if( state == initHookAtBeginning )
+    {
+        for( pport = pports; pport; pport = pport->pport )
+        {
+            if( pport->sched.isLock )
+                lockMemory(pport);
+            if( pport->pcache )
+                loadCache(pport);
+            if( pport->warmup && ISNOTOK(startWarmup(pport)) )
+                printf("drvLove::initHook failure to start warm-up on %s\n",pport->name);
+        }
+    }
+    else if( state == initHookAfterIocRunning )
+    {
+        for( pport = pports; pport; pport = pport->pport )
+        {
+            scanRecords(pport);
+            probeSched(pport);
+            if( (pport->groups[groupFast].period > 0.0) || (pport->groups[groupSlow].period > 0.0) )
+                epicsThreadMustCreate("lovePoll",schedPriority(pport,epicsThreadPriorityScanHigh),epicsThreadGetStackSize(epicsThreadStackSmall),pollThread,pport);
+            startRamp(pport,1);
+            if( pport->pcache )
+                epicsThreadMustCreate("loveCache",epicsThreadPriorityLow,epicsThreadGetStackSize(epicsThreadStackSmall),cacheThread,pport);
+
+            if( pport->restore == 0 )
+                continue;
+
+            pbatch = createBatch(pport,batchDownload);
+            pbatch->restore = 1;
+
+            if( ISNOTOK(startBatch(pbatch)) )
+            {
+                printf("drvLove::initHook failure to start restore on %s\n",pport->name);
+                pport->restore = 0;
+                freeBatch(pbatch);
+            }
+        }
+    }
+}
+
+
+static void processBatch(asynUser* pasynUser)
+{
+    int i;
+    Batch* pbatch = (Batch*)pasynUser->userPvt;
+    Port* pport = pbatch->pport;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::processBatch\n");
+
+    /* The port thread owns pport->pbatch, the previous result is released here */
+    if( pport->pbatch[pbatch->kind] != pbatch )
+    {
+        freeBatch(pport->pbatch[pbatch->kind]);
+        pport->pbatch[pbatch->kind] = pbatch;
+    }
+
+    if( pbatch->restore )
+    {
+        pbatch->restore = 0;
+        collectRestore(pbatch);
+        prepareBatch(pbatch);
+    }
+
+    for( i = 0; (i < K_SLICE) && (pbatch->next < pbatch->count); ++i )
+        runStep(pbatch,&pbatch->psteps[pbatch->next++]);
+
+    setBatchParam(pbatch,bpDone,pbatch->nDone);
+    setBatchParam(pbatch,bpSkipped,pbatch->nSkipped);
+    setBatchParam(pbatch,bpFailed,pbatch->nFailed);
+    if( pbatch->kind == batchDownload )
+        callbackArray(pport,parDlStatus,pbatch->pstatus,pbatch->count);
+
+    /* Requeue so that record I/O is interleaved with the remaining entries */
+    if( pbatch->next < pbatch->count )
+    {
+        if( ISOK(queuePort(pport,pasynUser,processBatch,batchPriority(pbatch))) )
+            return;
+
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::processBatch %s failure to queue request\n",pport->name);
+        for( ; pbatch->next < pbatch->count; ++pbatch->next )
+        {
+            Step* pstep = &pbatch->psteps[pbatch->next];
+            if( pstep->sts == stepPending )
+            {
+                pstep->sts = stepFailed;
+                pbatch->pstatus[pstep->index] = stepFailed;
+                ++pbatch->nFailed;
+            }
+        }
+        setBatchParam(pbatch,bpFailed,pbatch->nFailed);
+        if( pbatch->kind == batchDownload )
+            callbackArray(pport,parDlStatus,pbatch->pstatus,pbatch->count);
+    }
+
+    setBatchParam(pbatch,bpBusy,0);
+    epicsAtomicSetIntT(&pport->busy[pbatch->kind],0);
+    epicsEventSignal(pbatch->done);
+}
+
+
+static void runStep(Batch* pbatch,Step* pstep)
+{
+    Inst inst;
+    Reg* preg;
+    asynStatus sts;
+    epicsInt32 value;
+    Port* pport = pbatch->pport;
+
+    if( pstep->sts != stepPending )
+        return;
+
+    initInst(&inst,pport,pstep->addr,pstep->cmdidx);
+    preg = &inst.pinfo->regs[pstep->cmdidx];
+
+    /* Warm-up reads hand their value to the first record that reads it */
+    if( pstep->op == opRead )
+    {
+        sts = readCommand(pport,&inst,pbatch->pasynUser,&value);
+        if( ISOK(sts) )
+        {
+            preg->primed = K_PRIMED;
+            pstep->sts = stepDone;
+            ++pbatch->nDone;
+        }
+        else
+        {
+            pstep->sts = stepFailed;
+            ++pbatch->nFailed;
+        }
+
+        pbatch->pstatus[pstep->index] = pstep->sts;
+        return;
+    }
+
+    /* Restore entries compare against the controller, not the cache */
+    if( pstep->op == opRestore )
+    {
+        sts = readCommand(pport,&inst,pbatch->pasynUser,&value);
+        if( ISNOTOK(sts) )
+            preg->isValid = 0;
+    }
+
+    if( preg->isValid && (preg->isStale == 0) && (preg->isWritten == 0) && (preg->value == pstep->value) )
+    {
+        asynPrint(pbatch->pasynUser,ASYN_TRACE_FLOW,"drvLove::runStep addr %d %s already %d\n",pstep->addr,CmdTable[pstep->cmdidx].pname,pstep->value);
+        pstep->sts = stepSkipped;
+        ++pbatch->nSkipped;
+    }
+    else
+    {
+        sts = writeCommand(pport,&inst,pbatch->pasynUser,pstep->value);
+        if( ISOK(sts) )
+        {
+            pstep->sts = stepDone;
+            ++pbatch->nDone;
+        }
+        else
+        {
+            asynPrint(pbatch->pasynUser,ASYN_TRACE_ERROR,"drvLove::runStep addr %d %s failed\n",pstep->addr,CmdTable[pstep->cmdidx].pname);
+            clearCache(&inst);
+            pstep->sts = stepFailed;
+            ++pbatch->nFailed;
+        }
+    }
+
+    pbatch->pstatus[pstep->index] = pstep->sts;
+}
+
+
+static int readPrimed(Inst* pinst,epicsInt32* value)
+{
+    epicsTimeStamp now;
+    Reg* preg = &pinst->pinfo->regs[pinst->cmdidx];
+
+    if( (preg->primed <= 0.0) || (preg->isValid == 0) )
+        return( 0 );
+
+    epicsTimeGetCurrent(&now);
+    if( epicsTimeDiffInSeconds(&now,&preg->stamp) > preg->primed )
+    {
+        preg->primed = 0.0;
+        return( 0 );
+    }
+    preg->primed = 0.0;
+
+    *value = preg->value;
+    return( 1 );
+}
+
+
+/****************************************************************************
+ * Define private value cache file methods
+ ****************************************************************************/
+static void* mapCache(const char* file,size_t* psize)
+{
+    void* pdata;
+#ifdef USE_MMAP
+    int fd;
+    struct stat st;
+
+    fd = open(file,O_RDONLY);
+    if( fd < 0 )
+        return( NULL );
+
+    pdata = NULL;
+    if( (fstat(fd,&st) == 0) && (st.st_size > 0) )
+    {
+        pdata = mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+        if( pdata == MAP_FAILED )
+            pdata = NULL;
+        *psize = (size_t)st.st_size;
+    }
+    close(fd);
+#else
+    FILE* fp;
+    long size;
+
+    fp = fopen(file,"rb");
+    if( fp == NULL )
+        return( NULL );
+
+    pdata = NULL;
+    if( (fseek(fp,0,SEEK_END) == 0) && ((size = ftell(fp)) > 0) )
+    {
+        rewind(fp);
+        pdata = malloc((size_t)size);
+        if( pdata && (fread(pdata,1,(size_t)size,fp) != (size_t)size) )
+        {
+            free(pdata);
+            pdata = NULL;
+        }
+        *psize = (size_t)size;
+    }
+    fclose(fp);
+#endif
+
+    return( pdata );
+}
+
+
+static void unmapCache(void* pdata,size_t size)
+{
+#ifdef USE_MMAP
+    munmap(pdata,size);
+#else
+    free(pdata);
+#endif
+}
+
+
+static void loadCache(Port* pport)
+{
+    size_t size;
+    void* pdata;
+    epicsUInt32 i;
+    Reg* preg;
+    Instr* pinstr;
+    CacheHdr* phdr;
+    CacheRec* prec;
+    Cache* pcache = pport->pcache;
+
+    size = 0;
+    pdata = mapCache(pcache->file,&size);
+    if( pdata == NULL )
+    {
+        asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::loadCache %s no cache file %s\n",pport->name,pcache->file);
+        return;
+    }
+
+    phdr = (CacheHdr*)pdata;
+    prec = (CacheRec*)(phdr + 1);
+    if( (size < sizeof(CacheHdr)) || (phdr->magic != K_CACHEMAG) || (phdr->version != K_CACHEVER) ||
+        (phdr->cmdCount != (epicsUInt32)cmdCount) || (size != sizeof(CacheHdr) + phdr->count * sizeof(CacheRec)) )
+    {
+        printf("drvLove::loadCache %s ignoring invalid cache file %s\n",pport->name,pcache->file);
+        unmapCache(pdata,size);
+        return;
+    }
+
+    /* Seeded values are served as stale until the bus confirms them */
+    for( i = 0; i < phdr->count; ++i, ++prec )
+    {
+        if( (prec->addr < 1) || (prec->addr > K_INSTRMAX) || (prec->cmdidx >= cmdCount) )
+            continue;
+
+        pinstr = &pport->instr[prec->addr - 1];
+        if( (pinstr->isConfig == 0) || (pinstr->modidx != (Model)prec->modidx) )
+            continue;
+
+        preg = &pinstr->regs[prec->cmdidx];
+        if( preg->isValid )
+            continue;
+
+        preg->value = prec->value;
+        preg->stamp.secPastEpoch = prec->secPastEpoch;
+        preg->stamp.nsec = prec->nsec;
+        preg->isStale = 1;
+        preg->isValid = 1;
+        ++pcache->nSeeded;
+    }
+
+    unmapCache(pdata,size);
+
+    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::loadCache %s seeded %d registers\n",pport->name,pcache->nSeeded);
+}
+
+
+static void snapCache(asynUser* pasynUser)
+{
+    int i,j;
+    Reg* preg;
+    CacheRec* prec;
+    Port* pport = (Port*)pasynUser->userPvt;
+    Cache* pcache = pport->pcache;
+
+    /* Runs on the port thread, so the registers are consistent */
+    prec = pcache->recs;
+    for( i = 0; i < K_INSTRMAX; ++i )
+        for( j = 0; j < cmdCount; ++j )
+        {
+            preg = &pport->instr[i].regs[j];
+            if( preg->isValid == 0 )
+                continue;
+
+            prec->addr = (epicsUInt16)(i + 1);
+            prec->cmdidx = (epicsUInt8)j;
+            prec->modidx = (epicsUInt8)pport->instr[i].modidx;
+            prec->value = preg->value;
+            prec->secPastEpoch = preg->stamp.secPastEpoch;
+            prec->nsec = preg->stamp.nsec;
+            ++prec;
+        }
+
+    pcache->count = (int)(prec - pcache->recs);
+    epicsEventSignal(pcache->snapped);
+}
+
+
+static asynStatus saveCache(Port* pport)
+{
+    FILE* fp;
+    int ok;
+    CacheHdr hdr;
+    Cache* pcache = pport->pcache;
+
+    hdr.magic = K_CACHEMAG;
+    hdr.version = K_CACHEVER;
+    hdr.cmdCount = (epicsUInt32)cmdCount;
+    hdr.count = (epicsUInt32)pcache->count;
+
+    fp = fopen(pcache->tmpFile,"wb");
+    if( fp == NULL )
+        return( asynError );
+
+    ok = (fwrite(&hdr,sizeof(CacheHdr),1,fp) == 1);
+    if( ok && pcache->count )
+        ok = (fwrite(pcache->recs,sizeof(CacheRec),pcache->count,fp) == (size_t)pcache->count);
+    ok = (fclose(fp) == 0) && ok;
+
+    /* Readers see either the previous or the new file, never a partial one */
+    if( ok && (rename(pcache->tmpFile,pcache->file) != 0) )
+    {
+        remove(pcache->file);
+        ok = (rename(pcache->tmpFile,pcache->file) == 0);
+    }
+
+    if( ok == 0 )
+    {
+        remove(pcache->tmpFile);
+        return( asynError );
+    }
+
+    return( asynSuccess );
+}
+
+
+static void cacheThread(void* parm)
+{
+    asynStatus sts;
+    Port* pport = (Port*)parm;
+    Cache* pcache = pport->pcache;
+
+    for( ;; )
+    {
+        epicsThreadSleep(pcache->period);
+
+        sts = queuePort(pport,pcache->pasynUser,snapCache,asynQueuePriorityLow);
+        if( ISOK(sts) )
+            epicsEventMustWait(pcache->snapped);
+        if( ISOK(sts) )
+            sts = saveCache(pport);
+
+        if( ISOK(sts) )
+            ++pcache->nSaves;
+        else
+        {
+            asynPrint(pport->pasynUser,ASYN_TRACE_ERROR,"drvLove::cacheThread %s failure to save %s\n",pport->name,pcache->file);
+            ++pcache->nFailed;
+        }
+    }
+}
+
+
+static int readStale(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32* value)
+{
+    Reg* preg = &pinst->pinfo->regs[pinst->cmdidx];
+
+    if( (preg->isStale == 0) || (preg->isValid == 0) )
+        return( 0 );
+
+    /* Only until the warm-up has had its chance to refresh the register */
+    if( interruptAccept && (epicsAtomicGetIntT(&pport->busy[batchWarmup]) == 0) )
+        return( 0 );
+
+    *value = preg->value;
+    pasynUser->timestamp = preg->stamp;
+    pasynUser->alarmStatus = epicsAlarmUDF;
+    pasynUser->alarmSeverity = epicsSevMinor;
+
+    return( 1 );
+}
+
+
+/****************************************************************************
+ * Define private shared history methods
+ ****************************************************************************/
+static void* mapHistory(const char* file,size_t size)
+{
+#ifdef USE_MMAP
+    int fd;
+    void* pdata;
+
+    fd = open(file,O_RDWR | O_CREAT,0644);
+    if( fd < 0 )
+        return( NULL );
+
+    pdata = NULL;
+    if( ftruncate(fd,(off_t)size) == 0 )
+    {
+        pdata = mmap(NULL,size,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+        if( pdata == MAP_FAILED )
+            pdata = NULL;
+    }
+    close(fd);
+
+    return( pdata );
+#else
+    printf("drvLove::mapHistory shared memory-mapped files are not supported on this target\n");
+    return( NULL );
+#endif
+}
+
+
+static void addHistory(Port* pport,int addr,int cmdidx,epicsInt32 value,const epicsTimeStamp* pstamp)
+{
+    HistRec* prec;
+    History* phist = pport->phist;
+    epicsUInt32 seq;
+
+    if( phist == NULL )
+        return;
+
+    epicsMutexMustLock(phist->lock);
+
+    /* Sequence numbers start at 1, record n lives in slot (n - 1) % depth */
+    seq = phist->head + 1;
+    if( seq == 0 )
+        seq = 1;
+    prec = &phist->precs[(seq - 1) & (phist->depth - 1)];
+
+    /* A zero sequence marks the slot as being rewritten */
+    prec->seq = 0;
+    epicsAtomicWriteMemoryBarrier();
+
+    prec->addr = (epicsUInt16)addr;
+    prec->cmdidx = (epicsUInt8)cmdidx;
+    prec->secPastEpoch = pstamp->secPastEpoch;
+    prec->nsec = pstamp->nsec;
+
+    /* Values are deltas to the previous sample of the register, with a periodic key */
+    if( phist->left[addr-1][cmdidx] == 0 )
+    {
+        prec->flags = K_HISTABS;
+        prec->value = value;
+        phist->left[addr-1][cmdidx] = K_HISTKEY - 1;
+    }
+    else
+    {
+        prec->flags = 0;
+        prec->value = value - phist->last[addr-1][cmdidx];
+        --phist->left[addr-1][cmdidx];
+    }
+    phist->last[addr-1][cmdidx] = value;
+
+    epicsAtomicWriteMemoryBarrier();
+    prec->seq = seq;
+    epicsAtomicWriteMemoryBarrier();
+    phist->phdr->head = seq;
+    phist->head = seq;
+    epicsMutexUnlock(phist->lock);
+}
+
+
+/****************************************************************************
+ * Define private poll scheduler methods
+ ****************************************************************************/
+static void initGroup(Group* pgrp,GroupKind kind,double period)
+{
+    pgrp->period  = period;
+    pgrp->reads   = (kind == groupFast)?K_FASTREAD:K_SLOWREAD;
+    pgrp->trigger = (kind == groupFast)?parFastPoll:parSlowPoll;
+    pgrp->late    = (kind == groupFast)?parFastLate:parSlowLate;
+    pgrp->jitter  = (kind == groupFast)?parFastJitter:parSlowJitter;
+
+    /* Slow slots fall halfway between their neighbours */
+    pgrp->offset  = (kind == groupFast)?0.0:0.5;
+}
+
+
+static void startCycle(Port* pport,Group* pgrp,const epicsTimeStamp* pnow,int isFirst)
+{
+    int i;
+
+    if( isFirst )
+        pgrp->start = *pnow;
+    else
+    {
+        /* Deadlines are absolute, a late cycle does not shift the next */
+        epicsTimeAddSeconds(&pgrp->start,pgrp->period);
+        while( epicsTimeDiffInSeconds(pnow,&pgrp->start) > pgrp->period )
+        {
+            epicsTimeAddSeconds(&pgrp->start,pgrp->period);
+            ++pgrp->overruns;
+        }
+
+        setParam(pport,pgrp->late,(epicsInt32)(pgrp->cycleLate * 1.0e6));
+        setParam(pport,pgrp->jitter,(epicsInt32)(pgrp->cycleJitter * 1.0e6));
+
+        if( pgrp == sweepGroup(pport) )
+            refreshList(pport);
+    }
+
+    pgrp->count = 0;
+    for( i = 0; i < K_INSTRMAX; ++i )
+        if( pport->instr[i].isConfig )
+            pgrp->addrs[pgrp->count++] = i + 1;
+
+    pgrp->slot = 0;
+    pgrp->cycleLate = 0.0;
+    pgrp->cycleJitter = 0.0;
+
+    pgrp->next = pgrp->start;
+    if( pgrp->count )
+        epicsTimeAddSeconds(&pgrp->next,pgrp->offset * pgrp->period / pgrp->count);
+    else
+        epicsTimeAddSeconds(&pgrp->next,pgrp->period);
+}
+
+
+static void firePoll(Port* pport,Group* pgrp,const epicsTimeStamp* pnow)
+{
+    double late,jitter;
+    Instr* pinfo;
+
+    if( pgrp->slot < pgrp->count )
+    {
+        late = epicsTimeDiffInSeconds(pnow,&pgrp->next);
+        pgrp->lateSum += late;
+        if( late > pgrp->lateMax )
+            pgrp->lateMax = late;
+        if( late > pgrp->cycleLate )
+            pgrp->cycleLate = late;
+
+        /* Jitter is the deviation of the spacing from the nominal slot */
+        if( pgrp->isLast )
+        {
+            jitter = fabs(epicsTimeDiffInSeconds(pnow,&pgrp->last) - (pgrp->period / pgrp->count));
+            pgrp->jitterSum += jitter;
+            if( jitter > pgrp->jitterMax )
+                pgrp->jitterMax = jitter;
+            if( jitter > pgrp->cycleJitter )
+                pgrp->cycleJitter = jitter;
+        }
+
+        pgrp->last = *pnow;
+        pgrp->isLast = 1;
+        ++pgrp->fires;
+
+        pinfo = &pport->instr[pgrp->addrs[pgrp->slot] - 1];
+        if( (pinfo->isConfig == 0) || skipPoll(pport,pinfo,(int)(pgrp - pport->groups),pnow) )
+            ++pgrp->slot;
+        else
+        {
+            pinfo->trigStamp[(unsigned)pinfo->trigCount % K_TRIGMAX] = *pnow;
+            pinfo->trigGroup[(unsigned)pinfo->trigCount % K_TRIGMAX] = (int)(pgrp - pport->groups);
+            epicsAtomicIncrIntT(&pinfo->trigCount);
+
+            triggerPoll(pport,pgrp->trigger,pgrp->addrs[pgrp->slot++],(epicsInt32)pgrp->fires);
+        }
+    }
+
+    if( pgrp->slot >= pgrp->count )
+        startCycle(pport,pgrp,pnow,0);
+    else
+    {
+        pgrp->next = pgrp->start;
+        epicsTimeAddSeconds(&pgrp->next,(pgrp->slot + pgrp->offset) * pgrp->period / pgrp->count);
+    }
+}
+
+
+static void triggerPoll(Port* pport,Param par,int addr,epicsInt32 value)
+{
+    Inst* pinst;
+    ELLLIST* plist;
+    interruptNode* pnode;
+    asynInt32Interrupt* pint;
+
+    pasynManager->interruptStart(pport->asynInt32Pvt,&plist);
+    for( pnode = (interruptNode*)ellFirst(plist); pnode; pnode = (interruptNode*)ellNext(&pnode->node) )
+    {
+        pint = (asynInt32Interrupt*)pnode->drvPvt;
+        pinst = (Inst*)pint->pasynUser->drvUser;
+        if( pinst && (pinst->param == par) && (pinst->addr == addr) )
+            pint->callback(pint->userPvt,pint->pasynUser,value);
+    }
+    pasynManager->interruptEnd(pport->asynInt32Pvt);
+}
+
+
+static void pollThread(void* parm)
+{
+    int i;
+    double delay;
+    Group* pgrp;
+    epicsTimeStamp now;
+    Port* pport = (Port*)parm;
+
+    applySched(pport,"poll");
+
+    epicsTimeGetCurrent(&now);
+    pport->busStamp = now;
+    for( i = 0; i < groupCount; ++i )
+        if( pport->groups[i].period > 0.0 )
+            startCycle(pport,&pport->groups[i],&now,1);
+
+    for( ;; )
+    {
+        pgrp = NULL;
+        for( i = 0; i < groupCount; ++i )
+            if( (pport->groups[i].period > 0.0) && ((pgrp == NULL) || epicsTimeLessThan(&pport->groups[i].next,&pgrp->next)) )
+                pgrp = &pport->groups[i];
+
+        if( pgrp == NULL )
+            break;
+
+        /* Sleep to the absolute deadline of the earliest slot */
+        epicsTimeGetCurrent(&now);
+        delay = epicsTimeDiffInSeconds(&pgrp->next,&now);
+        if( delay > 0.0 )
+        {
+            epicsThreadSleep(delay);
+            epicsTimeGetCurrent(&now);
+            noteLatency(pport,latPoll,epicsTimeDiffInSeconds(&now,&pgrp->next));
+        }
+
+        firePoll(pport,pgrp,&now);
+        updateBus(pport,&now);
+    }
+}
+
+
+static int skipPoll(Port* pport,Instr* pinfo,int grp,const epicsTimeStamp* pnow)
+{
+    int i,isIdle;
+    dbCommon* precord;
+
+    /* Idle when none of the records this poll processes has a monitor, the monitor list is guarded by the record lock */
+    isIdle = (pport->idle > 0.0) && pinfo->nWatch[grp];
+    for( i = 0; isIdle && (i < pinfo->nWatch[grp]); ++i )
+    {
+        precord = pinfo->watch[grp][i];
+        dbScanLock(precord);
+        if( ellCount(&precord->mlis) )
+            isIdle = 0;
+        dbScanUnlock(precord);
+    }
+
+    if( isIdle != pinfo->isIdle[grp] )
+    {
+        pinfo->isIdle[grp] = isIdle;
+        pport->nIdle += (isIdle)?1:-1;
+        setParam(pport,parIdleCount,pport->nIdle);
+    }
+
+    /* An idle controller keeps a background poll, its slot stays reserved */
+    if( isIdle && (epicsTimeDiffInSeconds(pnow,&pinfo->polled[grp]) < pport->idle) )
+        return( 1 );
+
+    pinfo->polled[grp] = *pnow;
+
+    return( 0 );
+}
+
+
+static void addWatch(Instr* pinfo,int grp,dbCommon* precord)
+{
+    int i;
+
+    for( i = 0; i < pinfo->nWatch[grp]; ++i )
+        if( pinfo->watch[grp][i] == precord )
+            return;
+
+    if( (pinfo->nWatch[grp] % 8) == 0 )
+    {
+        pinfo->watch[grp] = realloc(pinfo->watch[grp],(pinfo->nWatch[grp] + 8) * sizeof(dbCommon*));
+        if( pinfo->watch[grp] == NULL )
+            cantProceed("drvLove::addWatch");
+    }
+    pinfo->watch[grp][pinfo->nWatch[grp]++] = precord;
+}
+
+/****************************************************************************
+ * Define private set point ramp methods
+ ****************************************************************************/
+static asynStatus writeRamp(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32 value)
+{
+    RampPar par = (RampPar)(pinst->ramp % rpCount);
+    Ramp* pramp = &pinst->pinfo->ramps[pinst->ramp / rpCount];
+
+    if( (par == rpCurrent) || ((par == rpState) && (value != rampIdle)) )
+    {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s %s is read-only, write 0 to abort",pport->name,rampNames[pramp->idx][par]);
+        return( asynError );
+    }
+
+    if( (par == rpRate) && (value < 0) )
+    {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s %s must not be negative",pport->name,rampNames[pramp->idx][par]);
+        return( asynError );
+    }
+
+    if( par == rpPeriod )
+        value = (value < K_RAMPMIN)?K_RAMPMIN:value;
+
+    epicsMutexMustLock(pport->rampLock);
+
+    /* A new rate continues from the last set point written */
+    if( (par == rpRate) && (pramp->pars[rpState] == rampActive) && pramp->isOrigin )
+    {
+        pramp->origin = pramp->pars[rpCurrent];
+        epicsTimeGetCurrent(&pramp->start);
+    }
+
+    pramp->pars[par] = value;
+
+    /* A new target starts the ramp from the present set point */
+    if( par == rpTarget )
+    {
+        pramp->isOrigin = 0;
+        pramp->pars[rpState] = rampActive;
+        epicsTimeGetCurrent(&pramp->next);
+    }
+
+    epicsMutexUnlock(pport->rampLock);
+
+    rampCallback(pport,pramp,par);
+    if( par == rpTarget )
+    {
+        rampCallback(pport,pramp,rpState);
+        if( interruptAccept )
+            startRamp(pport,0);
+        epicsEventSignal(pport->rampWake);
+    }
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::writeRamp %s addr %d %s %d\n",pport->name,pramp->addr,rampNames[pramp->idx][par],value);
+
+    return( asynSuccess );
+}
+
+
+static void rampStep(asynUser* pasynUser)
+{
+    int isLast;
+    double step,span;
+    asynStatus sts;
+    epicsInt32 value,target;
+    epicsTimeStamp now;
+    Inst inst;
+    Reg* preg;
+    Port* pport = (Port*)pasynUser->userPvt;
+    Ramp* pramp = (Ramp*)pasynUser->userData;
+
+    initInst(&inst,pport,pramp->addr,findCommand(rampRegs[pramp->idx]));
+    preg = &inst.pinfo->regs[inst.cmdidx];
+
+    epicsMutexMustLock(pport->rampLock);
+    pramp->isQueued = 0;
+    if( pramp->pars[rpState] != rampActive )
+    {
+        epicsMutexUnlock(pport->rampLock);
+        return;
+    }
+    epicsMutexUnlock(pport->rampLock);
+
+    /* The origin is read from the controller, a cached value may predate a front panel change */
+    if( pramp->isOrigin == 0 )
+    {
+        sts = readCommand(pport,&inst,pasynUser,&value);
+
+        epicsMutexMustLock(pport->rampLock);
+        if( ISOK(sts) )
+        {
+            pramp->origin = value;
+            pramp->pars[rpCurrent] = value;
+            pramp->isOrigin = 1;
+            epicsTimeGetCurrent(&pramp->start);
+        }
+        else
+            pramp->pars[rpState] = rampFailed;
+        epicsMutexUnlock(pport->rampLock);
+
+        if( ISNOTOK(sts) )
+        {
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::rampStep %s addr %d failure to read %s\n",pport->name,pramp->addr,rampRegs[pramp->idx]);
+            rampCallback(pport,pramp,rpState);
+            return;
+        }
+    }
+
+    /* The set point follows the elapsed time, steps missed on a busy bus coalesce */
+    epicsTimeGetCurrent(&now);
+    epicsMutexMustLock(pport->rampLock);
+    target = pramp->pars[rpTarget];
+    span = (double)target - pramp->origin;
+    step = pramp->pars[rpRate] * epicsTimeDiffInSeconds(&now,&pramp->start) / 60.0;
+    if( (pramp->pars[rpRate] == 0) || (step >= fabs(span)) )
+        value = target;
+    else
+        value = pramp->origin + (epicsInt32)((span < 0.0)?-step:step);
+    isLast = (value == target);
+    epicsMutexUnlock(pport->rampLock);
+
+    sts = asynSuccess;
+    if( (value != preg->value) || (preg->isValid == 0) || isLast )
+        sts = writeCommand(pport,&inst,pasynUser,value);
+
+    epicsMutexMustLock(pport->rampLock);
+    ++pramp->steps;
+    if( ISOK(sts) )
+        pramp->pars[rpCurrent] = value;
+    if( pramp->pars[rpState] == rampActive )
+        pramp->pars[rpState] = ISNOTOK(sts)?rampFailed:(isLast && (target == pramp->pars[rpTarget]))?rampDone:rampActive;
+    epicsMutexUnlock(pport->rampLock);
+
+    if( ISNOTOK(sts) )
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::rampStep %s addr %d failure to write %s\n",pport->name,pramp->addr,rampRegs[pramp->idx]);
+
+    rampCallback(pport,pramp,rpCurrent);
+    rampCallback(pport,pramp,rpState);
+}
+
+
+static void rampCallback(Port* pport,Ramp* pramp,RampPar par)
+{
+    Inst* pinst;
+    ELLLIST* plist;
+    interruptNode* pnode;
+    asynInt32Interrupt* pint;
+    int ramp = (pramp->idx * rpCount) + par;
+
+    pasynManager->interruptStart(pport->asynInt32Pvt,&plist);
+    for( pnode = (interruptNode*)ellFirst(plist); pnode; pnode = (interruptNode*)ellNext(&pnode->node) )
+    {
+        pint = (asynInt32Interrupt*)pnode->drvPvt;
+        pinst = (Inst*)pint->pasynUser->drvUser;
+        if( pinst && (pinst->ramp == ramp) && (pinst->addr == pramp->addr) )
+            pint->callback(pint->userPvt,pint->pasynUser,pramp->pars[par]);
+    }
+    pasynManager->interruptEnd(pport->asynInt32Pvt);
+}
+
+
+static void startRamp(Port* pport,int onlyActive)
+{
+    int i,j,isActive;
+
+    /* Ports without a ramp target get no thread; one written during iocInit waits for the hook */
+    epicsMutexMustLock(pport->rampLock);
+    isActive = (onlyActive == 0);
+    for( i = 0; (isActive == 0) && (i < K_INSTRMAX); ++i )
+        for( j = 0; j < K_RAMPMAX; ++j )
+            if( pport->instr[i].ramps[j].pars[rpState] == rampActive )
+                isActive = 1;
+    if( isActive && (pport->rampTid == NULL) )
+        pport->rampTid = epicsThreadMustCreate("loveRamp",schedPriority(pport,epicsThreadPriorityScanHigh),epicsThreadGetStackSize(epicsThreadStackSmall),rampThread,pport);
+    epicsMutexUnlock(pport->rampLock);
+}
+
+static void rampThread(void* parm)
+{
+    int i,j;
+    double delay;
+    Ramp* pramp;
+    Ramp* pnext;
+    epicsTimeStamp now,due;
+    Port* pport = (Port*)parm;
+
+    applySched(pport,"ramp");
+
+    for( ;; )
+    {
+        /* Find the earliest step that is due and not already waiting on the queue */
+        pnext = NULL;
+        epicsMutexMustLock(pport->rampLock);
+        for( i = 0; i < K_INSTRMAX; ++i )
+            for( j = 0; j < K_RAMPMAX; ++j )
+            {
+                pramp = &pport->instr[i].ramps[j];
+                if( (pramp->pars[rpState] != rampActive) || pramp->isQueued )
+                    continue;
+                if( (pnext == NULL) || epicsTimeLessThan(&pramp->next,&pnext->next) )
+                    pnext = pramp;
+            }
+
+        epicsTimeGetCurrent(&now);
+        delay = (pnext)?epicsTimeDiffInSeconds(&pnext->next,&now):0.0;
+        if( pnext )
+            due = pnext->next;
+        if( pnext && (delay <= 0.0) )
+        {
+            /* Deadlines are absolute, a late step does not shift the next */
+            pnext->isQueued = 1;
+            epicsTimeAddSeconds(&pnext->next,pnext->pars[rpPeriod] / 1000.0);
+            while( epicsTimeLessThan(&pnext->next,&now) )
+            {
+                epicsTimeAddSeconds(&pnext->next,pnext->pars[rpPeriod] / 1000.0);
+                ++pnext->late;
+            }
+        }
+        epicsMutexUnlock(pport->rampLock);
+
+        if( pnext == NULL )
+            epicsEventMustWait(pport->rampWake);
+        else if( delay > 0.0 )
+        {
+            /* Only a timeout is a wakeup at the deadline, a signal is a new ramp */
+            if( epicsEventWaitWithTimeout(pport->rampWake,delay) == epicsEventWaitTimeout )
+            {
+                epicsTimeGetCurrent(&now);
+                noteLatency(pport,latRamp,epicsTimeDiffInSeconds(&now,&due));
+            }
+        }
+        else if( ISNOTOK(queuePort(pport,pnext->pasynUser,rampStep,asynQueuePriorityHigh)) )
+        {
+            epicsMutexMustLock(pport->rampLock);
+            pnext->isQueued = 0;
+            pnext->pars[rpState] = rampFailed;
+            epicsMutexUnlock(pport->rampLock);
+            rampCallback(pport,pnext,rpState);
+        }
+    }
+}
+
+
+/****************************************************************************
+ * Define private port-wide overview methods
+ ****************************************************************************/
+static Group* sweepGroup(Port* pport)
+{
+    /* A sweep is one fast cycle, or one slow cycle when fast polling is off */
+    if( pport->groups[groupFast].period > 0.0 )
+        return( &pport->groups[groupFast] );
+    if( pport->groups[groupSlow].period > 0.0 )
+        return( &pport->groups[groupSlow] );
+
+    return( NULL );
+}
+
+
+static void buildList(asynUser* pasynUser)
+{
+    int i,decpts;
+    Reg* preg;
+    Instr* pinfo;
+    Port* pport = (Port*)pasynUser->userPvt;
+    List* plist = &pport->list;
+
+    /* Runs on the port thread, every entry shares the sweep timestamp */
+    epicsTimeGetCurrent(&plist->stamp);
+
+    plist->count = 0;
+    for( i = 0; i < K_INSTRMAX; ++i )
+    {
+        pinfo = &pport->instr[i];
+        if( pinfo->isConfig == 0 )
+            continue;
+
+        plist->addrs[plist->count] = i + 1;
+
+        preg = &pinfo->regs[cmdAlSts];
+        plist->alsts[plist->count] = (preg->isValid)?preg->value:-1;
+
+        preg = &pinfo->regs[cmdDecpts];
+        decpts = (preg->isValid && (preg->value > 0) && (preg->value < 4))?preg->value:0;
+
+        preg = &pinfo->regs[cmdValue];
+        if( preg->isValid )
+        {
+            plist->values[plist->count] = preg->value / pow(10.0,decpts);
+            plist->ages[plist->count] = epicsTimeDiffInSeconds(&plist->stamp,&preg->stamp);
+        }
+        else
+        {
+            plist->values[plist->count] = 0.0;
+            plist->ages[plist->count] = -1.0;
+        }
+
+        ++plist->count;
+    }
+
+    ++plist->sweeps;
+    epicsAtomicSetIntT(&plist->isQueued,0);
+
+    callbackList(pport,parListAddr,plist->addrs,(size_t)plist->count,&plist->stamp);
+    callbackList(pport,parListAlSts,plist->alsts,(size_t)plist->count,&plist->stamp);
+    callbackList(pport,parListValue,plist->values,(size_t)plist->count,&plist->stamp);
+    callbackList(pport,parListAge,plist->ages,(size_t)plist->count,&plist->stamp);
+}
+
+
+static void refreshList(Port* pport)
+{
+    List* plist = &pport->list;
+
+    /* Queued behind the reads of the sweep, a slow port skips rather than piles up */
+    if( epicsAtomicCmpAndSwapIntT(&plist->isQueued,0,1) != 0 )
+        return;
+
+    if( ISNOTOK(queuePort(pport,plist->pasynUser,buildList,asynQueuePriorityLow)) )
+        epicsAtomicSetIntT(&plist->isQueued,0);
+}
+
+
+static void callbackList(Port* pport,Param par,void* data,size_t count,const epicsTimeStamp* pstamp)
+{
+    Inst* pinst;
+    ELLLIST* plist;
+    interruptNode* pnode;
+
+    if( (par == parListAddr) || (par == parListAlSts) || (par == parTopAddr) || (par == parTopCmd) || (par == parSnapAddr) || (par == parSnapCmd) )
+    {
+        asynInt32ArrayInterrupt* pint;
+
+        pasynManager->interruptStart(pport->asynInt32ArrayPvt,&plist);
+        for( pnode = (interruptNode*)ellFirst(plist); pnode; pnode = (interruptNode*)ellNext(&pnode->node) )
+        {
+            pint = (asynInt32ArrayInterrupt*)pnode->drvPvt;
+            pinst = (Inst*)pint->pasynUser->drvUser;
+            if( (pinst == NULL) || (pinst->param != par) )
+                continue;
+            pint->pasynUser->timestamp = *pstamp;
+            pint->callback(pint->userPvt,pint->pasynUser,(epicsInt32*)data,count);
+        }
+        pasynManager->interruptEnd(pport->asynInt32ArrayPvt);
+    }
+    else
+    {
+        asynFloat64ArrayInterrupt* pint;
+
+        pasynManager->interruptStart(pport->asynFloat64ArrayPvt,&plist);
+        for( pnode = (interruptNode*)ellFirst(plist); pnode; pnode = (interruptNode*)ellNext(&pnode->node) )
+        {
+            pint = (asynFloat64ArrayInterrupt*)pnode->drvPvt;
+            pinst = (Inst*)pint->pasynUser->drvUser;
+            if( (pinst == NULL) || (pinst->param != par) )
+                continue;
+            pint->pasynUser->timestamp = *pstamp;
+            pint->callback(pint->userPvt,pint->pasynUser,(epicsFloat64*)data,count);
+        }
+        pasynManager->interruptEnd(pport->asynFloat64ArrayPvt);
+    }
+}
+
+
+/****************************************************************************
+ * Define private bus-time accounting methods
+ ****************************************************************************/
+static void chargeTrans(Port* pport,Trans* ptrans,asynStatus sts,double held)
+{
+    int i;
+    double wait,retry;
+    Acct* paccts[2];
+    Inst* pinst = ptrans->pinst;
+
+    /* Runs with the port lock held; a failed transaction is retry cost throughout */
+    wait = epicsTimeDiffInSeconds(&ptrans->tsLock,&ptrans->tsTake);
+    retry = ISOK(sts)?ptrans->retryTime:held;
+    paccts[0] = &pinst->pinfo->regs[pinst->cmdidx].acct;
+    paccts[1] = &pinst->acct;
+
+    for( i = 0; i < 2; ++i )
+    {
+        paccts[i]->count++;
+        paccts[i]->retries += (unsigned long)ptrans->retries;
+        paccts[i]->wire += held - retry;
+        paccts[i]->retry += retry;
+        paccts[i]->wait += (wait > 0.0)?wait:0.0;
+    }
+}
+
+
+static void buildTop(Port* pport)
+{
+    int i,addr,cmdidx;
+    double elapsed,cost;
+    epicsTimeStamp now;
+    Acct* pacct;
+    Top* ptop = &pport->top;
+
+    epicsTimeGetCurrent(&now);
+    elapsed = epicsTimeDiffInSeconds(&now,&ptop->stamp);
+    if( elapsed < 1.0 )
+        return;
+
+    /* Shares cover the time since the previous update, the accounts are cumulative */
+    ptop->count = 0;
+    for( cmdidx = 0; cmdidx < cmdCount; ++cmdidx )
+        ptop->cmdShares[cmdidx] = 0.0;
+
+    for( addr = 1; addr <= K_INSTRMAX; ++addr )
+    {
+        if( pport->instr[addr - 1].isConfig == 0 )
+            continue;
+
+        for( cmdidx = 0; cmdidx < cmdCount; ++cmdidx )
+        {
+            pacct = &pport->instr[addr - 1].regs[cmdidx].acct;
+            cost = pacct->wire + pacct->retry - pacct->mark;
+            pacct->mark += cost;
+            if( cost <= 0.0 )
+                continue;
+
+            cost = 100.0 * cost / elapsed;
+            ptop->cmdShares[cmdidx] += cost;
+
+            for( i = ptop->count; (i > 0) && (ptop->shares[i - 1] < cost); --i )
+            {
+                if( i == K_TOPMAX )
+                    continue;
+                ptop->addrs[i] = ptop->addrs[i - 1];
+                ptop->cmds[i] = ptop->cmds[i - 1];
+                ptop->shares[i] = ptop->shares[i - 1];
+            }
+            if( i == K_TOPMAX )
+                continue;
+
+            ptop->addrs[i] = addr;
+            ptop->cmds[i] = cmdidx;
+            ptop->shares[i] = cost;
+            if( ptop->count < K_TOPMAX )
+                ptop->count++;
+        }
+    }
+
+    ptop->stamp = now;
+}
+
+
+static void publishTop(Port* pport)
+{
+    Top* ptop = &pport->top;
+
+    callbackList(pport,parTopAddr,ptop->addrs,(size_t)ptop->count,&ptop->stamp);
+    callbackList(pport,parTopCmd,ptop->cmds,(size_t)ptop->count,&ptop->stamp);
+    callbackList(pport,parTopShare,ptop->shares,(size_t)ptop->count,&ptop->stamp);
+    callbackList(pport,parCmdShare,ptop->cmdShares,(size_t)cmdCount,&ptop->stamp);
+}
+
+
+static void resetAcct(Port* pport)
+{
+    int i;
+    Inst* pinst;
+
+    lockPort(pport,pport->pasynUser);
+    for( i = 0; i < (K_INSTRMAX * K_CMDMAX); ++i )
+        memset(&pport->instr[i / K_CMDMAX].regs[i % K_CMDMAX].acct,0,sizeof(Acct));
+
+    epicsMutexMustLock(pport->instLock);
+    for( pinst = pport->pinsts; pinst; pinst = pinst->pnext )
+        memset(&pinst->acct,0,sizeof(Acct));
+    epicsMutexUnlock(pport->instLock);
+
+    epicsTimeGetCurrent(&pport->acctStamp);
+    pport->top.stamp = pport->acctStamp;
+    unlockPort(pport,pport->pasynUser);
+}
+
+
+static void scanRecords(Port* pport)
+{
+    int i,j,grp,addr,cmdidx;
+    long stsType,stsRec,stsFld;
+    size_t len;
+    Inst* pinst;
+    Instr* pinfo;
+    DBADDR dbaddr;
+    DBENTRY entry,link;
+    char* plink;
+    char* pend;
+    char info[40];
+    char name[PVNAME_STRINGSZ];
+    static const char* fields[] = {"INP","OUT"};
+
+    if( pdbbase == NULL )
+        return;
+
+    /* Device support does not pass the record down, match "@asyn(PORT,ADDR,...)drvInfo" links instead */
+    dbInitEntry(pdbbase,&entry);
+    dbInitEntry(pdbbase,&link);
+    for( stsType = dbFirstRecordType(&entry); stsType == 0; stsType = dbNextRecordType(&entry) )
+        for( stsRec = dbFirstRecord(&entry); stsRec == 0; stsRec = dbNextRecord(&entry) )
+            for( i = 0; i < 2; ++i )
+            {
+                if( dbFindField(&entry,fields[i]) )
+                    continue;
+                plink = dbGetString(&entry);
+                if( (plink == NULL) || strncmp(plink,"@asyn",5) || ((plink = strchr(plink,'(')) == NULL) )
+                    continue;
+
+                for( ++plink; *plink == ' '; ++plink );
+                len = strcspn(plink,", )");
+                if( (len != strlen(pport->name)) || epicsStrnCaseCmp(plink,pport->name,len) || (plink[len] != ',') )
+                    continue;
+                addr = (int)strtol(plink + len + 1,NULL,0);
+
+                if( (pend = strchr(plink,')')) == NULL )
+                    continue;
+                for( ++pend; *pend == ' '; ++pend );
+                len = strcspn(pend," \t");
+                if( (len == 0) || (len >= sizeof(info)) )
+                    continue;
+                memcpy(info,pend,len);
+                info[len] = '\0';
+
+                /* A poll trigger watches every record its scan processes */
+                grp = (epicsStrCaseCmp(info,ParamName[parFastPoll]) == 0)?groupFast:((epicsStrCaseCmp(info,ParamName[parSlowPoll]) == 0)?groupSlow:-1);
+                if( grp >= 0 )
+                {
+                    if( (addr < 1) || (addr > K_INSTRMAX) || dbNameToAddr(dbGetRecordName(&entry),&dbaddr) )
+                        continue;
+
+                    pinfo = &pport->instr[addr - 1];
+                    addWatch(pinfo,grp,dbaddr.precord);
+                    for( j = 0; j < pinfo->nWatch[grp]; ++j )
+                    {
+                        if( dbFindRecord(&link,pinfo->watch[grp][j]->name) )
+                            continue;
+                        for( stsFld = dbFirstField(&link,1); stsFld == 0; stsFld = dbNextField(&link,1) )
+                        {
+                            int type = dbGetFieldType(&link);
+
+                            if( (type != DBF_FWDLINK) && (type != DBF_INLINK) && (type != DBF_OUTLINK) )
+                                continue;
+                            plink = dbGetString(&link);
+                            if( (plink == NULL) || (strchr("@#-.0123456789",plink[0]) != NULL) )
+                                continue;
+                            if( (type != DBF_FWDLINK) && (strstr(plink," PP") == NULL) )
+                                continue;
+
+                            len = strcspn(plink,". \t");
+                            if( (len == 0) || (len >= sizeof(name)) )
+                                continue;
+                            memcpy(name,plink,len);
+                            name[len] = '\0';
+                            if( dbNameToAddr(name,&dbaddr) == 0 )
+                                addWatch(pinfo,grp,dbaddr.precord);
+                        }
+                    }
+                    continue;
+                }
+
+                if( (cmdidx = findCommand(info)) < 0 )
+                    continue;
+
+                /* Records sharing a register take its instances in turn */
+                epicsMutexMustLock(pport->instLock);
+                for( pinst = pport->pinsts; pinst; pinst = pinst->pnext )
+                    if( (pinst->owner == NULL) && (pinst->addr == addr) && (pinst->cmdidx == cmdidx) )
+                    {
+                        pinst->owner = dbGetRecordName(&entry);
+                        break;
+                    }
+                epicsMutexUnlock(pport->instLock);
+            }
+    dbFinishEntry(&link);
+    dbFinishEntry(&entry);
+}
+
+
+static int cmpRank(const void* p1,const void* p2)
+{
+    const Rank* prank1 = (const Rank*)p1;
+    const Rank* prank2 = (const Rank*)p2;
+    double cost1 = prank1->acct.wire + prank1->acct.retry;
+    double cost2 = prank2->acct.wire + prank2->acct.retry;
+
+    return( (cost1 < cost2)?1:((cost1 > cost2)?-1:0) );
+}
+
+
+static void printRank(Rank* pranks,int count,int max,double elapsed)
+{
+    int i;
+    char addr[8];
+    Rank* prank;
+
+    qsort(pranks,(size_t)count,sizeof(Rank),cmpRank);
+
+    printf("    %-28s %4s %-8s %8s %7s %9s %9s %9s %6s\n","Record","Addr","Command","Trans","Retries","Wire","Retry","Wait","Line%");
+    for( i = 0; (i < count) && (i < max); ++i )
+    {
+        prank = &pranks[i];
+        /* Command totals show the index TopCmd and CmdShare use */
+        if( prank->addr > 0 )
+            sprintf(addr,"%d",prank->addr);
+        else
+            sprintf(addr,"#%d",prank->cmdidx);
+        printf("    %-28s %4s %-8s %8lu %7lu %9.3f %9.3f %9.3f %6.1f\n",(prank->name)?prank->name:"-",addr,CmdTable[prank->cmdidx].pname,
+               prank->acct.count,prank->acct.retries,prank->acct.wire,prank->acct.retry,prank->acct.wait,
+               (elapsed > 0.0)?(100.0 * (prank->acct.wire + prank->acct.retry) / elapsed):0.0);
+    }
+}
+
+
+/****************************************************************************
+ * Define private real-time scheduling methods
+ ****************************************************************************/
+static int parseCpus(Sched* psched,const char* cpus)
+{
+    long lo,hi;
+    char* pend;
+    const char* p = cpus;
+
+    memset(psched->cpus,0,sizeof(psched->cpus));
+    psched->nCpus = 0;
+    if( (p == NULL) || (strlen(p) == 0) )
+        return( 0 );
+
+    /* Comma separated CPU numbers and ranges, i.e. "1,4-5" */
+    for( ;; )
+    {
+        lo = strtol(p,&pend,10);
+        if( (pend == p) || (lo < 0) || (lo >= K_CPUMAX) )
+            return( -1 );
+        hi = lo;
+        p = pend;
+        if( *p == '-' )
+        {
+            hi = strtol(++p,&pend,10);
+            if( (pend == p) || (hi < lo) || (hi >= K_CPUMAX) )
+                return( -1 );
+            p = pend;
+        }
+
+        for( ; lo <= hi; ++lo )
+            if( psched->cpus[lo] == 0 )
+            {
+                psched->cpus[lo] = 1;
+                ++psched->nCpus;
+            }
+
+        if( *p == '\0' )
+            return( 0 );
+        if( *p++ != ',' )
+            return( -1 );
+    }
+}
+
+
+static unsigned int schedPriority(Port* pport,unsigned int prio)
+{
+    return( (pport->sched.prio > 0)?(unsigned int)pport->sched.prio:prio );
+}
+
+
+static void applySched(Port* pport,const char* who)
+{
+    Sched* psched = &pport->sched;
+#ifdef USE_SCHED
+    int i,lo,hi,sts;
+    cpu_set_t set;
+    struct sched_param param;
+#endif
+
+    if( psched->prio > 0 )
+        epicsThreadSetPriority(epicsThreadGetIdSelf(),psched->prio);
+
+#ifdef USE_SCHED
+    if( psched->isFifo )
+    {
+        /* The EPICS priority is spread over the SCHED_FIFO range */
+        lo = sched_get_priority_min(SCHED_FIFO);
+        hi = sched_get_priority_max(SCHED_FIFO);
+        param.sched_priority = lo + ((int)schedPriority(pport,epicsThreadPriorityScanHigh) * (hi - lo)) / epicsThreadPriorityMax;
+        sts = pthread_setschedparam(pthread_self(),SCHED_FIFO,&param);
+        if( sts )
+        {
+            printf("drvLove::applySched %s %s thread SCHED_FIFO %d failed, %s\n",pport->name,who,param.sched_priority,strerror(sts));
+            epicsAtomicIncrIntT(&psched->nFailed);
+        }
+    }
+
+    if( psched->nCpus )
+    {
+        CPU_ZERO(&set);
+        for( i = 0; i < K_CPUMAX; ++i )
+            if( psched->cpus[i] )
+                CPU_SET(i,&set);
+        sts = pthread_setaffinity_np(pthread_self(),sizeof(set),&set);
+        if( sts )
+        {
+            printf("drvLove::applySched %s %s thread CPU affinity failed, %s\n",pport->name,who,strerror(sts));
+            epicsAtomicIncrIntT(&psched->nFailed);
+        }
+    }
+#endif
+}
+
+
+static void lockMemory(Port* pport)
+{
+#ifdef USE_MMAP
+    Sched* psched = &pport->sched;
+
+    /* The port allocation holds the transaction pool, register cache and overview */
+    if( mlock(pport,psched->size) )
+    {
+        printf("drvLove::lockMemory %s failure to lock %lu bytes, %s\n",pport->name,(unsigned long)psched->size,strerror(errno));
+        ++psched->nFailed;
+        return;
+    }
+    psched->isLocked = 1;
+
+    if( pport->phist && mlock(pport->phist->pdata,pport->phist->size) )
+    {
+        printf("drvLove::lockMemory %s failure to lock history %s, %s\n",pport->name,pport->phist->file,strerror(errno));
+        ++psched->nFailed;
+    }
+#endif
+}
+
+
+static void noteLatency(Port* pport,LatKind kind,double delay)
+{
+    Lat* plat = &pport->sched.lats[kind];
+
+    if( delay < 0.0 )
+        delay = 0.0;
+
+    epicsMutexMustLock(pport->sched.lock);
+    ++plat->count;
+    plat->sum += delay;
+    if( delay > plat->max )
+        plat->max = delay;
+    if( delay > plat->peak )
+        plat->peak = delay;
+    epicsMutexUnlock(pport->sched.lock);
+}
+
+
+static void probeSched(Port* pport)
+{
+    Sched* psched = &pport->sched;
+
+    /* An event port has no port thread to schedule */
+    if( pport->bus.isEngine )
+        return;
+
+    /* One probe in flight, queued ahead of the reads like a ramp step */
+    if( epicsAtomicCmpAndSwapIntT(&psched->isQueued,0,1) != 0 )
+        return;
+
+    epicsTimeGetCurrent(&psched->queued);
+    psched->held = pport->lockTime;
+    if( ISNOTOK(pasynManager->queueRequest(psched->pasynUser,asynQueuePriorityHigh,0.0)) )
+        epicsAtomicSetIntT(&psched->isQueued,0);
+}
+
+
+static void schedPort(asynUser* pasynUser)
+{
+    double delay;
+    epicsTimeStamp now;
+    Port* pport = (Port*)pasynUser->userPvt;
+    Sched* psched = &pport->sched;
+
+    epicsTimeGetCurrent(&now);
+
+    /* Time spent on transactions that held the port is queueing, not scheduling */
+    delay = epicsTimeDiffInSeconds(&now,&psched->queued) - (pport->lockTime - psched->held);
+    if( psched->isApplied )
+        noteLatency(pport,latPort,delay);
+    else
+    {
+        applySched(pport,"port");
+        psched->isApplied = 1;
+    }
+
+    epicsAtomicSetIntT(&psched->isQueued,0);
+}
+
+
+static void publishLatency(Port* pport)
+{
+    double wake;
+    Lat* plats = pport->sched.lats;
+
+    epicsMutexMustLock(pport->sched.lock);
+    wake = (plats[latPoll].peak > plats[latRamp].peak)?plats[latPoll].peak:plats[latRamp].peak;
+    setParam(pport,parWakeLatency,(epicsInt32)((wake * 1.0e6) + 0.5));
+    setParam(pport,parDispatchLatency,(epicsInt32)((plats[latPort].peak * 1.0e6) + 0.5));
+    plats[latPoll].peak = 0.0;
+    plats[latRamp].peak = 0.0;
+    plats[latPort].peak = 0.0;
+    epicsMutexUnlock(pport->sched.lock);
+}
+
+
+/****************************************************************************
+ * Define private live bus benchmark methods
+ ****************************************************************************/
+static int parseList(const char* list,double* pvals,double dflt)
+{
+    int n = 0;
+    char* pend;
+    const char* p = list;
+
+    if( (p == NULL) || (strlen(p) == 0) )
+    {
+        pvals[0] = dflt;
+        return( 1 );
+    }
+
+    for( ;; )
+    {
+        if( n == K_BENCHMAX )
+            return( -1 );
+        pvals[n] = strtod(p,&pend);
+        if( (pend == p) || (pvals[n] < 0.0) )
+            return( -1 );
+        ++n;
+
+        p = pend;
+        if( *p == '\0' )
+            return( n );
+        if( *p++ != ',' )
+            return( -1 );
+    }
+}
+
+
+static Bench* createBench(Port* pport,int cmdidx,int count,double window,int nCells)
+{
+    Bench* pbench;
+    asynUser* pasynUser;
+
+    pbench = callocMustSucceed(1,sizeof(Bench),"drvLove::createBench");
+    pbench->pport = pport;
+    pbench->cmdidx = cmdidx;
+    pbench->count = count;
+    pbench->window = window;
+    pbench->nCells = nCells;
+    pbench->done = epicsEventMustCreate(epicsEventEmpty);
+    pbench->plats = callocMustSucceed(count,sizeof(double),"drvLove::createBench");
+    pbench->pres = callocMustSucceed(nCells,sizeof(BenchRes),"drvLove::createBench");
+
+    pasynUser = pasynManager->createAsynUser(runBench,NULL);
+    pasynUser->userPvt = pbench;
+    pasynUser->timeout = K_COMTMO;
+    pbench->pasynUser = pasynUser;
+
+    if( ISNOTOK(pasynManager->connectDevice(pasynUser,pport->name,-1)) )
+        printf("drvLove::createBench failure to connect with device %s\n",pport->name);
+
+    return( pbench );
+}
+
+
+static void freeBench(Bench* pbench)
+{
+    pasynManager->disconnect(pbench->pasynUser);
+    pasynManager->freeAsynUser(pbench->pasynUser);
+    epicsEventDestroy(pbench->done);
+    free(pbench->plats);
+    free(pbench->pres);
+    free(pbench);
+}
+
+
+static void runBench(asynUser* pasynUser)
+{
+    asynStatus sts;
+    BenchRes* pres;
+    epicsTimeStamp start,now;
+    Bench* pbench = (Bench*)pasynUser->userPvt;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::runBench\n");
+
+    /* A burst holds the port thread for one window, then the records get the bus back */
+    epicsTimeGetCurrent(&start);
+    for( now = start; pbench->cell < pbench->nCells; )
+    {
+        pres = &pbench->pres[pbench->cell];
+        sts = benchTransact(pbench,pres,pasynUser);
+        if( ISNOTOK(sts) )
+            ++pres->nErrors;
+        if( ++pres->count == pbench->count )
+        {
+            finishCell(pbench,pres);
+            ++pbench->cell;
+        }
+
+        epicsTimeGetCurrent(&now);
+        if( epicsTimeDiffInSeconds(&now,&start) >= pbench->window )
+            break;
+    }
+
+    if( pbench->cell < pbench->nCells )
+    {
+        if( ISOK(queuePort(pbench->pport,pasynUser,runBench,asynQueuePriorityLow)) )
+            return;
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::runBench %s failure to queue request\n",pbench->pport->name);
+        pbench->nCells = pbench->cell;
+    }
+
+    epicsEventSignal(pbench->done);
+}
+
+
+static asynStatus benchTransact(Bench* pbench,BenchRes* pres,asynUser* pasynUser)
+{
+    asynStatus sts;
+    Trans* ptrans;
+    unsigned char* pmsg;
+    Port* pport = pbench->pport;
+    const CmdTbl* pcmd = &CmdTable[pbench->cmdidx];
+
+    /* Not charged to a record and not cached, only the bus is measured */
+    ptrans = takeTrans(pport);
+    ptrans->gap = pres->gap;
+    ptrans->timeout = pres->timeout;
+    if( pport->proto == protoRtu )
+    {
+        pmsg = (unsigned char*)ptrans->outMsg;
+        pmsg[0] = (unsigned char)pres->addr;
+        pmsg[1] = 0x03;
+        pmsg[2] = (unsigned char)(pcmd->reg >> 8);
+        pmsg[3] = (unsigned char)(pcmd->reg & 0xFF);
+        pmsg[4] = 0;
+        pmsg[5] = 1;
+        ptrans->outLen = 6;
+        sts = rtuTransact(pport,ptrans,pasynUser,7);
+    }
+    else
+    {
+        sprintf(ptrans->outMsg,"%s",loveRegTable[pport->instr[pres->addr - 1].modidx][pbench->cmdidx].read);
+        sts = transact(pport,ptrans,pasynUser,pres->addr);
+    }
+
+    pbench->plats[pres->count] = epicsTimeDiffInSeconds(&ptrans->tsUnlock,&ptrans->tsLock);
+    pres->busy += pbench->plats[pres->count];
+    pres->retries += ptrans->retries;
+    giveTrans(pport,ptrans);
+
+    return( sts );
+}
+
+
+static void finishCell(Bench* pbench,BenchRes* pres)
+{
+    int n = pres->count;
+    double* plats = pbench->plats;
+
+    qsort(plats,n,sizeof(double),cmpDouble);
+    pres->min = plats[0];
+    pres->p50 = plats[(n - 1) / 2];
+    pres->p90 = plats[((n - 1) * 90) / 100];
+    pres->p99 = plats[((n - 1) * 99) / 100];
+    pres->max = plats[n - 1];
+}
+
+
+static int cmpDouble(const void* p1,const void* p2)
+{
+    double d1 = *(const double*)p1;
+    double d2 = *(const double*)p2;
+
+    return( (d1 < d2)?-1:((d1 > d2)?1:0) );
+}
+
+
+/****************************************************************************
+ * Define private coordinated snapshot methods
+ ****************************************************************************/
+static asynStatus startSnapshot(void)
+{
+    int n;
+    Port* pport;
+
+    epicsMutexMustLock(snap.lock);
+
+    /* A trigger arriving while a snapshot is in progress joins it */
+    if( snap.pending )
+    {
+        ++snap.nJoined;
+        epicsMutexUnlock(snap.lock);
+        return( asynSuccess );
+    }
+
+    if( snap.nCmds == 0 )
+    {
+        snap.cmds[0] = cmdValue;
+        snap.nCmds = 1;
+    }
+
+    for( n = 0, pport = pports; pport; pport = pport->pport )
+        ++n;
+    ++snap.seq;
+    snap.pending = n;
+    snap.nSamples = 0;
+    epicsTimeGetCurrent(&snap.stamp);
+    epicsEventTryWait(snap.done);
+    epicsMutexUnlock(snap.lock);
+
+    /* Every bus has its own port thread or engine worker, so the ports are read in parallel */
+    for( pport = pports; pport; pport = pport->pport )
+        if( ISNOTOK(queuePort(pport,pport->shot.pasynUser,takeShot,asynQueuePriorityHigh)) )
+        {
+            printf("drvLove::startSnapshot %s failure to queue request\n",pport->name);
+            pport->shot.count = 0;
+            pport->shot.nSamples = 0;
+            finishShot(pport);
+        }
+
+    return( asynSuccess );
+}
+
+
+static void takeShot(asynUser* pasynUser)
+{
+    int i,j,n,decpts;
+    asynStatus sts;
+    epicsInt32 value;
+    Inst inst;
+    Reg* preg;
+    Instr* pinfo;
+    Port* pport = (Port*)pasynUser->userPvt;
+    Shot* pshot = &pport->shot;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::takeShot\n");
+
+    pshot->count = 0;
+    pshot->nFailed = 0;
+    pshot->nSamples = 0;
+    for( i = 0; i < K_INSTRMAX; ++i )
+    {
+        pinfo = &pport->instr[i];
+        if( pinfo->isConfig == 0 )
+            continue;
+
+        for( j = 0; j < snap.nCmds; ++j )
+        {
+            initInst(&inst,pport,i + 1,snap.cmds[j]);
+            if( (pport->proto == protoAscii) && (instCmd(&inst)->read == NULL) )
+                continue;
+            if( (pport->proto == protoRtu) && (CmdTable[inst.cmdidx].reg < 0) )
+                continue;
+
+            n = pshot->count++;
+            pshot->addrs[n] = i + 1;
+            pshot->cmds[n] = inst.cmdidx;
+
+            /* Never served from the cache, every sample is a fresh reply */
+            sts = readCommand(pport,&inst,pasynUser,&value);
+            if( ISNOTOK(sts) )
+            {
+                pshot->values[n] = 0.0;
+                pshot->times[n] = -1.0;
+                ++pshot->nFailed;
+                continue;
+            }
+
+            preg = &pinfo->regs[cmdDecpts];
+            decpts = (preg->isValid && (preg->value > 0) && (preg->value < 4))?preg->value:0;
+            if( (inst.read == getValue) || (inst.read == getSignedValue) )
+                pshot->values[n] = value / pow(10.0,decpts);
+            else
+                pshot->values[n] = value;
+
+            preg = &pinfo->regs[inst.cmdidx];
+            pshot->times[n] = epicsTimeDiffInSeconds(&preg->stamp,&snap.stamp);
+            if( (pshot->nSamples == 0) || epicsTimeLessThan(&preg->stamp,&pshot->first) )
+                pshot->first = preg->stamp;
+            if( (pshot->nSamples == 0) || epicsTimeLessThan(&pshot->last,&preg->stamp) )
+                pshot->last = preg->stamp;
+            ++pshot->nSamples;
+        }
+    }
+
+    finishShot(pport);
+}
+
+
+static void finishShot(Port* pport)
+{
+    int isLast;
+    epicsInt32 skew = 0;
+    Shot* pshot = &pport->shot;
+
+    callbackList(pport,parSnapAddr,pshot->addrs,(size_t)pshot->count,&snap.stamp);
+    callbackList(pport,parSnapCmd,pshot->cmds,(size_t)pshot->count,&snap.stamp);
+    callbackList(pport,parSnapValue,pshot->values,(size_t)pshot->count,&snap.stamp);
+    callbackList(pport,parSnapTime,pshot->times,(size_t)pshot->count,&snap.stamp);
+
+    epicsMutexMustLock(snap.lock);
+    if( pshot->nSamples )
+    {
+        if( (snap.nSamples == 0) || epicsTimeLessThan(&pshot->first,&snap.first) )
+            snap.first = pshot->first;
+        if( (snap.nSamples == 0) || epicsTimeLessThan(&snap.last,&pshot->last) )
+            snap.last = pshot->last;
+        snap.nSamples += pshot->nSamples;
+    }
+    isLast = (--snap.pending == 0);
+    if( isLast && snap.nSamples )
+        skew = (epicsInt32)((epicsTimeDiffInSeconds(&snap.last,&snap.first) * 1.0e6) + 0.5);
+    epicsMutexUnlock(snap.lock);
+
+    /* The last port to finish completes the snapshot on every port */
+    if( isLast )
+    {
+        for( pport = pports; pport; pport = pport->pport )
+        {
+            setParam(pport,parSnapSkew,skew);
+            setParam(pport,parSnapshot,snap.seq);
+        }
+        epicsEventSignal(snap.done);
+    }
+}
+
+
+/****************************************************************************
+ * Define private event-loop engine methods
+ ****************************************************************************/
+static asynStatus engineAdd(Port* pport)
+{
+#ifdef USE_EPOLL
+    struct epoll_event ev;
+    Tty* ptty = pport->pserport->ptty;
+
+    /* One engine for all event ports, created with the first */
+    if( engine.lock == NULL )
+    {
+        engine.lock = epicsMutexMustCreate();
+        engine.epfd = epoll_create1(0);
+        engine.wakefd = eventfd(0,EFD_NONBLOCK);
+        engine.workWake = epicsEventMustCreate(epicsEventEmpty);
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;
+        if( (engine.epfd < 0) || (engine.wakefd < 0) || (epoll_ctl(engine.epfd,EPOLL_CTL_ADD,engine.wakefd,&ev) != 0) )
+        {
+            printf("engineAdd::failure to create the event loop - %s\n",strerror(errno));
+            return( asynError );
+        }
+    }
+
+    if( engine.nPorts == K_ENGINEMAX )
+    {
+        printf("engineAdd::more than %d event ports\n",K_ENGINEMAX);
+        return( asynError );
+    }
+
+    /* Until engineStart() the bus is idle, stray bytes are drained */
+    fcntl(ptty->fd,F_SETFL,fcntl(ptty->fd,F_GETFL) | O_NONBLOCK);
+    ev.events = EPOLLIN;
+    ev.data.ptr = pport;
+    if( epoll_ctl(engine.epfd,EPOLL_CTL_ADD,ptty->fd,&ev) != 0 )
+    {
+        printf("engineAdd::failure to watch %s - %s\n",ptty->pdev,strerror(errno));
+        return( asynError );
+    }
+
+    setDefaultEos(pport);
+    pport->isEos = 1;
+    pport->bus.isEngine = 1;
+    pport->bus.gap = pport->gap;
+    pport->bus.state = busIdle;
+    pport->bus.done = epicsEventMustCreate(epicsEventEmpty);
+
+    /* Registered without ASYN_CANBLOCK, the port gets no port thread */
+    pport->pserport->canBlock = 0;
+
+    return( asynSuccess );
+#else
+    printf("engineAdd::the event-loop engine is not supported on this target\n");
+    return( asynError );
+#endif
+}
+
+
+static void engineStart(Port* pport)
+{
+#ifdef USE_EPOLL
+    char name[16];
+
+    epicsMutexMustLock(engine.lock);
+    epicsTimeGetCurrent(&pport->bus.last);
+    engine.pports[engine.nPorts++] = pport;
+    epicsMutexUnlock(engine.lock);
+
+    if( engine.tid )
+        return;
+
+    /* The engine and its workers serve every event port, however many there are */
+    engine.tid = epicsThreadMustCreate("loveEngine",epicsThreadPriorityScanHigh,epicsThreadGetStackSize(epicsThreadStackMedium),engineThread,NULL);
+    for( ; engine.nWorkers < K_WORKMAX; ++engine.nWorkers )
+    {
+        sprintf(name,"loveWork%d",engine.nWorkers);
+        epicsThreadMustCreate(name,epicsThreadPriorityMedium,epicsThreadGetStackSize(epicsThreadStackMedium),workThread,NULL);
+    }
+#endif
+}
+
+
+static void engineDrop(Port* pport)
+{
+#ifdef USE_EPOLL
+    struct epoll_event ev;
+
+    /* A port that failed to register never reached the engine's list */
+    epoll_ctl(engine.epfd,EPOLL_CTL_DEL,pport->pserport->ptty->fd,&ev);
+    epicsEventDestroy(pport->bus.done);
+    pport->bus.isEngine = 0;
+#endif
+}
+
+
+static void engineThread(void* parm)
+{
+#ifdef USE_EPOLL
+    int i,n,ms;
+    double wait,next;
+    uint64_t count;
+    Job* pdone;
+    Job* pjob;
+    Port* pport;
+    epicsTimeStamp now;
+    struct epoll_event evs[K_ENGINEMAX + 1];
+
+    for( ;; )
+    {
+        /* Start frames whose gap has passed and expire replies, then sleep to the earliest deadline */
+        pdone = NULL;
+        epicsTimeGetCurrent(&now);
+        epicsMutexMustLock(engine.lock);
+        for( next = -1.0, i = 0; i < engine.nPorts; ++i )
+        {
+            wait = engineStep(engine.pports[i],&now,&pdone);
+            if( (wait >= 0.0) && ((next < 0.0) || (wait < next)) )
+                next = wait;
+        }
+        epicsMutexUnlock(engine.lock);
+
+        /* Replies are decoded and called back outside the engine lock */
+        for( ; pdone; pdone = pjob )
+        {
+            pjob = pdone->pnext;
+            engineFinish(pdone->pport,pdone);
+        }
+
+        ms = (next < 0.0)?-1:((int)(next * 1000.0) + 1);
+        n = epoll_wait(engine.epfd,evs,K_ENGINEMAX + 1,ms);
+        ++engine.nLoops;
+
+        epicsTimeGetCurrent(&now);
+        epicsMutexMustLock(engine.lock);
+        for( i = 0; i < n; ++i )
+        {
+            ++engine.nEvents;
+            pport = (Port*)evs[i].data.ptr;
+            if( pport == NULL )
+            {
+                if( read(engine.wakefd,&count,sizeof(count)) < 0 )
+                    continue;
+            }
+            else
+                engineRecv(pport,&now,&pdone);
+        }
+        epicsMutexUnlock(engine.lock);
+
+        for( ; pdone; pdone = pjob )
+        {
+            pjob = pdone->pnext;
+            engineFinish(pdone->pport,pdone);
+        }
+    }
+#endif
+}
+
+
+static void engineSubmit(Port* pport,Job* pjob)
+{
+#ifdef USE_EPOLL
+    uint64_t one = 1;
+    Bus* pbus = &pport->bus;
+
+    pjob->pnext = NULL;
+    pjob->pport = pport;
+
+    epicsMutexMustLock(engine.lock);
+    if( pbus->ptail )
+        pbus->ptail->pnext = pjob;
+    else
+        pbus->phead = pjob;
+    pbus->ptail = pjob;
+    epicsMutexUnlock(engine.lock);
+
+    if( write(engine.wakefd,&one,sizeof(one)) < 0 )
+        asynPrint(pport->pasynUser,ASYN_TRACE_ERROR,"drvLove::engineSubmit %s failure to wake the engine\n",pport->name);
+#endif
+}
+
+
+static double engineStep(Port* pport,const epicsTimeStamp* pnow,Job** ppdone)
+{
+#ifdef USE_EPOLL
+    double left,gap;
+    size_t count;
+    ssize_t len;
+    char buf[K_MSGSIZE + 1];
+    Trans* ptrans;
+    Bus* pbus = &pport->bus;
+    Tty* ptty = pport->pserport->ptty;
+
+    for( ;; )
+    {
+        if( pbus->state == busIdle )
+        {
+            if( pbus->phead == NULL )
+                return( -1.0 );
+
+            pbus->pcur = pbus->phead;
+            pbus->phead = pbus->pcur->pnext;
+            if( pbus->phead == NULL )
+                pbus->ptail = NULL;
+            pbus->pcur->tries = 0;
+            pbus->pcur->ptrans->tsLock = *pnow;
+
+            /* The gap runs from the end of the previous frame on this bus */
+            gap = (pbus->pcur->ptrans->gap < 0.0)?pbus->gap:pbus->pcur->ptrans->gap;
+            pbus->due = pbus->last;
+            epicsTimeAddSeconds(&pbus->due,gap);
+            pbus->state = busGap;
+        }
+
+        left = epicsTimeDiffInSeconds(&pbus->due,pnow);
+        if( left > 0.0 )
+            return( left );
+
+        ptrans = pbus->pcur->ptrans;
+        if( pbus->state == busGap )
+        {
+            count = strlen(ptrans->outMsg);
+            memcpy(buf,ptrans->outMsg,count);
+            if( ptty->outEosLen )
+                buf[count++] = ptty->outEos;
+
+            tcflush(ptty->fd,TCIFLUSH);
+            ptrans->rawLen = 0;
+            len = write(ptty->fd,buf,count);
+            if( len != (ssize_t)count )
+            {
+                engineDone(pport,asynError,pnow,ppdone);
+                continue;
+            }
+
+            pbus->tsTry = *pnow;
+            pbus->due = *pnow;
+            epicsTimeAddSeconds(&pbus->due,ptrans->timeout);
+            pbus->state = busRecv;
+            continue;
+        }
+
+        /* No complete reply in time, the attempt is charged as retry cost */
+        ++pbus->nTimeouts;
+        if( ++pbus->pcur->tries < 3 )
+        {
+            ptrans->retries++;
+            ptrans->retryTime += epicsTimeDiffInSeconds(pnow,&pbus->tsTry);
+            gap = (ptrans->gap < 0.0)?pbus->gap:ptrans->gap;
+            pbus->due = *pnow;
+            epicsTimeAddSeconds(&pbus->due,gap);
+            pbus->state = busGap;
+            continue;
+        }
+
+        engineDone(pport,asynTimeout,pnow,ppdone);
+    }
+#else
+    return( -1.0 );
+#endif
+}
+
+
+static void engineRecv(Port* pport,const epicsTimeStamp* pnow,Job** ppdone)
+{
+#ifdef USE_EPOLL
+    int kind;
+    size_t i;
+    ssize_t len;
+    char junk[K_MSGSIZE];
+    Trans* ptrans;
+    Bus* pbus = &pport->bus;
+    Tty* ptty = pport->pserport->ptty;
+
+    ++ptty->nWakeups;
+    if( pbus->state != busRecv )
+    {
+        /* Bytes of a dropped reply or stray bytes between transactions */
+        while( read(ptty->fd,junk,sizeof(junk)) > 0 )
+            ;
+        return;
+    }
+
+    ptrans = pbus->pcur->ptrans;
+    len = read(ptty->fd,ptrans->rawMsg + ptrans->rawLen,sizeof(ptrans->rawMsg) - 1 - ptrans->rawLen);
+    if( len <= 0 )
+        return;
+
+    /* The reply ends with the input EOS, which is removed as by the tty transport */
+    for( i = ptrans->rawLen, ptrans->rawLen += (size_t)len; i < ptrans->rawLen; ++i )
+        if( ptrans->rawMsg[i] == ptty->inpEos )
+        {
+            /* Soak faults corrupt the reply or drop it, when the attempt runs into its deadline */
+            kind = (pport->psoak && (pport->psoak->faults > 0.0))?soakKind(pport->psoak):-1;
+            if( (kind == 1) && i )
+                ptrans->rawMsg[i - 1] ^= 0x01;
+            else if( kind >= 0 )
+            {
+                if( kind == 2 )
+                    soakDrop(pport);
+                ptrans->rawLen = 0;
+                pbus->state = busMute;
+                return;
+            }
+
+            ptrans->rawLen = i;
+            ptrans->rawMsg[i] = '\0';
+            ptrans->tsReply = *pnow;
+            ++ptty->nReads;
+            engineDone(pport,asynSuccess,pnow,ppdone);
+            return;
+        }
+
+    if( ptrans->rawLen == (sizeof(ptrans->rawMsg) - 1) )
+    {
+        ptrans->rawMsg[ptrans->rawLen] = '\0';
+        engineDone(pport,asynOverflow,pnow,ppdone);
+    }
+#endif
+}
+
+
+static void engineDone(Port* pport,asynStatus sts,const epicsTimeStamp* pnow,Job** ppdone)
+{
+    Bus* pbus = &pport->bus;
+    Job* pjob = pbus->pcur;
+    Trans* ptrans = pjob->ptrans;
+
+    pjob->sts = sts;
+    ptrans->tsUnlock = *pnow;
+    noteTransaction(pport,ptrans,sts,(ptrans->gap < 0.0)?pbus->gap:ptrans->gap,strlen(ptrans->outMsg));
+
+    pbus->last = *pnow;
+    pbus->pcur = NULL;
+    pbus->state = busIdle;
+    ++pbus->nJobs;
+
+    pjob->pnext = *ppdone;
+    *ppdone = pjob;
+}
+
+
+static asynStatus engineTransact(Port* pport,Trans* ptrans)
+{
+    Job job;
+
+    /* Slow-path callers wait on the event of the port, one at a time under the port lock */
+    memset(&job,0,sizeof(job));
+    job.kind = jobSync;
+    job.ptrans = ptrans;
+    job.done = pport->bus.done;
+
+    lockPort(pport,pport->pasynUser);
+    engineSubmit(pport,&job);
+    epicsEventMustWait(job.done);
+    unlockPort(pport,pport->pasynUser);
+
+    return( job.sts );
+}
+
+
+static asynStatus engineQueue(Port* pport,Inst* pinst,JobKind kind,epicsInt32 value)
+{
+    asynStatus sts;
+    Job* pjob;
+
+    /* Jobs are recycled per port, a warmed-up port does not allocate */
+    epicsMutexMustLock(engine.lock);
+    pjob = pport->bus.pfree;
+    if( pjob )
+        pport->bus.pfree = pjob->pnext;
+    epicsMutexUnlock(engine.lock);
+    if( pjob == NULL )
+        pjob = callocMustSucceed(1,sizeof(Job),"drvLove::engineQueue");
+
+    pjob->kind = kind;
+    pjob->pinst = pinst;
+    pjob->modidx = pinst->pinfo->modidx;
+    pjob->value = value;
+    pjob->verify = (kind == jobWrite) && pport->verify;
+
+    sts = engineFrame(pport,pjob);
+    if( ISNOTOK(sts) )
+        engineFree(pport,pjob);
+
+    return( sts );
+}
+
+
+static asynStatus engineFrame(Port* pport,Job* pjob)
+{
+    asynStatus sts;
+    epicsInt32 data;
+    Inst* pinst = pjob->pinst;
+    Trans* ptrans = &pjob->trans;
+
+    initTrans(ptrans);
+    ptrans->pinst = pinst;
+    pjob->ptrans = ptrans;
+
+    if( pjob->kind == jobWrite )
+    {
+        /* The formatter may rewrite its value, verify against the requested one */
+        data = pjob->value;
+        sts = pinst->write(pinst,ptrans,&data);
+    }
+    else if( instCmd(pinst)->read )
+    {
+        sprintf(ptrans->outMsg,"%s",instCmd(pinst)->read);
+        sts = asynSuccess;
+    }
+    else
+        sts = asynError;
+
+    if( ISOK(sts) )
+        sts = buildCommand(pport,ptrans,pinst->addr);
+    if( ISOK(sts) )
+        engineSubmit(pport,pjob);
+
+    return( sts );
+}
+
+
+static void engineFinish(Port* pport,Job* pjob)
+{
+    asynStatus sts;
+    epicsInt32 value = 0;
+    Inst* pinst = pjob->pinst;
+    Trans* ptrans = pjob->ptrans;
+    Reg* preg;
+
+    /* A slow-path caller decodes its own reply */
+    if( pjob->kind == jobSync )
+    {
+        epicsEventSignal(pjob->done);
+        return;
+    }
+
+    /* Runs on the engine thread, the records of the register are called back from here */
+    preg = &pinst->pinfo->regs[pinst->cmdidx];
+    sts = pjob->sts;
+    if( ISOK(sts) )
+        sts = evalMessage(&ptrans->rawLen,ptrans->rawMsg,pport->pasynUser,ptrans->inpMsg);
+
+    /* A reply for the model the address had before a run-time change is dropped */
+    if( (pinst->pinfo->modidx != pjob->modidx) || pinst->pinfo->isRemoved )
+    {
+        if( pjob->kind == jobRead )
+            epicsAtomicSetIntT(&preg->isQueued,0);
+        engineFree(pport,pjob);
+        return;
+    }
+
+    if( (pjob->kind == jobWrite) && ISOK(sts) )
+        sts = processWriteResponse(pport,ptrans);
+    if( (pjob->kind == jobWrite) && ISOK(sts) && pjob->verify )
+    {
+        /* The readback follows the write on the same job */
+        pjob->kind = jobVerify;
+        sts = engineFrame(pport,pjob);
+        if( ISOK(sts) )
+            return;
+    }
+    else if( (pjob->kind != jobWrite) && ISOK(sts) )
+        sts = pinst->read(pinst,ptrans,&value);
+
+    if( (pjob->kind == jobVerify) && ISOK(sts) && (value != pjob->value) )
+    {
+        asynPrint(pport->pasynUser,ASYN_TRACE_ERROR,"drvLove::engineFinish %s addr %d %s wrote %d read back %d\n",pport->name,pinst->addr,CmdTable[pinst->cmdidx].pname,pjob->value,value);
+        sts = asynError;
+    }
+    if( (pjob->kind == jobVerify) && ISNOTOK(sts) )
+        epicsAtomicIncrIntT(&pport->nVerifyFailed);
+
+    /* Cleared ahead of the callbacks, a read they trigger queues the next refresh */
+    if( pjob->kind == jobRead )
+        epicsAtomicSetIntT(&preg->isQueued,0);
+
+    if( ISNOTOK(sts) )
+    {
+        asynPrint(pport->pasynUser,ASYN_TRACE_ERROR,"drvLove::engineFinish %s addr %d %s %s failed\n",pport->name,pinst->addr,CmdTable[pinst->cmdidx].pname,
+                  (pjob->kind == jobRead)?"read":"write");
+        clearCache(pinst);
+        errorCallback(pport,pinst->addr,pinst->cmdidx,(pjob->kind == jobRead)?epicsAlarmRead:epicsAlarmWrite);
+    }
+    else if( pjob->kind == jobWrite )
+        writeThrough(pport,pinst,pjob->value,&ptrans->tsReply);
+    else
+    {
+        pairStatus(pport,pinst,ptrans);
+        setCache(pinst,value,&ptrans->tsReply);
+        readbackCallback(pport,pinst->addr,pinst->cmdidx,value);
+    }
+
+    engineFree(pport,pjob);
+}
+
+
+static void engineFree(Port* pport,Job* pjob)
+{
+    epicsMutexMustLock(engine.lock);
+    pjob->pnext = pport->bus.pfree;
+    pport->bus.pfree = pjob;
+    epicsMutexUnlock(engine.lock);
+}
+
+
+static asynStatus engineRead(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32* value)
+{
+    Reg* preg = &pinst->pinfo->regs[pinst->cmdidx];
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::engineRead\n");
+
+    /* One refresh per register in flight, its reply reaches the records through the readback callback */
+    if( epicsAtomicCmpAndSwapIntT(&preg->isQueued,0,1) == 0 )
+        if( ISNOTOK(engineQueue(pport,pinst,jobRead,0)) )
+            epicsAtomicSetIntT(&preg->isQueued,0);
+
+    if( preg->isValid == 0 )
+    {
+        epicsSnprintf(pport->pasynUser->errorMessage,pport->pasynUser->errorMessageSize,"%s no valid reply yet",CmdTable[pinst->cmdidx].pname);
+        return( asynError );
+    }
+
+    *value = preg->value;
+    return( asynSuccess );
+}
+
+
+static asynStatus engineWrite(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32 value)
+{
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::engineWrite\n");
+
+    /* The record completes now, the outcome follows through the readback callback */
+    if( ISNOTOK(engineQueue(pport,pinst,jobWrite,value)) )
+    {
+        epicsSnprintf(pport->pasynUser->errorMessage,pport->pasynUser->errorMessageSize,"%s write of %d not queued",CmdTable[pinst->cmdidx].pname,value);
+        return( asynError );
+    }
+
+    return( asynSuccess );
+}
+
+
+static asynStatus queuePort(Port* pport,asynUser* pasynUser,userCallback callback,asynQueuePriority prio)
+{
+    Work* pwork;
+    Work** ppwork;
+
+    if( pport->bus.isEngine == 0 )
+        return( pasynManager->queueRequest(pasynUser,prio,0.0) );
+
+    /* Event ports have no port thread, their slow-path requests queue for the workers by priority */
+    pwork = callocMustSucceed(1,sizeof(Work),"drvLove::queuePort");
+    pwork->pport = pport;
+    pwork->pasynUser = pasynUser;
+    pwork->callback = callback;
+    pwork->prio = prio;
+
+    epicsMutexMustLock(engine.lock);
+    for( ppwork = &engine.pwork; *ppwork && ((*ppwork)->prio >= prio); ppwork = &(*ppwork)->pnext )
+        ;
+    pwork->pnext = *ppwork;
+    *ppwork = pwork;
+    epicsMutexUnlock(engine.lock);
+
+    epicsEventSignal(engine.workWake);
+    return( asynSuccess );
+}
+
+
+static asynStatus cancelPort(Port* pport,asynUser* pasynUser,int* pwasQueued)
+{
+    Work* pwork;
+    Work** ppwork;
+
+    if( pport->bus.isEngine == 0 )
+        return( pasynManager->cancelRequest(pasynUser,pwasQueued) );
+
+    /* A request a worker has taken runs to its end */
+    *pwasQueued = 0;
+    epicsMutexMustLock(engine.lock);
+    for( ppwork = &engine.pwork; *ppwork && ((*ppwork)->pasynUser != pasynUser); ppwork = &(*ppwork)->pnext )
+        ;
+    pwork = *ppwork;
+    if( pwork )
+    {
+        *ppwork = pwork->pnext;
+        *pwasQueued = 1;
+    }
+    epicsMutexUnlock(engine.lock);
+
+    free(pwork);
+    return( asynSuccess );
+}
+
+
+static void workThread(void* parm)
+{
+    Work* pwork;
+    Work** ppwork;
+
+    for( ;; )
+    {
+        /* The first request of a port no other worker serves, so the work of a port stays in order */
+        epicsMutexMustLock(engine.lock);
+        for( ppwork = &engine.pwork; *ppwork && (*ppwork)->pport->bus.isWorking; ppwork = &(*ppwork)->pnext )
+            ;
+        pwork = *ppwork;
+        if( pwork )
+        {
+            *ppwork = pwork->pnext;
+            pwork->pport->bus.isWorking = 1;
+            ++engine.nWork;
+        }
+        epicsMutexUnlock(engine.lock);
+
+        if( pwork == NULL )
+        {
+            epicsEventMustWait(engine.workWake);
+            continue;
+        }
+
+        /* Another worker takes the rest of the queue meanwhile */
+        epicsEventSignal(engine.workWake);
+        pwork->callback(pwork->pasynUser);
+
+        epicsMutexMustLock(engine.lock);
+        pwork->pport->bus.isWorking = 0;
+        epicsMutexUnlock(engine.lock);
+        free(pwork);
+        epicsEventSignal(engine.workWake);
+    }
+}
+
+
+/****************************************************************************
+ * Define private run-time configuration methods
+ ****************************************************************************/
+static int changeInstr(Port* pport,int addr,int modidx)
+{
+    int wasQueued;
+    Change chg;
+
+    memset(&chg,0,sizeof(chg));
+    chg.pport = pport;
+    chg.addr = addr;
+    chg.modidx = modidx;
+    chg.done = epicsEventMustCreate(epicsEventEmpty);
+
+    /* The port-wide user queues the change, the device user carries its connection state */
+    chg.pasynUser = pasynManager->createAsynUser(applyChange,NULL);
+    chg.pasynUser->userPvt = &chg;
+    chg.pasynUser->timeout = K_COMTMO;
+    chg.pdevUser = pasynManager->createAsynUser(NULL,NULL);
+    if( ISNOTOK(pasynManager->connectDevice(chg.pasynUser,pport->name,-1)) ||
+        ISNOTOK(pasynManager->connectDevice(chg.pdevUser,pport->name,addr)) ||
+        ISNOTOK(queuePort(pport,chg.pasynUser,applyChange,asynQueuePriorityHigh)) )
+    {
+        printf("changeInstr::%s failure to queue the change of addr %d\n",pport->name,addr);
+        pasynManager->freeAsynUser(chg.pasynUser);
+        pasynManager->freeAsynUser(chg.pdevUser);
+        epicsEventDestroy(chg.done);
+        return( -1 );
+    }
+
+    /* A port stuck behind a long queue or a hung transaction fails the change rather than the shell */
+    wasQueued = 0;
+    if( epicsEventWaitWithTimeout(chg.done,K_CHGTMO) != epicsEventOK )
+    {
+        cancelPort(pport,chg.pasynUser,&wasQueued);
+        if( wasQueued == 0 )
+            epicsEventMustWait(chg.done);
+    }
+    pasynManager->freeAsynUser(chg.pasynUser);
+    pasynManager->freeAsynUser(chg.pdevUser);
+    epicsEventDestroy(chg.done);
+
+    if( wasQueued )
+    {
+        printf("changeInstr::%s change of addr %d not applied within %.0f sec, cancelled\n",pport->name,addr,K_CHGTMO);
+        return( -1 );
+    }
+
+    if( modidx < 0 )
+        printf("changeInstr::%s addr %d removed\n",pport->name,addr);
+    else
+        printf("changeInstr::%s addr %d configured as %s\n",pport->name,addr,loveModelTable[modidx].pname);
+
+    return( 0 );
+}
+
+
+static void applyChange(asynUser* pasynUser)
+{
+    Change* pchg = (Change*)pasynUser->userPvt;
+    Port* pport = pchg->pport;
+    Instr* pinfo = &pport->instr[pchg->addr - 1];
+
+    /* Runs between transactions, record reads of the address see either the old or the new model;
+       on an event port a reply still in flight for the old model is dropped by engineFinish() */
+    flushInstr(pport,pinfo);
+    if( pchg->modidx < 0 )
+    {
+        pinfo->isConfig = 0;
+        pinfo->isRemoved = 1;
+        if( pinfo->isConn )
+        {
+            pinfo->isConn = 0;
+            pasynManager->exceptionDisconnect(pchg->pdevUser);
+        }
+    }
+    else
+    {
+        pinfo->modidx = (Model)pchg->modidx;
+        pinfo->isConfig = 1;
+        pinfo->isRemoved = 0;
+        if( pinfo->isConn == 0 )
+        {
+            pinfo->isConn = 1;
+            pasynManager->exceptionConnect(pchg->pdevUser);
+        }
+    }
+
+    checkLoad(pport);
+    epicsEventSignal(pchg->done);
+}
+
+
+static void flushInstr(Port* pport,Instr* pinfo)
+{
+    int i;
+    Reg* preg;
+    Ramp* pramp;
+
+    /* Values of the previous controller are never served for the new one */
+    epicsMutexMustLock(pport->cacheLock);
+    for( i = 0; i < K_CMDMAX; ++i )
+    {
+        preg = &pinfo->regs[i];
+        preg->isValid = 0;
+        preg->isStale = 0;
+        preg->isWritten = 0;
+        preg->isBits = 0;
+        preg->primed = 0.0;
+    }
+    epicsMutexUnlock(pport->cacheLock);
+
+    /* The next poll cycle starts the address afresh */
+    pinfo->trigCount = 0;
+    for( i = 0; i < groupCount; ++i )
+    {
+        if( pinfo->isIdle[i] )
+        {
+            pinfo->isIdle[i] = 0;
+            pport->nIdle--;
+            setParam(pport,parIdleCount,pport->nIdle);
+        }
+        memset(&pinfo->polled[i],0,sizeof(epicsTimeStamp));
+    }
+
+    for( i = 0; i < K_RAMPMAX; ++i )
+    {
+        pramp = &pinfo->ramps[i];
+        epicsMutexMustLock(pport->rampLock);
+        if( pramp->pars[rpState] != rampActive )
+        {
+            epicsMutexUnlock(pport->rampLock);
+            continue;
+        }
+        pramp->pars[rpState] = rampIdle;
+        pramp->isOrigin = 0;
+        epicsMutexUnlock(pport->rampLock);
+        rampCallback(pport,pramp,rpState);
+    }
+}
+
+
+/****************************************************************************
+ * Define private soak monitor methods
+ ****************************************************************************/
+static void soakThread(void* parm)
+{
+    double elapsed;
+    epicsTimeStamp now;
+    Port* pport = (Port*)parm;
+    Soak* psoak = pport->psoak;
+
+    for( ;; )
+    {
+        epicsEventWaitWithTimeout(psoak->wake,psoak->period);
+        if( psoak->period <= 0.0 )
+            break;
+
+        if( psoak->churn )
+            soakChurn(psoak);
+        soakCheck(pport);
+        soakPublish(pport);
+
+        epicsTimeGetCurrent(&now);
+        elapsed = epicsTimeDiffInSeconds(&now,&psoak->start);
+        if( (psoak->hours > 0.0) && (elapsed >= (psoak->hours * 3600.0)) )
+            break;
+    }
+
+    epicsMutexMustLock(psoak->lock);
+    psoak->faults = 0.0;
+    psoak->isRunning = 0;
+    epicsMutexUnlock(psoak->lock);
+    soakPublish(pport);
+
+    printf("drvLoveSoak::%s %s after %d periods, %d warnings, %lu transactions, %lu errors, %lu faults, %lu instances churned\n",pport->name,
+           (psoak->nWarnings)?"failed":"passed",psoak->nWindows,psoak->nWarnings,psoak->nTrans,psoak->nErrors,psoak->nFaults,psoak->nChurn);
+}
+
+
+static void soakSample(Port* pport,asynStatus sts,double held)
+{
+    Soak* psoak = pport->psoak;
+
+    epicsMutexMustLock(psoak->lock);
+    ++psoak->nTrans;
+    if( ISNOTOK(sts) )
+        ++psoak->nErrors;
+    else if( psoak->nLat < K_SOAKSAMP )
+        psoak->lats[psoak->nLat++] = held;
+    epicsMutexUnlock(psoak->lock);
+}
+
+
+static int soakKind(Soak* psoak)
+{
+    int kind;
+
+    /* Every 1/faults-th reply is hit, in turn by a timeout, a corrupted frame and a dropped connection */
+    epicsMutexMustLock(psoak->lock);
+    psoak->faultAcc += psoak->faults;
+    if( psoak->faultAcc < 1.0 )
+    {
+        epicsMutexUnlock(psoak->lock);
+        return( -1 );
+    }
+    psoak->faultAcc -= 1.0;
+    kind = (int)(psoak->nFaults++ % 3);
+    epicsMutexUnlock(psoak->lock);
+
+    return( kind );
+}
+
+static asynStatus soakFault(Port* pport,asynUser* pasynUser,char* data,size_t* pbytes,const epicsTimeStamp* pstart)
+{
+    int kind;
+    double left;
+    epicsTimeStamp now;
+
+    kind = soakKind(pport->psoak);
+    if( kind < 0 )
+        return( asynSuccess );
+
+    if( kind == 1 )
+    {
+        if( *pbytes )
+            data[*pbytes - 1] ^= 0x01;
+        asynPrintIO(pport->pasynUser,ASYN_TRACE_FLOW,data,*pbytes,"drvLove::soakFault %s corrupted %d bytes\n",pport->name,(int)*pbytes);
+        return( asynSuccess );
+    }
+
+    if( kind == 2 )
+        soakDrop(pport);
+
+    /* The reply is lost, the caller waits out the rest of its timeout as on a silent bus */
+    epicsTimeGetCurrent(&now);
+    left = pasynUser->timeout - epicsTimeDiffInSeconds(&now,pstart);
+    if( left > 0.0 )
+        epicsThreadSleep(left);
+
+    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::soakFault %s dropped %d bytes\n",pport->name,(int)*pbytes);
+    *pbytes = 0;
+    epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"soak fault timeout");
+    return( asynTimeout );
+}
+
+static void soakDrop(Port* pport)
+{
+    unsigned long count;
+    asynStatus sts;
+    Serport* pser = pport->pserport;
+
+    /* Closed and opened again as after a serial server restart, on the lock of the transaction */
+    if( pser->ptty )
+        sts = dropTty(pport);
+    else if( pser->pasynCommon )
+    {
+        sts = pser->pasynCommon->disconnect(pser->pasynCommonPvt,pser->pasynUser);
+        if( ISOK(sts) )
+            sts = pser->pasynCommon->connect(pser->pasynCommonPvt,pser->pasynUser);
+    }
+    else
+        sts = asynError;
+
+    if( ISNOTOK(sts) )
+    {
+        asynPrint(pport->pasynUser,ASYN_TRACE_ERROR,"drvLove::soakDrop %s failure to reconnect\n",pport->name);
+        return;
+    }
+
+    /* Posted at once, a fault taken just before the soak ends still shows up */
+    epicsMutexMustLock(pport->psoak->lock);
+    count = ++pport->psoak->nReconnects;
+    epicsMutexUnlock(pport->psoak->lock);
+    setParam(pport,parSoakReconnects,(epicsInt32)count);
+    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::soakDrop %s reconnected\n",pport->name);
+}
+
+
+static void soakChurn(Soak* psoak)
+{
+    int i;
+    char name[K_LINEMAX];
+
+    /* Created and destroyed as a record would be, alternating registers and their ages */
+    for( i = 0; i < psoak->churn; ++i )
+    {
+        sprintf(name,"%s%s",CmdTable[i % cmdTotal].pname,(i & 1)?"Age":"");
+        if( ISNOTOK(psoak->pdrvUser->create(psoak->drvPvt,psoak->pasynUser,name,NULL,NULL)) )
+            continue;
+        psoak->pdrvUser->destroy(psoak->drvPvt,psoak->pasynUser);
+        ++psoak->nChurn;
+    }
+}
+
+
+static void soakMeasure(long* prss,long* pthreads)
+{
+    *prss = *pthreads = -1;
+
+#ifdef __linux__
+    {
+        long size,pages;
+        char line[K_LINEMAX];
+        FILE* fp;
+
+        fp = fopen("/proc/self/statm","r");
+        if( fp )
+        {
+            if( fscanf(fp,"%ld %ld",&size,&pages) == 2 )
+                *prss = (pages * sysconf(_SC_PAGESIZE)) / 1024;
+            fclose(fp);
+        }
+
+        fp = fopen("/proc/self/status","r");
+        if( fp )
+        {
+            while( fgets(line,sizeof(line),fp) )
+                if( sscanf(line,"Threads: %ld",pthreads) == 1 )
+                    break;
+            fclose(fp);
+        }
+    }
+#endif
+}
+
+
+static void soakCheck(Port* pport)
+{
+    int n;
+    double* plats;
+    Soak* psoak = pport->psoak;
+
+    soakMeasure(&psoak->rss,&psoak->threads);
+    psoak->insts = epicsAtomicGetIntT(&pport->nInsts);
+
+    /* The period's transaction times are sorted outside the lock */
+    plats = mallocMustSucceed(K_SOAKSAMP * sizeof(double),"soakCheck");
+    epicsMutexMustLock(psoak->lock);
+    n = psoak->nLat;
+    memcpy(plats,psoak->lats,n * sizeof(double));
+    psoak->nLat = 0;
+    epicsMutexUnlock(psoak->lock);
+    if( n )
+    {
+        qsort(plats,n,sizeof(double),cmpDouble);
+        psoak->p99 = plats[(int)(0.99 * (n - 1))];
+    }
+    free(plats);
+
+    if( psoak->nWindows++ == 0 )
+    {
+        psoak->baseRss = psoak->rss;
+        psoak->baseThreads = psoak->threads;
+        psoak->baseInsts = psoak->insts;
+        psoak->baseOverflow = epicsAtomicGetIntT(&pport->transOverflow);
+        psoak->baseP99 = psoak->p99;
+        return;
+    }
+
+    if( (psoak->rss >= 0) && (psoak->rss > (psoak->baseRss + psoak->baseRss / 10 + K_SOAKRSS)) )
+    {
+        ++psoak->nWarnings;
+        asynPrint(pport->pasynUser,ASYN_TRACE_ERROR,"drvLove::soakCheck %s memory grew from %ld to %ld kB\n",pport->name,psoak->baseRss,psoak->rss);
+    }
+    if( psoak->threads != psoak->baseThreads )
+    {
+        ++psoak->nWarnings;
+        asynPrint(pport->pasynUser,ASYN_TRACE_ERROR,"drvLove::soakCheck %s threads changed from %ld to %ld\n",pport->name,psoak->baseThreads,psoak->threads);
+    }
+    if( psoak->insts != psoak->baseInsts )
+    {
+        ++psoak->nWarnings;
+        asynPrint(pport->pasynUser,ASYN_TRACE_ERROR,"drvLove::soakCheck %s record instances changed from %d to %d\n",pport->name,psoak->baseInsts,psoak->insts);
+    }
+    if( epicsAtomicGetIntT(&pport->transOverflow) != psoak->baseOverflow )
+    {
+        ++psoak->nWarnings;
+        psoak->baseOverflow = epicsAtomicGetIntT(&pport->transOverflow);
+        asynPrint(pport->pasynUser,ASYN_TRACE_ERROR,"drvLove::soakCheck %s transaction pool overflowed\n",pport->name);
+    }
+    if( n && (psoak->p99 > (K_SOAKLAT * psoak->baseP99)) && (psoak->p99 > (psoak->baseP99 + K_TURN)) )
+    {
+        ++psoak->nWarnings;
+        asynPrint(pport->pasynUser,ASYN_TRACE_ERROR,"drvLove::soakCheck %s p99 transaction time drifted from %.4f to %.4f sec\n",pport->name,psoak->baseP99,psoak->p99);
+    }
+}
+
+
+static void soakPublish(Port* pport)
+{
+    Soak* psoak = pport->psoak;
+
+    /* SoakBusy drops last, a client seeing it at 0 reads the final counts */
+    setParam(pport,parSoakPeriods,psoak->nWindows);
+    setParam(pport,parSoakWarnings,psoak->nWarnings);
+    setParam(pport,parSoakFaults,(epicsInt32)psoak->nFaults);
+    setParam(pport,parSoakReconnects,(epicsInt32)psoak->nReconnects);
+    setParam(pport,parSoakBusy,psoak->isRunning);
+}
+
+
+/****************************************************************************
+ * Define private bus capacity and load shedding methods
+ ****************************************************************************/
+static double calcCharTime(Port* pport)
+{
+    int i;
+    double bits[4];
+    char buf[32];
+    Serport* pser = pport->pserport;
+    static const char* keys[4] = {"baud","bits","parity","stop"};
+    static const double defaults[4] = {19200.0,8.0,0.0,1.0};
+
+    for( i = 0; i < 4; ++i )
+    {
+        bits[i] = defaults[i];
+        if( (pser->pasynOption == NULL) || ISNOTOK(pser->pasynOption->getOption(pser->pasynOptionPvt,pser->pasynUser,keys[i],buf,sizeof(buf))) )
+            continue;
+
+        if( i == 2 )
+            bits[i] = (epicsStrCaseCmp(buf,"none") == 0)?0.0:1.0;
+        else if( atof(buf) > 0.0 )
+            bits[i] = atof(buf);
+    }
+
+    /* Start bit, data bits, parity and stop bits */
+    return( (1.0 + bits[1] + bits[2] + bits[3]) / bits[0] );
+}
+
+
+static double estimateCapacity(Port* pport)
+{
+    double turn;
+
+    if( pport->charTime <= 0.0 )
+        pport->charTime = calcCharTime(pport);
+
+    turn = (pport->turnaround > 0.0)?pport->turnaround:K_TURN;
+
+    if( pport->proto == protoRtu )
+        return( 1.0 / ((4.5 * pport->charTime) + (K_RTUFRAME * pport->charTime) + turn) );
+
+    return( 1.0 / (pport->gap + (K_FRAME * pport->charTime) + turn) );
+}
+
+
+static double estimateLoad(Port* pport)
+{
+    int i,count;
+    double load;
+    Group* pgrp;
+
+    for( count = 0, i = 0; i < K_INSTRMAX; ++i )
+        if( pport->instr[i].isConfig )
+            ++count;
+
+    for( load = 0.0, i = 0; i < groupCount; ++i )
+    {
+        pgrp = &pport->groups[i];
+        if( pgrp->period > 0.0 )
+            load += (count * pgrp->reads) / pgrp->period;
+    }
+
+    return( load );
+}
+
+
+static void checkLoad(Port* pport)
+{
+    double load,capacity;
+
+    capacity = estimateCapacity(pport);
+    load = estimateLoad(pport);
+
+    pport->params[parBusCapacity] = (epicsInt32)(capacity + 0.5);
+    pport->params[parBusLoad] = (epicsInt32)((100.0 * load / capacity) + 0.5);
+
+    if( (load <= K_LOADMAX * capacity) || pport->isOverload )
+        return;
+
+    pport->isOverload = 1;
+    printf("drvLove: WARNING port %s poll load %.1f reads/sec exceeds %.0f%% of the estimated bus capacity %.1f reads/sec\n",
+           pport->name,load,K_LOADMAX * 100.0,capacity);
+}
+
+
+static void updateBus(Port* pport,const epicsTimeStamp* pnow)
+{
+    double elapsed,busy;
+
+    elapsed = epicsTimeDiffInSeconds(pnow,&pport->busStamp);
+    if( elapsed < 1.0 )
+        return;
+
+    busy = pport->lockTime - pport->busTime;
+    pport->busTime = pport->lockTime;
+    pport->busStamp = *pnow;
+
+    setParam(pport,parBusOccupancy,(epicsInt32)((100.0 * busy / elapsed) + 0.5));
+    setParam(pport,parBusCapacity,(epicsInt32)(estimateCapacity(pport) + 0.5));
+    setParam(pport,parShed,epicsAtomicGetIntT(&pport->nShed));
+    setParam(pport,parMerged,epicsAtomicGetIntT(&pport->nMerged));
+    setParam(pport,parVerifyFailed,epicsAtomicGetIntT(&pport->nVerifyFailed));
+    setParam(pport,parStale,epicsAtomicGetIntT(&pport->nStale));
+
+    buildTop(pport);
+    publishTop(pport);
+    publishLatency(pport);
+    probeSched(pport);
+}
+
+
+static int findQueued(Port* pport,Inst* pinst,epicsTimeStamp* pqueued,double* pperiod)
+{
+    unsigned i,count;
+    int found = 0;
+    Instr* pinfo = pinst->pinfo;
+
+    /* A record has one request in flight, queued by the first poll after its last read */
+    count = (unsigned)epicsAtomicGetIntT(&pinfo->trigCount);
+    for( i = 1; (i < K_TRIGMAX) && (i <= count); ++i )
+    {
+        const epicsTimeStamp* pstamp = &pinfo->trigStamp[(count - i) % K_TRIGMAX];
+
+        if( pinst->isDone && epicsTimeLessThanEqual(pstamp,&pinst->done) )
+            break;
+
+        *pqueued = *pstamp;
+        *pperiod = pport->groups[pinfo->trigGroup[(count - i) % K_TRIGMAX]].period;
+        found = 1;
+    }
+
+    return( found );
+}
+
+
+static int shedRead(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32* value)
+{
+    double period;
+    epicsTimeStamp queued,now;
+    Reg* preg = &pinst->pinfo->regs[pinst->cmdidx];
+
+    if( (preg->isValid == 0) || preg->isStale || preg->isWritten || (findQueued(pport,pinst,&queued,&period) == 0) )
+        return( 0 );
+
+    /* Merge with a read of the same register completed after this one was queued */
+    if( epicsTimeLessThan(&queued,&preg->stamp) )
+    {
+        *value = preg->value;
+        epicsAtomicIncrIntT(&pport->nMerged);
+        return( 1 );
+    }
+
+    /* Past its deadline the next poll is due, so the read is dropped */
+    epicsTimeGetCurrent(&now);
+    if( epicsTimeDiffInSeconds(&now,&queued) < period )
+        return( 0 );
+
+    *value = preg->value;
+    pasynUser->alarmStatus = epicsAlarmTimeout;
+    pasynUser->alarmSeverity = epicsSevMinor;
+    epicsAtomicIncrIntT(&pport->nShed);
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::shedRead %s addr %d %s dropped\n",pport->name,pinst->addr,CmdTable[pinst->cmdidx].pname);
+
+    return( 1 );
+}
+
+
+/****************************************************************************
+ * Define private command / response methods
+ ****************************************************************************/
+static asynStatus getValue(Inst* pinst,Trans* ptrans,epicsInt32* value)
+{
+    int sign,data;
+    Port* pport = pinst->pport;
+    Readback* prb = (Readback*)ptrans->inpMsg;
+
+    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::getValue\n" );
+
+    sscanf(prb->Value.stat,"%4x",&sign);
+    sscanf(prb->Value.data,"%4d",&data);
+    *value = (epicsInt32)data;
+    if( sign & 0x0001 )
+        *value *= -1;
+
+    return( asynSuccess );
+}
+
+
+static asynStatus getStatus(Inst* pinst,Trans* ptrans,epicsInt32* value)
+{
+    int sts;
+    Port* pport = pinst->pport;
+    Readback* prb = (Readback*)ptrans->inpMsg;
+
+    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::getStatus\n" );
+
+    sscanf(prb->Value.stat,"%4x",&sts);
+    *value = (epicsInt32)sts;
+
+    return( asynSuccess );
+}
+
+
+static asynStatus getSignedValue(Inst* pinst,Trans* ptrans,epicsInt32* value)
+{
+    int sts,data;
+    Port* pport = pinst->pport;
+    Readback* prb = (Readback*)ptrans->inpMsg;
+    const LoveModel* pmodel = &loveModelTable[pinst->pinfo->modidx];
+
+    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::getSignedValue\n" );
+
+    sscanf(prb->Signed.data,"%4d",&data);
+    *value = (epicsInt32)data;
+
+    /* The model table says how the sign is encoded in the info field */
+    sts = 0;
+    sscanf(prb->Signed.info,pmodel->signFmt,&sts);
+    if( sts & pmodel->signMask )
+        *value *= -1;
+
+    return( asynSuccess );
+}
+
+
+static asynStatus getData(Inst* pinst,Trans* ptrans,epicsInt32* value)
+{
+    int data;
+    Port* pport = pinst->pport;
+    Readback* prb = (Readback*)ptrans->inpMsg;
+
+    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::getData\n" );
+
+    sscanf(prb->State.data,"%2x",&data);
+    *value = (epicsInt32)data;
+
+    return( asynSuccess );
+}
+
+
+static asynStatus putData(Inst* pinst,Trans* ptrans,epicsInt32* value)
+{
+    int sign,data;
+    Port* pport = pinst->pport;
+
+    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::putData\n" );
+
+    if( *value < 0 )
+    {
+        sign = loveModelTable[pinst->pinfo->modidx].negSign;
+        *value *= -1;
+    }
+    else
+        sign = 0;
+
+    data = (int)(*value);
+    sprintf(ptrans->outMsg,"%s%4.4d%2.2X",instCmd(pinst)->write,data,sign);
+
+    return( asynSuccess );
+}
+
+
+static asynStatus doNull(Inst* pinst,Trans* ptrans,epicsInt32* value)
+{
+    return( asynError );
+}
+
+
+/****************************************************************************
+ * Define private Modbus RTU methods
+ ****************************************************************************/
+static int rtuBlock(int modidx,int cmdidx,int* plo,int* phi)
+{
+    int i,reg;
+
+    /* Registers of the same 16-register page are read together */
+    reg = CmdTable[cmdidx].reg;
+    if( (reg < 0) || (loveRegTable[modidx][cmdidx].read == NULL) )
+        return( 0 );
+
+    *plo = *phi = reg;
+    for( i = 0; i < cmdCount; ++i )
+    {
+        if( (CmdTable[i].reg < 0) || ((CmdTable[i].reg & ~0xF) != (reg & ~0xF)) )
+            continue;
+        if( loveRegTable[modidx][i].read == NULL )
+            continue;
+        if( CmdTable[i].reg < *plo )
+            *plo = CmdTable[i].reg;
+        if( CmdTable[i].reg > *phi )
+            *phi = CmdTable[i].reg;
+    }
+
+    if( (*phi - *plo) >= K_RTUBLOCK )
+        *plo = *phi = reg;
+
+    return( 1 );
+}
+
+
+static epicsInt32 rtuDecode(int cmdidx,const unsigned char* pdata)
+{
+    epicsUInt16 raw = (epicsUInt16)((pdata[0] << 8) | pdata[1]);
+
+    /* Status and configuration registers are unsigned, readings are signed */
+    if( (CmdTable[cmdidx].read == getStatus) || (CmdTable[cmdidx].read == getData) )
+        return( (epicsInt32)raw );
+
+    return( (epicsInt32)(epicsInt16)raw );
+}
+
+
+static asynStatus rtuRead(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32* value)
+{
+    int i,lo,hi,count;
+    asynStatus sts;
+    Trans* ptrans;
+    Reg* preg;
+    epicsInt32 data;
+    epicsUInt32 changed;
+    unsigned char* pmsg;
+
+    if( rtuBlock(pinst->pinfo->modidx,pinst->cmdidx,&lo,&hi) == 0 )
+        return( asynError );
+
+    count = hi - lo + 1;
+    ptrans = takeTrans(pport);
+    ptrans->pinst = pinst;
+    pmsg = (unsigned char*)ptrans->outMsg;
+    pmsg[0] = (unsigned char)pinst->addr;
+    pmsg[1] = 0x03;
+    pmsg[2] = (unsigned char)(lo >> 8);
+    pmsg[3] = (unsigned char)(lo & 0xFF);
+    pmsg[4] = 0;
+    pmsg[5] = (unsigned char)count;
+    ptrans->outLen = 6;
+
+    sts = rtuTransact(pport,ptrans,pasynUser,5 + (2 * count));
+    if( ISOK(sts) && (((unsigned char)ptrans->rawMsg[2]) != (2 * count)) )
+    {
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::rtuRead %s addr %d byte count mismatch\n",pport->name,pinst->addr);
+        sts = asynError;
+    }
+
+    if( ISOK(sts) )
+    {
+        pmsg = (unsigned char*)ptrans->rawMsg + 3;
+        for( i = 0; i < cmdCount; ++i )
+        {
+            if( (CmdTable[i].reg < lo) || (CmdTable[i].reg > hi) )
+                continue;
+            if( loveRegTable[pinst->pinfo->modidx][i].read == NULL )
+                continue;
+
+            /* Neighbours of the requested register are handed to their next reader */
+            data = rtuDecode(i,pmsg + (2 * (CmdTable[i].reg - lo)));
+            preg = &pinst->pinfo->regs[i];
+            epicsMutexMustLock(pport->cacheLock);
+            preg->value = data;
+            preg->stamp = ptrans->tsReply;
+            preg->isStale = 0;
+            preg->isWritten = 0;
+            preg->isValid = 1;
+            addHistory(pport,pinst->addr,i,data,&preg->stamp);
+            changed = bitsUpdate(preg,i,(epicsUInt32)data);
+            epicsMutexUnlock(pport->cacheLock);
+            bitsCallback(pport,pinst->addr,i,(epicsUInt32)data,changed,&ptrans->tsReply);
+            if( i == pinst->cmdidx )
+                *value = data;
+            else
+                preg->primed = K_RTUAGE;
+        }
+    }
+    giveTrans(pport,ptrans);
+
+    return( sts );
+}
+
+
+static asynStatus rtuWrite(Port* pport,Inst* pinst,asynUser* pasynUser,epicsInt32 value,epicsTimeStamp* pstamp)
+{
+    int reg;
+    asynStatus sts;
+    Trans* ptrans;
+    unsigned char* pmsg;
+
+    /* Writes go to the 02## write code, not to the register that is read */
+    reg = CmdTable[pinst->cmdidx].wreg;
+    if( (reg < 0) || (pinst->write == doNull) || (instCmd(pinst)->write == NULL) )
+        return( asynError );
+
+    ptrans = takeTrans(pport);
+    ptrans->pinst = pinst;
+    pmsg = (unsigned char*)ptrans->outMsg;
+    pmsg[0] = (unsigned char)pinst->addr;
+    pmsg[1] = 0x06;
+    pmsg[2] = (unsigned char)(reg >> 8);
+    pmsg[3] = (unsigned char)(reg & 0xFF);
+    pmsg[4] = (unsigned char)((value >> 8) & 0xFF);
+    pmsg[5] = (unsigned char)(value & 0xFF);
+    ptrans->outLen = 6;
+
+    /* A successful write is echoed back unchanged */
+    sts = rtuTransact(pport,ptrans,pasynUser,8);
+    if( ISOK(sts) && memcmp(ptrans->rawMsg,ptrans->outMsg,6) )
+    {
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::rtuWrite %s addr %d echo mismatch\n",pport->name,pinst->addr);
+        sts = asynError;
+    }
+    *pstamp = ptrans->tsReply;
+    giveTrans(pport,ptrans);
+
+    return( sts );
+}
+
+
+static asynStatus rtuTransact(Port* pport,Trans* ptrans,asynUser* pasynUser,size_t inpLen)
+{
+    int i;
+    double gap;
+    asynStatus sts;
+    size_t bytesXfer;
+    epicsUInt16 crc;
+    epicsTimeStamp tsTry,now;
+    Serport* pser = pport->pserport;
+    unsigned char* pmsg = (unsigned char*)ptrans->outMsg;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::rtuTransact\n");
+
+    crc = loveFrameCrc(pmsg,ptrans->outLen);
+    pmsg[ptrans->outLen++] = (unsigned char)(crc & 0xFF);
+    pmsg[ptrans->outLen++] = (unsigned char)(crc >> 8);
+
+    lockPort(pport,pasynUser);
+    epicsTimeGetCurrent(&ptrans->tsLock);
+    if( pport->isEos == 0 )
+        setDefaultEos(pport);
+
+    /* Frames are separated by at least 3.5 character times of silence */
+    if( pport->charTime <= 0.0 )
+        pport->charTime = calcCharTime(pport);
+    gap = (ptrans->gap < 0.0)?((pser->ptty && pser->ptty->isBroker)?0.0:(4.5 * pport->charTime)):ptrans->gap;
+
+    pser->pasynUser->timeout = ptrans->timeout;
+    for( sts = asynError, i = 0; (i < 3) && ISNOTOK(sts); ++i )
+    {
+        epicsTimeGetCurrent(&now);
+        if( i )
+        {
+            ptrans->retryTime += epicsTimeDiffInSeconds(&now,&tsTry);
+            ptrans->retries++;
+        }
+        tsTry = now;
+
+        epicsThreadSleep(gap);
+        pser->pasynOctet->flush(pser->pasynOctetPvt,pser->pasynUser);
+
+        sts = pser->pasynOctet->write(pser->pasynOctetPvt,pser->pasynUser,ptrans->outMsg,ptrans->outLen,&bytesXfer);
+        if( ISOK(sts) )
+            sts = rtuRecv(pport,ptrans,pasynUser,inpLen);
+        if( ISOK(sts) )
+            epicsTimeGetCurrent(&ptrans->tsReply);
+        if( ISNOTOK(sts) )
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::rtuTransact %s retries(%d) failed\n",pport->name,i);
+    }
+
+    epicsTimeGetCurrent(&ptrans->tsUnlock);
+    pser->pasynUser->timeout = K_COMTMO;
+    noteTransaction(pport,ptrans,sts,gap,ptrans->outLen);
+    unlockPort(pport,pasynUser);
+
+    return( ptrans->sts = sts );
+}
+
+
+static asynStatus rtuRecv(Port* pport,Trans* ptrans,asynUser* pasynUser,size_t inpLen)
+{
+    int eom;
+    asynStatus sts;
+    size_t bytesXfer,len;
+    unsigned char* pmsg = (unsigned char*)ptrans->rawMsg;
+
+    /* Address, function and the first data byte tell the reply length */
+    ptrans->rawLen = 0;
+    sts = readSerport(pport,ptrans->rawMsg,3,&bytesXfer,&eom);
+    if( ISNOTOK(sts) || (bytesXfer != 3) )
+        return( ISOK(sts)?asynError:sts );
+
+    len = loveFrameLength(1,pmsg,3);
+    if( len > sizeof(ptrans->rawMsg) )
+        return( asynOverflow );
+    if( ((pmsg[1] & 0x80) == 0) && (len != inpLen) )
+    {
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::rtuRecv %s reply of %d bytes, expected %d\n",pport->name,(int)len,(int)inpLen);
+        return( asynError );
+    }
+
+    sts = readSerport(pport,ptrans->rawMsg + 3,len - 3,&bytesXfer,&eom);
+    if( ISNOTOK(sts) || (bytesXfer != (len - 3)) )
+        return( ISOK(sts)?asynError:sts );
+    ptrans->rawLen = len;
+
+    if( loveFrameCrc(pmsg,len - 2) != (epicsUInt16)(pmsg[len - 2] | (pmsg[len - 1] << 8)) )
+    {
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::rtuRecv %s CRC error\n",pport->name);
+        return( asynError );
+    }
+
+    if( (pmsg[0] != (unsigned char)ptrans->outMsg[0]) || (pmsg[1] & 0x80) )
+    {
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::rtuRecv %s addr %d exception 0x%02X\n",pport->name,pmsg[0],(pmsg[1] & 0x80)?pmsg[2]:0);
+        return( asynError );
+    }
+
+    asynPrintIO(pasynUser,ASYN_TRACEIO_FILTER,ptrans->rawMsg,len,"drvLove::rtuRecv %d bytes\n",(int)len);
+
+    return( asynSuccess );
+}
+
+
+
+
+/****************************************************************************
+ * Define private direct tty transport methods
+ ****************************************************************************/
+#ifdef USE_TTY
+static speed_t ttySpeed(int baud)
+{
+    int i;
+    static const struct {int baud; speed_t speed;} speeds[] =
+    {
+        {1200,B1200},{2400,B2400},{4800,B4800},{9600,B9600},{19200,B19200},{38400,B38400},{57600,B57600},{115200,B115200}
+    };
+
+    for( i = 0; i < (int)(sizeof(speeds) / sizeof(speeds[0])); ++i )
+        if( speeds[i].baud == baud )
+            return( speeds[i].speed );
+
+    return( 0 );
+}
+
+
+static asynStatus openTty(Tty* ptty,speed_t speed)
+{
+    struct termios tio;
+
+    ptty->fd = open(ptty->pdev,O_RDWR | O_NOCTTY);
+    if( ptty->fd < 0 )
+    {
+        printf("openTty::failure to open %s - %s\n",ptty->pdev,strerror(errno));
+        return( asynError );
+    }
+
+    /* Raw mode; a read returns once VMIN bytes arrived or VTIME passed after the first */
+    memset(&tio,0,sizeof(tio));
+    tio.c_cflag = CREAD | CLOCAL | ((ptty->bits == 7)?CS7:CS8);
+    if( ptty->parity != 'N' )
+        tio.c_cflag |= (ptty->parity == 'O')?(PARENB | PARODD):PARENB;
+    if( ptty->stop == 2 )
+        tio.c_cflag |= CSTOPB;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 1;
+    cfsetispeed(&tio,speed);
+    cfsetospeed(&tio,speed);
+    if( tcsetattr(ptty->fd,TCSANOW,&tio) != 0 )
+    {
+        printf("openTty::failure to configure %s - %s\n",ptty->pdev,strerror(errno));
+        close(ptty->fd);
+        ptty->fd = -1;
+        return( asynError );
+    }
+    ptty->vmin = 1;
+    tcflush(ptty->fd,TCIOFLUSH);
+
+#if defined(__linux__) && defined(ASYNC_LOW_LATENCY)
+    {
+        struct serial_struct ser;
+
+        /* Not every tty has a UART behind it (ptys, some USB adapters) */
+        if( (ioctl(ptty->fd,TIOCGSERIAL,&ser) == 0) )
+        {
+            ser.flags |= ASYNC_LOW_LATENCY;
+            ptty->isLowLatency = (ioctl(ptty->fd,TIOCSSERIAL,&ser) == 0);
+        }
+    }
+#endif
+
+    return( asynSuccess );
+}
+
+
+static int connectBroker(Tty* ptty)
+{
+    int fd;
+    struct sockaddr_un addr;
+
+    if( strlen(ptty->pdev) >= sizeof(addr.sun_path) )
+    {
+        errno = ENAMETOOLONG;
+        return( -1 );
+    }
+
+    memset(&addr,0,sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path,ptty->pdev);
+
+    fd = socket(AF_UNIX,SOCK_STREAM,0);
+    if( (fd >= 0) && (connect(fd,(struct sockaddr*)&addr,sizeof(addr)) != 0) )
+    {
+        close(fd);
+        fd = -1;
+    }
+
+    return( fd );
+}
+
+
+static asynStatus openBroker(Tty* ptty)
+{
+    /* The broker may start after the IOC, the first request connects again */
+    ptty->fd = connectBroker(ptty);
+    if( ptty->fd < 0 )
+        printf("openBroker::broker %s not reachable yet - %s\n",ptty->pdev,strerror(errno));
+
+    return( asynSuccess );
+}
+#endif
+
+
+static asynStatus dropTty(Port* pport)
+{
+#ifdef USE_TTY
+    asynStatus sts;
+    Tty* ptty = pport->pserport->ptty;
+
+    if( ptty->fd >= 0 )
+    {
+#ifdef USE_EPOLL
+        struct epoll_event ev;
+
+        /* Called on the engine thread under engine.lock for event ports */
+        if( ptty->isEngine )
+            epoll_ctl(engine.epfd,EPOLL_CTL_DEL,ptty->fd,&ev);
+#endif
+        close(ptty->fd);
+        ptty->fd = -1;
+    }
+
+    /* A broker is connected again by the next request */
+    ptty->isPending = 0;
+    if( ptty->isBroker )
+    {
+        ++ptty->nReconnects;
+        return( asynSuccess );
+    }
+
+    sts = openTty(ptty,ttySpeed(ptty->baud));
+#ifdef USE_EPOLL
+    if( ISOK(sts) && ptty->isEngine )
+    {
+        struct epoll_event ev;
+
+        fcntl(ptty->fd,F_SETFL,fcntl(ptty->fd,F_GETFL) | O_NONBLOCK);
+        ev.events = EPOLLIN;
+        ev.data.ptr = pport;
+        if( epoll_ctl(engine.epfd,EPOLL_CTL_ADD,ptty->fd,&ev) != 0 )
+        {
+            printf("dropTty::failure to watch %s - %s\n",ptty->pdev,strerror(errno));
+            sts = asynError;
+        }
+    }
+#endif
+    if( ISOK(sts) )
+        ++ptty->nReconnects;
+
+    return( sts );
+#else
+    return( asynError );
+#endif
+}
+
+
+static asynStatus initTtyPort(Port* plov,const char* serPort)
 {
+#ifdef USE_TTY
+    char* pdev;
+    char* pbaud;
+    char* pframe;
+    speed_t speed;
     asynStatus sts;
-    Port* plov = (Port*)drvPvt;
+    Tty* ptty;
     Serport* pser = plov->pserport;
 
-    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::unlockPort\n");
+    /* "[event:]/dev/ttyS0[,baud[,framing]]" or "unix:/path[,baud[,framing]]", framing as in 8N1 */
+    ptty = callocMustSucceed(1,sizeof(Tty) + strlen(serPort) + 1,"initTtyPort");
+    pdev = (char*)(ptty + 1);
+    strcpy(pdev,serPort);
+    ptty->isBroker = (strncmp(pdev,"unix:",5) == 0);
+    ptty->isEngine = (strncmp(pdev,"event:",6) == 0);
+    ptty->pdev = (ptty->isBroker)?(pdev + 5):(ptty->isEngine)?(pdev + 6):pdev;
+    if( ptty->isEngine && (plov->proto != protoAscii) )
+    {
+        printf("initTtyPort::event ports support the ASCII protocol only\n");
+        free(ptty);
+        return( asynError );
+    }
+    ptty->baud = K_TTYBAUD;
+    ptty->bits = 8;
+    ptty->parity = 'N';
+    ptty->stop = 1;
 
-    sts = pasynManager->unlockPort(pser->pasynUser);
+    pbaud = strchr(pdev,',');
+    if( pbaud )
+    {
+        *pbaud++ = '\0';
+        pframe = strchr(pbaud,',');
+        if( pframe )
+        {
+            *pframe++ = '\0';
+            if( (strlen(pframe) != 3) || (strchr("78",pframe[0]) == NULL) || (strchr("NEO",toupper((int)pframe[1])) == NULL) || (strchr("12",pframe[2]) == NULL) )
+            {
+                printf("initTtyPort::illegal framing \"%s\", expected e.g. 8N1\n",pframe);
+                free(ptty);
+                return( asynError );
+            }
+            ptty->bits = pframe[0] - '0';
+            ptty->parity = (char)toupper((int)pframe[1]);
+            ptty->stop = pframe[2] - '0';
+        }
+        ptty->baud = atoi(pbaud);
+    }
+
+    speed = ttySpeed(ptty->baud);
+    if( speed == 0 )
+    {
+        printf("initTtyPort::unsupported baud rate %d\n",ptty->baud);
+        free(ptty);
+        return( asynError );
+    }
+
+    sts = (ptty->isBroker)?openBroker(ptty):openTty(ptty,speed);
     if( ISNOTOK(sts) )
-        asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::unlockPort %s error %s\n",pser->name,pser->pasynUser->errorMessage);
+    {
+        free(ptty);
+        return( asynError );
+    }
+
+    ptty->lock = epicsMutexMustCreate();
+
+    pser->pasynUser = pasynManager->createAsynUser(NULL,NULL);
+    pser->pasynUser->userPvt = plov;
+    pser->pasynUser->timeout = K_COMTMO;
+    pser->pasynOctet = &ttyOctet;
+    pser->pasynOctetPvt = ptty;
+    pser->pasynOption = &ttyOption;
+    pser->pasynOptionPvt = ptty;
+    pser->ptty = ptty;
+    pser->canBlock = 1;
+    pser->autoConnect = 1;
+    pser->isConn = 1;
 
     return( asynSuccess );
+#else
+    printf("initTtyPort::direct tty transport is not supported on this target\n");
+    return( asynError );
+#endif
 }
 
 
-static asynStatus executeCommand(Port* pport,asynUser* pasynUser)
+static void freeTty(Port* plov)
 {
-    int i;
-    asynStatus sts;
+#ifdef USE_TTY
+    Tty* ptty = plov->pserport->ptty;
 
-    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::executeCommand\n");
-    pasynUser->timeout = K_COMTMO;
+    if( ptty == NULL )
+        return;
 
-    for( i = 0; i < 3; ++i )
-    {
-        epicsThreadSleep( K_TUNE );
+    if( ptty->fd >= 0 )
+        close(ptty->fd);
+    epicsMutexDestroy(ptty->lock);
+    free(ptty);
+    plov->pserport->ptty = NULL;
+#endif
+}
 
-        sts = sendCommand(pport,pasynUser,i);
-        if( ISOK(sts) )
-            asynPrint(pasynUser,ASYN_TRACEIO_FILTER,"drvLove::executeCommand write \"%s\"\n",pport->outMsg);
-        else
-        {
-            if( sts == asynTimeout )
-            {
-                asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::executeCommand write timeout, retrying\n");
-                continue;
-            }
 
-            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::executeCommand write failure - Sent \"%s\" \n",pport->outMsg);
-            return( sts );
-        }
+#ifdef USE_TTY
+static asynStatus ttyWait(Tty* ptty,asynUser* pasynUser)
+{
+    int sts;
+    struct pollfd pfd;
 
-        sts = recvReply(pport,pasynUser,pport->inpMsg,sizeof(pport->inpMsg));
-        if( ISOK(sts) )
-            asynPrint(pasynUser,ASYN_TRACEIO_FILTER,"drvLove::executeCommand read \"%s\"\n",pport->inpMsg);
-        else
-        {
-            if( sts == asynTimeout )
-            {
-                asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::executeCommand read timeout, retrying\n");
-                continue;
-            }
+    pfd.fd = ptty->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
 
-            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::executeCommand read failure - Sent \"%s\" Rcvd \"%s\" \n",pport->outMsg,pport->inpMsg);
-            return( sts );
+    do
+        sts = poll(&pfd,1,(pasynUser->timeout > 0.0)?(int)(pasynUser->timeout * 1000.0):-1);
+    while( (sts < 0) && (errno == EINTR) );
+
+    if( sts == 0 )
+        return( asynTimeout );
+
+    return( (sts > 0)?asynSuccess:asynError );
+}
+#endif
+
+
+#ifdef USE_TTY
+static asynStatus brokerWrite(Tty* ptty,asynUser* pasynUser,const char* data,size_t count)
+{
+    int i;
+    LoveBrokerHdr hdr;
+    unsigned char msg[sizeof(LoveBrokerHdr) + K_MSGSIZE + 1];
+
+    hdr.magic = LOVEBROKER_MAGIC;
+    hdr.length = (unsigned short)count;
+    hdr.seq = ++ptty->seq;
+    hdr.value = (pasynUser->timeout > 0.0)?(unsigned int)(pasynUser->timeout * 1000.0):0;
+    memcpy(msg,&hdr,sizeof(hdr));
+    memcpy(msg + sizeof(hdr),data,count);
+
+    /* A restarted broker is reconnected once per request */
+    ptty->isPending = 0;
+    ptty->repLen = ptty->repPos = 0;
+    for( i = 0; i < 2; ++i )
+    {
+        if( ptty->fd < 0 )
+            ptty->fd = connectBroker(ptty);
+        if( ptty->fd < 0 )
+            break;
+
+        if( send(ptty->fd,msg,sizeof(hdr) + count,MSG_NOSIGNAL) == (ssize_t)(sizeof(hdr) + count) )
+        {
+            ptty->isPending = 1;
+            return( asynSuccess );
         }
 
-        return( asynSuccess );
+        close(ptty->fd);
+        ptty->fd = -1;
+        ++ptty->nReconnects;
     }
 
-    asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::executeCommand retries exceeded\n");
+    epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"broker %s unavailable %s",ptty->pdev,strerror(errno));
     return( asynError );
 }
 
 
-static asynStatus processWriteResponse(Port* pport)
+static asynStatus brokerRecv(Tty* ptty,void* buf,size_t len,double timeout)
 {
-    int resp;
-
-
-    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::processWriteResponse\n" );
+    int sts;
+    ssize_t n;
+    size_t count;
+    struct pollfd pfd;
 
-    sscanf(pport->inpMsg,"%2d",&resp);
-    if( resp )
+    for( count = 0; count < len; count += (size_t)n )
     {
-        asynPrint(pport->pasynUser,ASYN_TRACE_ERROR,"drvLove::processWriteResponse write command failed\n" );
-        return( asynError );
+        pfd.fd = ptty->fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        do
+            sts = poll(&pfd,1,(int)(timeout * 1000.0));
+        while( (sts < 0) && (errno == EINTR) );
+        if( sts <= 0 )
+            return( (sts == 0)?asynTimeout:asynError );
+
+        n = recv(ptty->fd,(char*)buf + count,len - count,0);
+        if( n <= 0 )
+            return( asynError );
     }
 
     return( asynSuccess );
 }
 
 
-static asynStatus sendCommand(void* ppvt,asynUser* pasynUser,int retry)
+static asynStatus brokerReply(Tty* ptty,asynUser* pasynUser)
 {
-    unsigned char cs;
     asynStatus sts;
-    int addr;
-    size_t len,bytesXfer;
-    Port* plov = (Port*)ppvt;
-    Serport* pser = plov->pserport;
-
-    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::sendCommand - retries(%d)\n",retry);
+    LoveBrokerHdr hdr;
+    unsigned char skip[LOVEBROKER_FRAMEMAX];
 
-    if( retry == 0 )
+    /* The broker answers within the bus timeout plus its queue; replies to abandoned requests are skipped */
+    for( ;; )
     {
-        sts = pasynManager->getAddr(pasynUser,&addr);
+        sts = brokerRecv(ptty,&hdr,sizeof(hdr),pasynUser->timeout + K_BROKERWAIT);
+        if( ISOK(sts) && ((hdr.magic != LOVEBROKER_MAGIC) || (hdr.length > LOVEBROKER_FRAMEMAX)) )
+            sts = asynError;
+        if( ISOK(sts) )
+            sts = brokerRecv(ptty,(hdr.seq == ptty->seq)?ptty->rep:skip,hdr.length,pasynUser->timeout + K_BROKERWAIT);
         if( ISNOTOK(sts) )
+        {
+            close(ptty->fd);
+            ptty->fd = -1;
+            ptty->isPending = 0;
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"broker %s %s",ptty->pdev,(sts == asynTimeout)?"timeout":"connection lost");
             return( sts );
+        }
 
-        sprintf(plov->tmpMsg,"%02X%s",addr,plov->outMsg);
-        calcChecksum(strlen(plov->tmpMsg),plov->tmpMsg,&cs);
-        sprintf(plov->outMsg,"\002L%s%2X",plov->tmpMsg,cs);
+        if( hdr.seq == ptty->seq )
+            break;
     }
 
-    len = strlen(plov->outMsg);
-    sts = pser->pasynOctet->write(pser->pasynOctetPvt,pser->pasynUser,plov->outMsg,len,&bytesXfer);
-    if( ISOK(sts) )
-        asynPrint(pasynUser,ASYN_TRACEIO_FILTER,"drvLove::sendCommand - retries(%d),data \"%s\" \"%s\"\n",retry,plov->outMsg);
-    else
+    ptty->isPending = 0;
+    if( hdr.value != LOVEBROKER_OK )
     {
-        if( sts == asynTimeout )
-            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::sendCommand - retries(%d) asynTimeout\n",retry);
-        else if( sts == asynOverflow )
-            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::sendCommand - retries(%d) asynOverflow\n",retry);
-        else if( sts == asynError )
-            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::sendCommand - retries(%d) asynError\n",retry);
-        else
-            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::sendCommand - retries(%d) failed - unknown Asyn error\n",retry);
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"broker %s",(hdr.value == LOVEBROKER_TIMEOUT)?"bus timeout":"bus error");
+        return( (hdr.value == LOVEBROKER_TIMEOUT)?asynTimeout:asynError );
     }
+    ptty->repLen = hdr.length;
+    ptty->repPos = 0;
 
-    return( sts );
+    return( asynSuccess );
 }
 
 
-static asynStatus recvReply(void* ppvt,asynUser* pasynUser,char* data,size_t maxchars)
+static asynStatus brokerRead(Tty* ptty,asynUser* pasynUser,char* data,size_t maxchars,size_t* nbytesTransfered,int* eomReason)
 {
-    int eom;
+    size_t count;
     asynStatus sts;
-    size_t bytesXfer;
-    Port* plov = (Port*)ppvt;
-    Serport* pser = plov->pserport;
 
-    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::recvReplay\n");
+    ++ptty->nReads;
+    if( ptty->isPending )
+    {
+        sts = brokerReply(ptty,pasynUser);
+        if( ISNOTOK(sts) )
+            return( sts );
+        ++ptty->nWakeups;
+    }
 
-    sts = pser->pasynOctet->read(pser->pasynOctetPvt,pser->pasynUser,data,maxchars,&bytesXfer,&eom);
-    if( ISOK(sts) )
+    /* The reply is handed out as the tty would, the EOS removed */
+    for( count = 0; (count < maxchars) && (ptty->repPos < ptty->repLen); ++count )
     {
-        if( eom != ASYN_EOM_EOS )
+        data[count] = (char)ptty->rep[ptty->repPos++];
+        if( ptty->inpEosLen && (data[count] == ptty->inpEos) )
         {
-            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::recvReply eos failure\n");
-            return( asynError );
+            *nbytesTransfered = count;
+            if( eomReason )
+                *eomReason = ASYN_EOM_EOS;
+            return( asynSuccess );
         }
-
-        sts = evalMessage(&bytesXfer,plov->inpMsg,pasynUser,data);
-        asynPrint(pasynUser,ASYN_TRACEIO_FILTER,"drvLove::recvReply %d \"%s\"\n",bytesXfer,data);
     }
-    else
+
+    *nbytesTransfered = count;
+    if( count < maxchars )
     {
-        if( sts == asynTimeout )
-            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::recvReply asynTimeout\n");
-        else if( sts == asynOverflow )
-            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::recvReply asynOverflow\n");
-        else if( sts == asynError )
-            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::recvReply asynError\n");
-        else
-            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::recvReply failed - unknown Asyn error\n");
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"broker short reply");
+        return( asynTimeout );
     }
+    if( eomReason )
+        *eomReason = ASYN_EOM_CNT;
 
-    return( sts );
+    return( asynSuccess );
 }
+#endif
 
 
-/****************************************************************************
- * Define private command / response methods
- ****************************************************************************/
-static asynStatus getValue(Inst* pinst,epicsInt32* value)
+static asynStatus ttyWrite(void* drvPvt,asynUser* pasynUser,const char* data,size_t numchars,size_t* nbytesTransfered)
 {
-    int sign,data;
-    Port* pport = pinst->pport;
-    Readback* prb = (Readback*)pport->inpMsg;
+#ifdef USE_TTY
+    ssize_t len;
+    size_t count;
+    char buf[K_MSGSIZE + 1];
+    Tty* ptty = (Tty*)drvPvt;
+
+    /* One write() per frame, the output EOS included */
+    if( numchars > K_MSGSIZE )
+        return( asynOverflow );
+    memcpy(buf,data,numchars);
+    count = numchars;
+    if( ptty->outEosLen )
+        buf[count++] = ptty->outEos;
+
+    *nbytesTransfered = 0;
+    if( ptty->isBroker )
+    {
+        if( ISNOTOK(brokerWrite(ptty,pasynUser,buf,count)) )
+            return( asynError );
+        *nbytesTransfered = numchars;
+        return( asynSuccess );
+    }
 
-    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::getValue\n" );
+    /* A tty that could not be opened again after a dropped connection is retried per frame */
+    if( (ptty->fd < 0) && ISNOTOK(openTty(ptty,ttySpeed(ptty->baud))) )
+    {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"tty %s not open",ptty->pdev);
+        return( asynError );
+    }
 
-    sscanf(prb->Value.stat,"%4x",&sign);
-    sscanf(prb->Value.data,"%4d",&data);
-    *value = (epicsInt32)data;
-    if( sign & 0x0001 )
-        *value *= -1;
+    len = write(ptty->fd,buf,count);
+    if( len != (ssize_t)count )
+    {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"tty write failed %s",(len < 0)?strerror(errno):"short write");
+        return( asynError );
+    }
+    *nbytesTransfered = numchars;
 
     return( asynSuccess );
+#else
+    return( asynError );
+#endif
 }
 
 
-static asynStatus getStatus(Inst* pinst,epicsInt32* value)
+static asynStatus ttyRead(void* drvPvt,asynUser* pasynUser,char* data,size_t maxchars,size_t* nbytesTransfered,int* eomReason)
 {
-    int sts;
-    Port* pport = pinst->pport;
-    Readback* prb = (Readback*)pport->inpMsg;
+#ifdef USE_TTY
+    int vmin;
+    ssize_t len;
+    size_t count,i;
+    asynStatus sts;
+    struct termios tio;
+    Tty* ptty = (Tty*)drvPvt;
 
-    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::getStatus\n" );
+    *nbytesTransfered = 0;
+    if( eomReason )
+        *eomReason = 0;
 
-    sscanf(prb->Value.stat,"%4x",&sts);
-    *value = (epicsInt32)sts;
+    if( ptty->isBroker )
+        return( brokerRead(ptty,pasynUser,data,maxchars,nbytesTransfered,eomReason) );
+
+    /* Without an EOS the caller knows the frame length, the kernel collects all of it */
+    vmin = (ptty->inpEosLen || (maxchars > 255))?1:(int)maxchars;
+    if( (vmin != ptty->vmin) && (tcgetattr(ptty->fd,&tio) == 0) )
+    {
+        tio.c_cc[VMIN] = (cc_t)vmin;
+        if( tcsetattr(ptty->fd,TCSANOW,&tio) == 0 )
+            ptty->vmin = vmin;
+    }
+
+    ++ptty->nReads;
+    for( count = 0; count < maxchars; )
+    {
+        sts = ttyWait(ptty,pasynUser);
+        if( ISNOTOK(sts) )
+        {
+            *nbytesTransfered = count;
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"tty read %s",(sts == asynTimeout)?"timeout":strerror(errno));
+            return( sts );
+        }
+
+        len = read(ptty->fd,data + count,maxchars - count);
+        ++ptty->nWakeups;
+        if( len < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"tty read failed %s",strerror(errno));
+            return( asynError );
+        }
+
+        /* The EOS is removed, as asynInterposeEos does */
+        for( i = count, count += (size_t)len; ptty->inpEosLen && (i < count); ++i )
+            if( data[i] == ptty->inpEos )
+            {
+                *nbytesTransfered = i;
+                if( eomReason )
+                    *eomReason = ASYN_EOM_EOS;
+                return( asynSuccess );
+            }
+    }
+
+    *nbytesTransfered = count;
+    if( eomReason )
+        *eomReason = ASYN_EOM_CNT;
 
     return( asynSuccess );
+#else
+    return( asynError );
+#endif
 }
 
 
-static asynStatus getSignedValue(Inst* pinst,epicsInt32* value)
+static asynStatus ttyFlush(void* drvPvt,asynUser* pasynUser)
 {
-    int sts,data;
-    Port* pport = pinst->pport;
-    Readback* prb = (Readback*)pport->inpMsg;
+#ifdef USE_TTY
+    Tty* ptty = (Tty*)drvPvt;
 
-    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::getSignedValue\n" );
+    if( ptty->isBroker )
+        ptty->repPos = ptty->repLen;
+    else
+        tcflush(ptty->fd,TCIFLUSH);
+#endif
 
-    sscanf(prb->Signed.data,"%4d",&data);
-    *value = (epicsInt32)data;
+    return( asynSuccess );
+}
 
-    if( pinst->pinfo->modidx == model1600 )
-    {
-        sscanf(prb->Signed.info,"%2d",&sts);
-        if( sts )
-            *value *= -1;
-    }
-    else
-    {
-        sscanf(prb->Signed.info,"%2x",&sts);
-        if( sts & 0x0001 )
-            *value *= -1;
-    }
+
+static asynStatus ttySetInputEos(void* drvPvt,asynUser* pasynUser,const char* eos,int eoslen)
+{
+    Tty* ptty = (Tty*)drvPvt;
+
+    if( eoslen > 1 )
+        return( asynError );
+
+    ptty->inpEosLen = eoslen;
+    ptty->inpEos = (eoslen)?eos[0]:'\0';
 
     return( asynSuccess );
 }
 
 
-static asynStatus getData(Inst* pinst,epicsInt32* value)
+static asynStatus ttyGetInputEos(void* drvPvt,asynUser* pasynUser,char* eos,int eossize,int* eoslen)
 {
-    int data;
-    Port* pport = pinst->pport;
-    Readback* prb = (Readback*)pport->inpMsg;
+    Tty* ptty = (Tty*)drvPvt;
 
-    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::getData\n" );
+    if( eossize < ptty->inpEosLen )
+        return( asynError );
 
-    sscanf(prb->State.data,"%2x",&data);
-    *value = (epicsInt32)data;
+    if( ptty->inpEosLen )
+        eos[0] = ptty->inpEos;
+    *eoslen = ptty->inpEosLen;
 
     return( asynSuccess );
 }
 
 
-static asynStatus putData(Inst* pinst,epicsInt32* value)
+static asynStatus ttySetOutputEos(void* drvPvt,asynUser* pasynUser,const char* eos,int eoslen)
 {
-    int sign,data;
-    Port* pport = pinst->pport;
+    Tty* ptty = (Tty*)drvPvt;
 
-    asynPrint(pport->pasynUser,ASYN_TRACE_FLOW,"drvLove::putData\n" );
+    if( eoslen > 1 )
+        return( asynError );
 
-    if( *value < 0 )
-    {
-        sign = 0xFF;
-        *value *= -1;
-    }
-    else
-        sign = 0;
+    ptty->outEosLen = eoslen;
+    ptty->outEos = (eoslen)?eos[0]:'\0';
 
-    data = (int)(*value);
-    sprintf(pport->outMsg,"%s%4.4d%2.2X",pinst->pcmd->write,data,sign);
+    return( asynSuccess );
+}
+
+
+static asynStatus ttyGetOutputEos(void* drvPvt,asynUser* pasynUser,char* eos,int eossize,int* eoslen)
+{
+    Tty* ptty = (Tty*)drvPvt;
+
+    if( eossize < ptty->outEosLen )
+        return( asynError );
+
+    if( ptty->outEosLen )
+        eos[0] = ptty->outEos;
+    *eoslen = ptty->outEosLen;
 
     return( asynSuccess );
 }
 
 
-static asynStatus doNull(Inst* pinst,epicsInt32* value)
+static asynStatus ttySetOption(void* drvPvt,asynUser* pasynUser,const char* key,const char* val)
 {
+    epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"tty settings are fixed by drvLoveInit");
     return( asynError );
 }
 
 
+static asynStatus ttyGetOption(void* drvPvt,asynUser* pasynUser,const char* key,char* val,int sizeval)
+{
+    Tty* ptty = (Tty*)drvPvt;
+
+    if( epicsStrCaseCmp(key,"baud") == 0 )
+        epicsSnprintf(val,sizeval,"%d",ptty->baud);
+    else if( epicsStrCaseCmp(key,"bits") == 0 )
+        epicsSnprintf(val,sizeval,"%d",ptty->bits);
+    else if( epicsStrCaseCmp(key,"parity") == 0 )
+        epicsSnprintf(val,sizeval,"%s",(ptty->parity == 'N')?"none":(ptty->parity == 'O')?"odd":"even");
+    else if( epicsStrCaseCmp(key,"stop") == 0 )
+        epicsSnprintf(val,sizeval,"%d",ptty->stop);
+    else
+        return( asynError );
+
+    return( asynSuccess );
+}
+
+
 /****************************************************************************
  * Define private interface asynCommon methods
  ****************************************************************************/
@@ -984,6 +8106,69 @@ static void reportIt(void* ppvt,FILE* fp,int details)
     Serport* pser = plov->pserport;
 
     fprintf(fp, "    %s is connected to %s\n",plov->name,pser->name);
+    fprintf(fp, "        Warm-up %s, %d of %d registers done, %d failed\n",(plov->params[parWarmBusy])?"busy":"idle",plov->params[parWarmDone],plov->params[parWarmTotal],plov->params[parWarmFailed]);
+
+    if( details > 0 )
+    {
+        fprintf(fp, "        Transactions %lu, lock held avg %.3f max %.3f sec\n",plov->lockCount,(plov->lockCount)?(plov->lockTime / plov->lockCount):0.0,plov->lockMax);
+        fprintf(fp, "        Write verification %s, %d failed\n",(plov->verify)?"enabled":"disabled",epicsAtomicGetIntT(&plov->nVerifyFailed));
+        if( plov->stale > 0.0 )
+            fprintf(fp, "        Staleness threshold %.1f sec, %d stale reads\n",plov->stale,epicsAtomicGetIntT(&plov->nStale));
+        if( pser->ptty && pser->ptty->isBroker )
+            fprintf(fp, "        Broker %s %s, %d %d%c%d, %lu requests, %lu replies, %lu reconnects\n",pser->ptty->pdev,(pser->ptty->fd < 0)?"disconnected":"connected",
+                    pser->ptty->baud,pser->ptty->bits,pser->ptty->parity,pser->ptty->stop,pser->ptty->nReads,pser->ptty->nWakeups,pser->ptty->nReconnects);
+        else if( pser->ptty )
+            fprintf(fp, "        Direct tty %d %d%c%d, low latency %s, %lu reads, %lu wakeups, %lu reconnects\n",pser->ptty->baud,pser->ptty->bits,pser->ptty->parity,pser->ptty->stop,
+                    (pser->ptty->isLowLatency)?"on":"off",pser->ptty->nReads,pser->ptty->nWakeups,pser->ptty->nReconnects);
+        if( plov->bus.isEngine )
+            fprintf(fp, "        Event engine %d ports, %d workers, %lu loops, %lu events, %lu slow-path requests; this bus %lu transactions, %lu timeouts\n",engine.nPorts,
+                    engine.nWorkers,engine.nLoops,engine.nEvents,engine.nWork,plov->bus.nJobs,plov->bus.nTimeouts);
+        fprintf(fp, "        Transaction pool %d, overflow %d, %d record instances\n",K_TRANSMAX,epicsAtomicGetIntT(&plov->transOverflow),epicsAtomicGetIntT(&plov->nInsts));
+        if( plov->psoak && plov->psoak->nWindows )
+            fprintf(fp, "        Soak %s, %d periods, memory %ld/%ld kB, threads %ld/%ld, p99 %.4f/%.4f sec, %lu faults, %d warnings\n",(plov->psoak->isRunning)?"running":"done",
+                    plov->psoak->nWindows,plov->psoak->rss,plov->psoak->baseRss,plov->psoak->threads,plov->psoak->baseThreads,plov->psoak->p99,plov->psoak->baseP99,
+                    plov->psoak->nFaults,plov->psoak->nWarnings);
+        if( plov->sched.prio || plov->sched.isFifo || plov->sched.nCpus || plov->sched.isLock )
+            fprintf(fp, "        Scheduling priority %d, %s, %d CPUs, memory %s, %d failed\n",plov->sched.prio,(plov->sched.isFifo)?"SCHED_FIFO":"default policy",
+                    plov->sched.nCpus,(plov->sched.isLocked)?"locked":"unlocked",plov->sched.nFailed);
+        for( i = 0; i < latCount; ++i )
+        {
+            Lat* plat = &plov->sched.lats[i];
+
+            if( plat->count )
+                fprintf(fp, "        Latency %s avg %.6f max %.6f sec, %lu samples\n",latNames[i],plat->sum / plat->count,plat->max,plat->count);
+        }
+        if( plov->top.count )
+            fprintf(fp, "        Top consumer addr %d %s, %.1f%% of the line\n",plov->top.addrs[0],CmdTable[plov->top.cmds[0]].pname,plov->top.shares[0]);
+        fprintf(fp, "        Bus capacity %.1f reads/sec, poll load %d%%, occupancy %d%%, shed %d, merged %d\n",estimateCapacity(plov),plov->params[parBusLoad],
+                plov->params[parBusOccupancy],epicsAtomicGetIntT(&plov->nShed),epicsAtomicGetIntT(&plov->nMerged));
+        for( i = 0; i < groupCount; ++i )
+        {
+            Group* pgrp = &plov->groups[i];
+
+            if( pgrp->period <= 0.0 )
+                continue;
+            fprintf(fp, "        %s poll %.3f sec, %d controllers, %lu polls, %lu overruns\n",groupNames[i],pgrp->period,pgrp->count,pgrp->fires,pgrp->overruns);
+            if( plov->idle > 0.0 )
+                fprintf(fp, "            demand-driven, unwatched controllers every %.1f sec\n",plov->idle);
+            fprintf(fp, "            late avg %.6f max %.6f, jitter avg %.6f max %.6f sec\n",(pgrp->fires)?(pgrp->lateSum / pgrp->fires):0.0,pgrp->lateMax,
+                    (pgrp->fires > 1)?(pgrp->jitterSum / (pgrp->fires - 1)):0.0,pgrp->jitterMax);
+        }
+        for( i = 0; i < (K_INSTRMAX * K_RAMPMAX); ++i )
+        {
+            Ramp* pramp = &plov->instr[i / K_RAMPMAX].ramps[i % K_RAMPMAX];
+
+            if( pramp->steps || (pramp->pars[rpState] == rampActive) )
+                fprintf(fp, "        Ramp addr %d %s, state %d, %d -> %d at %d/min, %lu steps, %lu late\n",pramp->addr,rampRegs[pramp->idx],
+                        pramp->pars[rpState],pramp->pars[rpCurrent],pramp->pars[rpTarget],pramp->pars[rpRate],pramp->steps,pramp->late);
+        }
+        fprintf(fp, "        Overview %d controllers, %lu sweeps\n",plov->list.count,plov->list.sweeps);
+        if( plov->phist )
+            fprintf(fp, "        History %s, depth %u, head %u\n",plov->phist->file,plov->phist->depth,plov->phist->head);
+        if( plov->pcache )
+            fprintf(fp, "        Cache %s, seeded %d, saved %d times, %d failed\n",plov->pcache->file,plov->pcache->nSeeded,plov->pcache->nSaves,plov->pcache->nFailed);
+        fprintf(fp, "        Download %s, total %d, done %d, skipped %d, failed %d\n",(plov->params[parDlBusy])?"busy":"idle",plov->params[parDlTotal],plov->params[parDlDone],plov->params[parDlSkipped],plov->params[parDlFailed]);
+    }
 
     for( i = 0; i < K_INSTRMAX; ++i )
         if( plov->instr[i].isConn )
@@ -1000,7 +8185,13 @@ static asynStatus connectIt(void* ppvt,asynUser* pasynUser)
 
     asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::connectIt\n");
 
-    sts = pasynManager->isConnected(pser->pasynUser,&isConn);
+    if( pser->ptty )
+    {
+        isConn = (pser->ptty->fd >= 0);
+        sts = asynSuccess;
+    }
+    else
+        sts = pasynManager->isConnected(pser->pasynUser,&isConn);
     if( ISNOTOK(sts) )
     {
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"port %s isConn error %s\n",pser->name,pser->pasynUser->errorMessage);
@@ -1027,6 +8218,12 @@ static asynStatus connectIt(void* ppvt,asynUser* pasynUser)
     {
         Instr* prInstr = &plov->instr[addr - 1];
 
+        if( prInstr->isRemoved )
+        {
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"device %d removed",addr);
+            return( asynError );
+        }
+
         if( prInstr->isConn )
         {
             asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::connectIt %s device %d already connected\n",plov->name,addr);
@@ -1116,23 +8313,123 @@ static asynStatus create(void* ppvt,asynUser* pasynUser,const char* drvInfo, con
     if( ISNOTOK(sts) )
         return( sts );
 
-    for( i = 0; i < cmdCount; ++i )
+    for( i = 0; i < parCount; ++i )
     {
-        if( epicsStrCaseCmp(CmdTable[i].pname,drvInfo) == 0 )
+        if( epicsStrCaseCmp(ParamName[i],drvInfo) == 0 )
         {
             pinst = callocMustSucceed(sizeof(Inst),sizeof(char),"drvLove::create");
             pinst->pport = pport;
-            pinst->pinfo = &pport->instr[addr-1];
-            pinst->read = CmdTable[i].read;
-            pinst->write = CmdTable[i].write;
-            pinst->pcmd = &CmdTable[i].strings[pinst->pinfo->modidx];
+            pinst->addr = addr;
+            pinst->cmdidx = -1;
+            pinst->param = i;
+            pinst->ramp = -1;
+            pinst->read = doNull;
+            pinst->write = doNull;
 
             pasynUser->drvUser = (void*)pinst;
+            epicsAtomicIncrIntT(&pport->nInsts);
 
             return( asynSuccess );
         }
     }
 
+    for( i = 0; i < (K_RAMPMAX * rpCount); ++i )
+    {
+        Ramp* pramp;
+
+        if( epicsStrCaseCmp(rampNames[i / rpCount][i % rpCount],drvInfo) )
+            continue;
+
+        if( (addr < 1) || (addr > K_INSTRMAX) )
+        {
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"illegal addr %d for %s",addr,drvInfo);
+            return( asynError );
+        }
+
+        pinst = callocMustSucceed(sizeof(Inst),sizeof(char),"drvLove::create");
+        initInst(pinst,pport,addr,findCommand(rampRegs[i / rpCount]));
+        pinst->ramp = i;
+
+        /* Each ramp owns the asynUser its steps are queued with */
+        pramp = &pinst->pinfo->ramps[i / rpCount];
+        epicsMutexMustLock(pport->rampLock);
+        if( pramp->pasynUser == NULL )
+        {
+            pramp->addr = addr;
+            pramp->idx = i / rpCount;
+            pramp->pars[rpPeriod] = K_RAMPPER;
+            pramp->pasynUser = pasynManager->createAsynUser(rampStep,NULL);
+            pramp->pasynUser->userPvt = pport;
+            pramp->pasynUser->userData = pramp;
+            pramp->pasynUser->timeout = K_COMTMO;
+            if( ISNOTOK(pasynManager->connectDevice(pramp->pasynUser,pport->name,addr)) )
+            {
+                pasynManager->freeAsynUser(pramp->pasynUser);
+                pramp->pasynUser = NULL;
+            }
+        }
+        epicsMutexUnlock(pport->rampLock);
+
+        if( pramp->pasynUser == NULL )
+        {
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"failure to connect ramp %s",drvInfo);
+            free(pinst);
+            return( asynError );
+        }
+
+        pasynUser->drvUser = (void*)pinst;
+        epicsAtomicIncrIntT(&pport->nInsts);
+
+        return( asynSuccess );
+    }
+
+    /* The age of a register is its command name followed by "Age" */
+    for( i = 0; i < cmdCount; ++i )
+    {
+        size_t len = strlen(CmdTable[i].pname);
+
+        if( epicsStrnCaseCmp(CmdTable[i].pname,drvInfo,len) || epicsStrCaseCmp(drvInfo + len,"Age") )
+            continue;
+
+        if( (addr < 1) || (addr > K_INSTRMAX) )
+        {
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"illegal addr %d for %s",addr,drvInfo);
+            return( asynError );
+        }
+
+        pinst = callocMustSucceed(sizeof(Inst),sizeof(char),"drvLove::create");
+        initInst(pinst,pport,addr,i);
+        pinst->isAge = 1;
+        pasynUser->drvUser = (void*)pinst;
+        epicsAtomicIncrIntT(&pport->nInsts);
+
+        return( asynSuccess );
+    }
+
+    i = findCommand(drvInfo);
+    if( i >= 0 )
+    {
+        if( (addr < 1) || (addr > K_INSTRMAX) )
+        {
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"illegal addr %d for command %s",addr,drvInfo);
+            return( asynError );
+        }
+
+        pinst = callocMustSucceed(sizeof(Inst),sizeof(char),"drvLove::create");
+        initInst(pinst,pport,addr,i);
+
+        /* Command instances are kept for the bus-time ranking */
+        epicsMutexMustLock(pport->instLock);
+        pinst->pnext = pport->pinsts;
+        pport->pinsts = pinst;
+        epicsMutexUnlock(pport->instLock);
+
+        pasynUser->drvUser = (void*)pinst;
+        epicsAtomicIncrIntT(&pport->nInsts);
+
+        return( asynSuccess );
+    }
+
     epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"failure to find command %s",drvInfo);
     return( asynError );
 }
@@ -1159,6 +8456,19 @@ static asynStatus destroy(void* ppvt,asynUser* pasynUser)
 
     if( pport )
     {
+        Inst** ppinst;
+
+        epicsMutexMustLock(pport->instLock);
+        for( ppinst = &pport->pinsts; *ppinst; ppinst = &(*ppinst)->pnext )
+            if( *ppinst == (Inst*)pasynUser->drvUser )
+            {
+                *ppinst = (*ppinst)->pnext;
+                break;
+            }
+        epicsMutexUnlock(pport->instLock);
+
+        if( pasynUser->drvUser )
+            epicsAtomicDecrIntT(&pport->nInsts);
         free(pasynUser->drvUser);
         pasynUser->drvUser = NULL;
 
@@ -1186,69 +8496,268 @@ static asynStatus writeInt32(void* ppvt,asynUser* pasynUser,epicsInt32 value)
 
     asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::writeInt32\n");
 
-    sts = pinst->write(pinst,&value);
-    if( ISNOTOK(sts) )
+    if( pinst->ramp >= 0 )
+        return( writeRamp(pport,pinst,pasynUser,value) );
+
+    if( pinst->param == parSnapshot )
+        return( startSnapshot() );
+
+    if( (pinst->param >= 0) || pinst->isAge )
     {
-        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pport->name,pport->pasynUser->errorMessage);
-        return( sts );
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s %s%s is read-only",pport->name,(pinst->isAge)?CmdTable[pinst->cmdidx].pname:ParamName[pinst->param],(pinst->isAge)?"Age":"");
+        return( asynError );
     }
 
-    lockPort(pport,pasynUser);
-    sts = executeCommand(pport,pasynUser);
-    unlockPort(pport,pasynUser);
+    if( deferWrite(pport,pinst,value) )
+    {
+        asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::writeInt32 %s restore pending %d\n",pport->name,value);
+        return( asynSuccess );
+    }
 
+    if( pport->bus.isEngine )
+        sts = engineWrite(pport,pinst,pasynUser,value);
+    else
+        sts = writeCommand(pport,pinst,pasynUser,value);
     if( ISNOTOK(sts) )
     {
+        clearCache(pinst);
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pport->name,pport->pasynUser->errorMessage);
         return( sts );
     }
+    return( asynSuccess );
+}
+
+
+static asynStatus readInt32(void* ppvt,asynUser* pasynUser,epicsInt32* value)
+{
+    asynStatus sts;
+    Port* pport = (Port*)ppvt;
+    Inst* pinst = (Inst*)pasynUser->drvUser;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::readInt32\n");
+
+    if( pinst->ramp >= 0 )
+    {
+        epicsMutexMustLock(pport->rampLock);
+        *value = pinst->pinfo->ramps[pinst->ramp / rpCount].pars[pinst->ramp % rpCount];
+        epicsMutexUnlock(pport->rampLock);
+        return( asynSuccess );
+    }
+
+    if( pinst->param >= 0 )
+    {
+        *value = pport->params[pinst->param];
+        return( asynSuccess );
+    }
+
+    if( pinst->isAge )
+        return( readAge(pport,pinst,pasynUser,value) );
 
-    sts = processWriteResponse(pport);
+    pasynUser->alarmStatus = epicsAlarmNone;
+    pasynUser->alarmSeverity = epicsSevNone;
+    if( readStale(pport,pinst,pasynUser,value) || readPrimed(pinst,value) || shedRead(pport,pinst,pasynUser,value) )
+        sts = asynSuccess;
+    else if( pport->bus.isEngine )
+        sts = engineRead(pport,pinst,pasynUser,value);
+    else
+        sts = readCommand(pport,pinst,pasynUser,value);
+    epicsTimeGetCurrent(&pinst->done);
+    pinst->isDone = 1;
     if( ISNOTOK(sts) )
     {
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pport->name,pport->pasynUser->errorMessage);
         return( sts );
     }
 
+    stampRead(pport,pinst,pasynUser);
+
+    asynPrint(pasynUser,ASYN_TRACEIO_FILTER,"drvLove::readInt32 readback from %s is %d\n",pport->name,*value);
+
     return( asynSuccess );
 }
 
 
-static asynStatus readInt32(void* ppvt,asynUser* pasynUser,epicsInt32* value)
+/****************************************************************************
+ * Define private interface asynInt32Array methods
+ ****************************************************************************/
+static asynStatus writeInt32Array(void* ppvt,asynUser* pasynUser,epicsInt32* value,size_t nelements)
 {
+    size_t i;
     asynStatus sts;
+    Batch* pbatch;
     Port* pport = (Port*)ppvt;
     Inst* pinst = (Inst*)pasynUser->drvUser;
 
-    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::readInt32\n");
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::writeInt32Array\n");
 
-    if( pinst->pcmd->read )
-        sprintf(pport->outMsg,"%s",pinst->pcmd->read);
-    else
+    if( pinst->param != parDownload )
     {
-        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pport->name,pport->pasynUser->errorMessage);
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s array write not supported",pport->name);
         return( asynError );
     }
 
-    lockPort(pport,pasynUser);
-    sts = executeCommand(pport,pasynUser);
-    unlockPort(pport,pasynUser);
+    if( (nelements == 0) || (nelements % 3) )
+    {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s download requires (addr,register,value) triplets",pport->name);
+        return( asynError );
+    }
 
-    if( ISNOTOK(sts) )
+    pbatch = createBatch(pport,batchDownload);
+    for( i = 0; i < nelements; i += 3 )
     {
-        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pport->name,pport->pasynUser->errorMessage);
-        return( sts );
+        int cmdidx = ((value[i+1] > 0) && (value[i+1] < dlRegCount))?findCommand(dlRegs[value[i+1]]):-1;
+
+        if( ISNOTOK(addStep(pbatch,opWrite,(int)(i / 3) + 1,value[i],cmdidx,value[i+2])) )
+            asynPrint(pasynUser,ASYN_TRACE_ERROR,"drvLove::writeInt32Array entry %d rejected\n",(int)(i / 3) + 1);
     }
 
-    sts = pinst->read(pinst,value);
+    sts = startBatch(pbatch);
     if( ISNOTOK(sts) )
     {
-        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pport->name,pport->pasynUser->errorMessage);
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s download already in progress",pport->name);
+        freeBatch(pbatch);
         return( sts );
     }
 
-    if( ISOK(sts) )
-        asynPrint(pasynUser,ASYN_TRACEIO_FILTER,"drvLove::readInt32 readback from %s is %d\n",pport->name,*value);
+    return( asynSuccess );
+}
+
+
+static asynStatus readInt32Array(void* ppvt,asynUser* pasynUser,epicsInt32* value,size_t nelements,size_t* nIn)
+{
+    size_t count;
+    Port* pport = (Port*)ppvt;
+    Inst* pinst = (Inst*)pasynUser->drvUser;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::readInt32Array\n");
+
+    if( (pinst->param == parListAddr) || (pinst->param == parListAlSts) )
+    {
+        List* plist = &pport->list;
+
+        /* Without a poll scheduler there are no sweeps, a read takes the snapshot */
+        if( sweepGroup(pport) == NULL )
+            buildList(plist->pasynUser);
+
+        count = (nelements < (size_t)plist->count)?nelements:(size_t)plist->count;
+        memcpy(value,(pinst->param == parListAddr)?plist->addrs:plist->alsts,count * sizeof(epicsInt32));
+        pasynUser->timestamp = plist->stamp;
+        *nIn = count;
+
+        return( asynSuccess );
+    }
+
+    if( (pinst->param == parTopAddr) || (pinst->param == parTopCmd) )
+    {
+        Top* ptop = &pport->top;
+
+        if( sweepGroup(pport) == NULL )
+            buildTop(pport);
+
+        count = (nelements < (size_t)ptop->count)?nelements:(size_t)ptop->count;
+        memcpy(value,(pinst->param == parTopAddr)?ptop->addrs:ptop->cmds,count * sizeof(epicsInt32));
+        pasynUser->timestamp = ptop->stamp;
+        *nIn = count;
+
+        return( asynSuccess );
+    }
+
+    if( (pinst->param == parSnapAddr) || (pinst->param == parSnapCmd) )
+    {
+        Shot* pshot = &pport->shot;
+
+        count = (nelements < (size_t)pshot->count)?nelements:(size_t)pshot->count;
+        memcpy(value,(pinst->param == parSnapAddr)?pshot->addrs:pshot->cmds,count * sizeof(epicsInt32));
+        pasynUser->timestamp = snap.stamp;
+        *nIn = count;
+
+        return( asynSuccess );
+    }
+
+    if( pinst->param != parDlStatus )
+    {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s array read not supported",pport->name);
+        return( asynError );
+    }
+
+    count = 0;
+    if( pport->pbatch[batchDownload] )
+    {
+        Batch* pbatch = pport->pbatch[batchDownload];
+
+        count = (nelements < (size_t)pbatch->count)?nelements:(size_t)pbatch->count;
+        memcpy(value,pbatch->pstatus,count * sizeof(epicsInt32));
+    }
+    *nIn = count;
+
+    return( asynSuccess );
+}
+
+
+/****************************************************************************
+ * Define private interface asynFloat64Array methods
+ ****************************************************************************/
+static asynStatus writeFloat64Array(void* ppvt,asynUser* pasynUser,epicsFloat64* value,size_t nelements)
+{
+    Port* pport = (Port*)ppvt;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::writeFloat64Array\n");
+
+    epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s array write not supported",pport->name);
+    return( asynError );
+}
+
+
+static asynStatus readFloat64Array(void* ppvt,asynUser* pasynUser,epicsFloat64* value,size_t nelements,size_t* nIn)
+{
+    size_t count;
+    Port* pport = (Port*)ppvt;
+    List* plist = &pport->list;
+    Inst* pinst = (Inst*)pasynUser->drvUser;
+
+    asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::readFloat64Array\n");
+
+    if( (pinst->param == parTopShare) || (pinst->param == parCmdShare) )
+    {
+        Top* ptop = &pport->top;
+
+        if( sweepGroup(pport) == NULL )
+            buildTop(pport);
+
+        count = (size_t)((pinst->param == parTopShare)?ptop->count:cmdCount);
+        count = (nelements < count)?nelements:count;
+        memcpy(value,(pinst->param == parTopShare)?ptop->shares:ptop->cmdShares,count * sizeof(epicsFloat64));
+        pasynUser->timestamp = ptop->stamp;
+        *nIn = count;
+
+        return( asynSuccess );
+    }
+
+    if( (pinst->param == parSnapValue) || (pinst->param == parSnapTime) )
+    {
+        Shot* pshot = &pport->shot;
+
+        count = (nelements < (size_t)pshot->count)?nelements:(size_t)pshot->count;
+        memcpy(value,(pinst->param == parSnapValue)?pshot->values:pshot->times,count * sizeof(epicsFloat64));
+        pasynUser->timestamp = snap.stamp;
+        *nIn = count;
+
+        return( asynSuccess );
+    }
+
+    if( (pinst->param != parListValue) && (pinst->param != parListAge) )
+    {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s array read not supported",pport->name);
+        return( asynError );
+    }
+
+    if( sweepGroup(pport) == NULL )
+        buildList(plist->pasynUser);
+
+    count = (nelements < (size_t)plist->count)?nelements:(size_t)plist->count;
+    memcpy(value,(pinst->param == parListValue)?plist->values:plist->ages,count * sizeof(epicsFloat64));
+    pasynUser->timestamp = plist->stamp;
+    *nIn = count;
 
     return( asynSuccess );
 }
@@ -1265,30 +8774,28 @@ static asynStatus writeUInt32(void* ppvt,asynUser* pasynUser,epicsUInt32 value,e
 
     asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::writeUInt32\n");
 
-    sts = pinst->write(pinst,(epicsInt32*)&value);
-    if( ISNOTOK(sts) )
+    if( (pinst->param >= 0) || pinst->isAge )
     {
-        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pport->name,pport->pasynUser->errorMessage);
-        return( sts );
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s %s%s is read-only",pport->name,(pinst->isAge)?CmdTable[pinst->cmdidx].pname:ParamName[pinst->param],(pinst->isAge)?"Age":"");
+        return( asynError );
     }
 
-    lockPort(pport,pasynUser);
-    sts = executeCommand(pport,pasynUser);
-    unlockPort(pport,pasynUser);
-
-    if( ISNOTOK(sts) )
+    if( deferWrite(pport,pinst,(epicsInt32)value) )
     {
-        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pport->name,pport->pasynUser->errorMessage);
-        return( sts );
+        asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::writeUInt32 %s restore pending 0x%X\n",pport->name,value);
+        return( asynSuccess );
     }
 
-    sts = processWriteResponse(pport);
+    if( pport->bus.isEngine )
+        sts = engineWrite(pport,pinst,pasynUser,(epicsInt32)value);
+    else
+        sts = writeCommand(pport,pinst,pasynUser,(epicsInt32)value);
     if( ISNOTOK(sts) )
     {
+        clearCache(pinst);
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pport->name,pport->pasynUser->errorMessage);
         return( sts );
     }
-
     return( asynSuccess );
 }
 
@@ -1296,38 +8803,44 @@ static asynStatus writeUInt32(void* ppvt,asynUser* pasynUser,epicsUInt32 value,e
 static asynStatus readUInt32(void* ppvt,asynUser* pasynUser,epicsUInt32* value,epicsUInt32 mask)
 {
     asynStatus sts;
+    epicsInt32 data;
     Port* pport = (Port*)ppvt;
     Inst* pinst = (Inst*)pasynUser->drvUser;
 
     asynPrint(pasynUser,ASYN_TRACE_FLOW,"drvLove::readUInt32\n");
 
-    if( pinst->pcmd->read )
-        sprintf(pport->outMsg,"%s",pinst->pcmd->read);
-    else
+    if( pinst->param >= 0 )
     {
-        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pport->name,pport->pasynUser->errorMessage);
-        return( asynError );
+        *value = (epicsUInt32)pport->params[pinst->param] & mask;
+        return( asynSuccess );
     }
 
-    lockPort(pport,pasynUser);
-    sts = executeCommand(pport,pasynUser);
-    unlockPort(pport,pasynUser);
-
-    if( ISNOTOK(sts) )
+    if( pinst->isAge )
     {
-        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pport->name,pport->pasynUser->errorMessage);
+        sts = readAge(pport,pinst,pasynUser,&data);
+        *value = (epicsUInt32)data & mask;
         return( sts );
     }
 
-    sts = pinst->read(pinst,(epicsInt32*)value);
+    pasynUser->alarmStatus = epicsAlarmNone;
+    pasynUser->alarmSeverity = epicsSevNone;
+    if( readStale(pport,pinst,pasynUser,&data) || readPrimed(pinst,&data) || shedRead(pport,pinst,pasynUser,&data) )
+        sts = asynSuccess;
+    else if( pport->bus.isEngine )
+        sts = engineRead(pport,pinst,pasynUser,&data);
+    else
+        sts = readCommand(pport,pinst,pasynUser,&data);
+    epicsTimeGetCurrent(&pinst->done);
+    pinst->isDone = 1;
     if( ISNOTOK(sts) )
     {
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,"%s error %s",pport->name,pport->pasynUser->errorMessage);
         return( sts );
     }
+    *value = (epicsUInt32)data;
+    stampRead(pport,pinst,pasynUser);
 
-    if( ISOK(sts) )
-        asynPrint(pasynUser,ASYN_TRACEIO_FILTER,"drvLove::readUInt32 readback from %s is 0x%X,mask=0x%X\n",pport->name,*value,mask);
+    asynPrint(pasynUser,ASYN_TRACEIO_FILTER,"drvLove::readUInt32 readback from %s is 0x%X,mask=0x%X\n",pport->name,*value,mask);
 
     return( asynSuccess );
 }
@@ -1341,11 +8854,12 @@ static asynStatus readUInt32(void* ppvt,asynUser* pasynUser,epicsUInt32* value,e
 static const iocshArg drvLoveInitArg0 = {"lovPort",iocshArgString};
 static const iocshArg drvLoveInitArg1 = {"serPort",iocshArgString};
 static const iocshArg drvLoveInitArg2 = {"serAddr",iocshArgInt};
-static const iocshArg* drvLoveInitArgs[]= {&drvLoveInitArg0,&drvLoveInitArg1,&drvLoveInitArg2};
-static const iocshFuncDef drvLoveInitFuncDef = {"drvLoveInit",3,drvLoveInitArgs};
+static const iocshArg drvLoveInitArg3 = {"protocol",iocshArgString};
+static const iocshArg* drvLoveInitArgs[]= {&drvLoveInitArg0,&drvLoveInitArg1,&drvLoveInitArg2,&drvLoveInitArg3};
+static const iocshFuncDef drvLoveInitFuncDef = {"drvLoveInit",4,drvLoveInitArgs};
 static void drvLoveInitCallFunc(const iocshArgBuf* args)
 {
-    drvLoveInit(args[0].sval,args[1].sval,args[2].ival);
+    drvLoveInit(args[0].sval,args[1].sval,args[2].ival,args[3].sval);
 }
 
 static const iocshArg drvLoveConfigArg0 = {"lovPort",iocshArgString};
@@ -1358,6 +8872,163 @@ static void drvLoveConfigCallFunc(const iocshArgBuf* args)
     drvLoveConfig(args[0].sval,args[1].ival,args[2].sval);
 }
 
+static const iocshArg drvLoveDownloadArg0 = {"file",iocshArgString};
+static const iocshArg drvLoveDownloadArg1 = {"wait",iocshArgInt};
+static const iocshArg* drvLoveDownloadArgs[]= {&drvLoveDownloadArg0,&drvLoveDownloadArg1};
+static const iocshFuncDef drvLoveDownloadFuncDef = {"drvLoveDownload",2,drvLoveDownloadArgs};
+static void drvLoveDownloadCallFunc(const iocshArgBuf* args)
+{
+    drvLoveDownload(args[0].sval,args[1].ival);
+}
+
+static const iocshArg drvLoveRestoreArg0 = {"lovPort",iocshArgString};
+static const iocshArg* drvLoveRestoreArgs[]= {&drvLoveRestoreArg0};
+static const iocshFuncDef drvLoveRestoreFuncDef = {"drvLoveRestore",1,drvLoveRestoreArgs};
+static void drvLoveRestoreCallFunc(const iocshArgBuf* args)
+{
+    drvLoveRestore(args[0].sval);
+}
+
+static const iocshArg drvLoveWarmupArg0 = {"lovPort",iocshArgString};
+static const iocshArg* drvLoveWarmupArgs[]= {&drvLoveWarmupArg0};
+static const iocshFuncDef drvLoveWarmupFuncDef = {"drvLoveWarmup",1,drvLoveWarmupArgs};
+static void drvLoveWarmupCallFunc(const iocshArgBuf* args)
+{
+    drvLoveWarmup(args[0].sval);
+}
+
+static const iocshArg drvLoveCacheArg0 = {"lovPort",iocshArgString};
+static const iocshArg drvLoveCacheArg1 = {"file",iocshArgString};
+static const iocshArg drvLoveCacheArg2 = {"period",iocshArgDouble};
+static const iocshArg* drvLoveCacheArgs[]= {&drvLoveCacheArg0,&drvLoveCacheArg1,&drvLoveCacheArg2};
+static const iocshFuncDef drvLoveCacheFuncDef = {"drvLoveCache",3,drvLoveCacheArgs};
+static void drvLoveCacheCallFunc(const iocshArgBuf* args)
+{
+    drvLoveCache(args[0].sval,args[1].sval,args[2].dval);
+}
+
+static const iocshArg drvLovePollArg0 = {"lovPort",iocshArgString};
+static const iocshArg drvLovePollArg1 = {"fast",iocshArgDouble};
+static const iocshArg drvLovePollArg2 = {"slow",iocshArgDouble};
+static const iocshArg* drvLovePollArgs[]= {&drvLovePollArg0,&drvLovePollArg1,&drvLovePollArg2};
+static const iocshFuncDef drvLovePollFuncDef = {"drvLovePoll",3,drvLovePollArgs};
+static void drvLovePollCallFunc(const iocshArgBuf* args)
+{
+    drvLovePoll(args[0].sval,args[1].dval,args[2].dval);
+}
+
+static const iocshArg drvLoveHistoryArg0 = {"lovPort",iocshArgString};
+static const iocshArg drvLoveHistoryArg1 = {"file",iocshArgString};
+static const iocshArg drvLoveHistoryArg2 = {"depth",iocshArgInt};
+static const iocshArg* drvLoveHistoryArgs[]= {&drvLoveHistoryArg0,&drvLoveHistoryArg1,&drvLoveHistoryArg2};
+static const iocshFuncDef drvLoveHistoryFuncDef = {"drvLoveHistory",3,drvLoveHistoryArgs};
+static void drvLoveHistoryCallFunc(const iocshArgBuf* args)
+{
+    drvLoveHistory(args[0].sval,args[1].sval,args[2].ival);
+}
+
+static const iocshArg drvLoveTopArg0 = {"lovPort",iocshArgString};
+static const iocshArg drvLoveTopArg1 = {"count",iocshArgInt};
+static const iocshArg drvLoveTopArg2 = {"reset",iocshArgInt};
+static const iocshArg* drvLoveTopArgs[]= {&drvLoveTopArg0,&drvLoveTopArg1,&drvLoveTopArg2};
+static const iocshFuncDef drvLoveTopFuncDef = {"drvLoveTop",3,drvLoveTopArgs};
+static void drvLoveTopCallFunc(const iocshArgBuf* args)
+{
+    drvLoveTop(args[0].sval,args[1].ival,args[2].ival);
+}
+
+static const iocshArg drvLoveDemandArg0 = {"lovPort",iocshArgString};
+static const iocshArg drvLoveDemandArg1 = {"idle",iocshArgDouble};
+static const iocshArg* drvLoveDemandArgs[]= {&drvLoveDemandArg0,&drvLoveDemandArg1};
+static const iocshFuncDef drvLoveDemandFuncDef = {"drvLoveDemand",2,drvLoveDemandArgs};
+static void drvLoveDemandCallFunc(const iocshArgBuf* args)
+{
+    drvLoveDemand(args[0].sval,args[1].dval);
+}
+
+static const iocshArg drvLoveSchedArg0 = {"lovPort",iocshArgString};
+static const iocshArg drvLoveSchedArg1 = {"priority",iocshArgInt};
+static const iocshArg drvLoveSchedArg2 = {"fifo",iocshArgInt};
+static const iocshArg drvLoveSchedArg3 = {"cpus",iocshArgString};
+static const iocshArg drvLoveSchedArg4 = {"lock",iocshArgInt};
+static const iocshArg* drvLoveSchedArgs[]= {&drvLoveSchedArg0,&drvLoveSchedArg1,&drvLoveSchedArg2,&drvLoveSchedArg3,&drvLoveSchedArg4};
+static const iocshFuncDef drvLoveSchedFuncDef = {"drvLoveSched",5,drvLoveSchedArgs};
+static void drvLoveSchedCallFunc(const iocshArgBuf* args)
+{
+    drvLoveSched(args[0].sval,args[1].ival,args[2].ival,args[3].sval,args[4].ival);
+}
+
+static const iocshArg drvLoveBenchArg0 = {"lovPort",iocshArgString};
+static const iocshArg drvLoveBenchArg1 = {"addr",iocshArgInt};
+static const iocshArg drvLoveBenchArg2 = {"command",iocshArgString};
+static const iocshArg drvLoveBenchArg3 = {"count",iocshArgInt};
+static const iocshArg drvLoveBenchArg4 = {"window",iocshArgDouble};
+static const iocshArg drvLoveBenchArg5 = {"gaps",iocshArgString};
+static const iocshArg drvLoveBenchArg6 = {"timeouts",iocshArgString};
+static const iocshArg* drvLoveBenchArgs[]= {&drvLoveBenchArg0,&drvLoveBenchArg1,&drvLoveBenchArg2,&drvLoveBenchArg3,&drvLoveBenchArg4,&drvLoveBenchArg5,&drvLoveBenchArg6};
+static const iocshFuncDef drvLoveBenchFuncDef = {"drvLoveBench",7,drvLoveBenchArgs};
+static void drvLoveBenchCallFunc(const iocshArgBuf* args)
+{
+    drvLoveBench(args[0].sval,args[1].ival,args[2].sval,args[3].ival,args[4].dval,args[5].sval,args[6].sval);
+}
+
+static const iocshArg drvLoveSnapshotArg0 = {"registers",iocshArgString};
+static const iocshArg drvLoveSnapshotArg1 = {"wait",iocshArgInt};
+static const iocshArg* drvLoveSnapshotArgs[]= {&drvLoveSnapshotArg0,&drvLoveSnapshotArg1};
+static const iocshFuncDef drvLoveSnapshotFuncDef = {"drvLoveSnapshot",2,drvLoveSnapshotArgs};
+static void drvLoveSnapshotCallFunc(const iocshArgBuf* args)
+{
+    drvLoveSnapshot(args[0].sval,args[1].ival);
+}
+
+static const iocshArg drvLoveStaleArg0 = {"lovPort",iocshArgString};
+static const iocshArg drvLoveStaleArg1 = {"seconds",iocshArgDouble};
+static const iocshArg* drvLoveStaleArgs[]= {&drvLoveStaleArg0,&drvLoveStaleArg1};
+static const iocshFuncDef drvLoveStaleFuncDef = {"drvLoveStale",2,drvLoveStaleArgs};
+static void drvLoveStaleCallFunc(const iocshArgBuf* args)
+{
+    drvLoveStale(args[0].sval,args[1].dval);
+}
+
+static const iocshArg drvLoveGapArg0 = {"lovPort",iocshArgString};
+static const iocshArg drvLoveGapArg1 = {"seconds",iocshArgDouble};
+static const iocshArg* drvLoveGapArgs[]= {&drvLoveGapArg0,&drvLoveGapArg1};
+static const iocshFuncDef drvLoveGapFuncDef = {"drvLoveGap",2,drvLoveGapArgs};
+static void drvLoveGapCallFunc(const iocshArgBuf* args)
+{
+    drvLoveGap(args[0].sval,args[1].dval);
+}
+
+static const iocshArg drvLoveVerifyArg0 = {"lovPort",iocshArgString};
+static const iocshArg drvLoveVerifyArg1 = {"enable",iocshArgInt};
+static const iocshArg* drvLoveVerifyArgs[]= {&drvLoveVerifyArg0,&drvLoveVerifyArg1};
+static const iocshFuncDef drvLoveVerifyFuncDef = {"drvLoveVerify",2,drvLoveVerifyArgs};
+static void drvLoveVerifyCallFunc(const iocshArgBuf* args)
+{
+    drvLoveVerify(args[0].sval,args[1].ival);
+}
+
+static const iocshArg drvLoveRemoveArg0 = {"lovPort",iocshArgString};
+static const iocshArg drvLoveRemoveArg1 = {"addr",iocshArgInt};
+static const iocshArg* drvLoveRemoveArgs[]= {&drvLoveRemoveArg0,&drvLoveRemoveArg1};
+static const iocshFuncDef drvLoveRemoveFuncDef = {"drvLoveRemove",2,drvLoveRemoveArgs};
+static void drvLoveRemoveCallFunc(const iocshArgBuf* args)
+{
+    drvLoveRemove(args[0].sval,args[1].ival);
+}
+
+static const iocshArg drvLoveSoakArg0 = {"lovPort",iocshArgString};
+static const iocshArg drvLoveSoakArg1 = {"period",iocshArgDouble};
+static const iocshArg drvLoveSoakArg2 = {"hours",iocshArgDouble};
+static const iocshArg drvLoveSoakArg3 = {"faults",iocshArgDouble};
+static const iocshArg drvLoveSoakArg4 = {"churn",iocshArgInt};
+static const iocshArg* drvLoveSoakArgs[]= {&drvLoveSoakArg0,&drvLoveSoakArg1,&drvLoveSoakArg2,&drvLoveSoakArg3,&drvLoveSoakArg4};
+static const iocshFuncDef drvLoveSoakFuncDef = {"drvLoveSoak",5,drvLoveSoakArgs};
+static void drvLoveSoakCallFunc(const iocshArgBuf* args)
+{
+    drvLoveSoak(args[0].sval,args[1].dval,args[2].dval,args[3].dval,args[4].ival);
+}
+
 /* Registration method */
 static void drvLoveRegister(void)
 {
@@ -1368,6 +9039,22 @@ static void drvLoveRegister(void)
         firstTime = 0;
         iocshRegister( &drvLoveInitFuncDef, drvLoveInitCallFunc );
         iocshRegister( &drvLoveConfigFuncDef, drvLoveConfigCallFunc );
+        iocshRegister( &drvLoveDownloadFuncDef, drvLoveDownloadCallFunc );
+        iocshRegister( &drvLoveRestoreFuncDef, drvLoveRestoreCallFunc );
+        iocshRegister( &drvLoveWarmupFuncDef, drvLoveWarmupCallFunc );
+        iocshRegister( &drvLoveCacheFuncDef, drvLoveCacheCallFunc );
+        iocshRegister( &drvLovePollFuncDef, drvLovePollCallFunc );
+        iocshRegister( &drvLoveHistoryFuncDef, drvLoveHistoryCallFunc );
+        iocshRegister( &drvLoveVerifyFuncDef, drvLoveVerifyCallFunc );
+        iocshRegister( &drvLoveTopFuncDef, drvLoveTopCallFunc );
+        iocshRegister( &drvLoveDemandFuncDef, drvLoveDemandCallFunc );
+        iocshRegister( &drvLoveSchedFuncDef, drvLoveSchedCallFunc );
+        iocshRegister( &drvLoveBenchFuncDef, drvLoveBenchCallFunc );
+        iocshRegister( &drvLoveSnapshotFuncDef, drvLoveSnapshotCallFunc );
+        iocshRegister( &drvLoveStaleFuncDef, drvLoveStaleCallFunc );
+        iocshRegister( &drvLoveGapFuncDef, drvLoveGapCallFunc );
+        iocshRegister( &drvLoveSoakFuncDef, drvLoveSoakCallFunc );
+        iocshRegister( &drvLoveRemoveFuncDef, drvLoveRemoveCallFunc );
     }
 }
 epicsExportRegistrar( drvLoveRegister );
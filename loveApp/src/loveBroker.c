@@ -0,0 +1,747 @@
+/*
+
+                          Love Controller Bus Broker
+
+ -----------------------------------------------------------------------------
+ Description
+    This program owns one RS-485 tty and lets several IOCs share the
+    controllers on it. Each IOC runs drvLove with a serPort of the form
+    "unix:<socket>" and sends its frames to the broker instead of the tty.
+
+        loveBroker [-r] [-b baud] [-f framing] [-g gap] [-t timeout]
+                   [-a age] [-v] device socket
+
+        Where:
+            -r       - Modbus RTU framing (default Love ASCII)
+            -b       - Baud rate (default 19200)
+            -f       - Framing (default 8N1)
+            -g       - Bus gap in seconds (default 0.1 ASCII, 4.5
+                       character times RTU)
+            -t       - Default reply timeout in seconds (default 1.0)
+            -a       - Reply cache age in seconds (default 0, disabled)
+            -v       - Print every bus transaction
+            device   - tty device (i.e. "/dev/ttyS0" )
+            socket   - Unix-domain socket path (i.e. "/tmp/love0" )
+
+    Requests are served in arrival order, one bus transaction at a time.
+    The bus runs as a state machine in the poll loop, the way the drvLove
+    engine runs an event port: clients are read and queued while the gap
+    runs out and while the reply arrives.
+    A read that is identical to one still queued is not sent again; every
+    client waiting for it gets the one reply. With -a, the reply to a read
+    is kept for that long and identical reads are answered from it. A
+    write to an address drops the cached replies of that address. Writes
+    are never merged or cached.
+
+    The broker does not decode values. It links the drvLove frame codec
+    (loveFrame.c), so it delimits replies, tells reads from writes and
+    finds the address of a frame with the same code and model tables.
+
+    SIGUSR1 prints the request, transaction and cache counters.
+
+ History:
+ -----------------------------------------------------------------------------
+ 2026-Oct-18       Initial version.
+ 2026-Oct-18       Shared the frame codec with drvLove, non-blocking bus.
+ -----------------------------------------------------------------------------
+
+*/
+
+
+/* System related include files */
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+/* Broker wire format and frame codec */
+#include "loveBroker.h"
+#include "loveFrame.h"
+
+
+/* Define symbolic constants */
+#define K_CLIENTMAX ( 32 )
+#define K_PENDMAX   ( 64 )
+#define K_CACHEMAX  ( 256 )
+#define K_BAUD      ( 19200 )
+#define K_GAP       ( 0.1 )
+#define K_TIMEOUT   ( 1.0 )
+#define K_MSGMAX    ( sizeof(LoveBrokerHdr) + LOVEBROKER_FRAMEMAX )
+
+
+/* Declare client connection structure */
+typedef struct Client
+{
+    int           fd;
+    size_t        inLen;
+    unsigned char inBuf[K_MSGMAX];
+    unsigned long nRequests;
+} Client;
+
+
+/* Declare queued request structure, one bus transaction for all waiters */
+typedef struct Waiter
+{
+    int           client;
+    unsigned int  seq;
+} Waiter;
+
+typedef struct Pend
+{
+    int           inUse;
+    int           isRead;
+    unsigned long order;
+    double        timeout;
+    size_t        len;
+    unsigned char frame[LOVEBROKER_FRAMEMAX];
+    int           nWaiters;
+    Waiter        waiters[K_CLIENTMAX];
+} Pend;
+
+
+/* Declare reply cache entry structure */
+typedef struct Entry
+{
+    int           inUse;
+    double        when;
+    size_t        len;
+    unsigned char frame[LOVEBROKER_FRAMEMAX];
+    size_t        repLen;
+    unsigned char reply[LOVEBROKER_FRAMEMAX];
+} Entry;
+
+
+/* Declare bus states, as those of a drvLove event port */
+typedef enum {busIdle,busGap,busRecv} BusState;
+
+
+/* Declare broker structure */
+typedef struct Broker
+{
+    int           isRtu;
+    int           isVerbose;
+    int           fd;
+    int           lfd;
+    double        gap;
+    double        timeout;
+    double        age;
+    double        lastBus;
+    double        due;
+    BusState      state;
+    Pend          cur;
+    size_t        repLen;
+    unsigned char reply[LOVEBROKER_FRAMEMAX];
+    unsigned long order;
+    unsigned long nRequests;
+    unsigned long nTransactions;
+    unsigned long nShared;
+    unsigned long nCached;
+    unsigned long nTimeouts;
+    unsigned long nErrors;
+    Client        clients[K_CLIENTMAX];
+    Pend          pends[K_PENDMAX];
+    Entry         cache[K_CACHEMAX];
+} Broker;
+
+
+/* Forward references */
+static double timeNow(void);
+static void usage(const char* name);
+static int openTty(const char* dev,int baud,const char* framing);
+static int openSocket(const char* path);
+static void acceptClient(void);
+static void closeClient(int idx);
+static void readClient(int idx);
+static void handleRequest(int idx,const LoveBrokerHdr* phdr,const unsigned char* frame);
+static void sendReply(int idx,unsigned int seq,unsigned int status,const unsigned char* reply,size_t len);
+static double busStep(double now);
+static void busRead(double now);
+static void busDone(int sts,double now);
+static void invalidate(const unsigned char* frame,size_t len);
+static void report(void);
+static void onReport(int sig);
+
+
+/* Define global variables */
+static Broker broker;
+static volatile sig_atomic_t reportFlag = 0;
+
+
+/****************************************************************************
+ * Define main program
+ ****************************************************************************/
+int main(int argc,char* argv[])
+{
+    int i,n,opt,baud,nfds,ttyIdx;
+    int map[K_CLIENTMAX + 1];
+    const char* framing;
+    double charTime,wait;
+    struct pollfd pfds[K_CLIENTMAX + 2];
+
+    baud = K_BAUD;
+    framing = "8N1";
+    broker.gap = -1.0;
+    broker.timeout = K_TIMEOUT;
+    while( (opt = getopt(argc,argv,"rb:f:g:t:a:v")) != -1 )
+        switch( opt )
+        {
+        case 'r': broker.isRtu = 1; break;
+        case 'b': baud = atoi(optarg); break;
+        case 'f': framing = optarg; break;
+        case 'g': broker.gap = atof(optarg); break;
+        case 't': broker.timeout = atof(optarg); break;
+        case 'a': broker.age = atof(optarg); break;
+        case 'v': broker.isVerbose = 1; break;
+        default:  usage(argv[0]); return( 1 );
+        }
+    if( (argc - optind) != 2 )
+    {
+        usage(argv[0]);
+        return( 1 );
+    }
+
+    broker.fd = openTty(argv[optind],baud,framing);
+    if( broker.fd < 0 )
+        return( 1 );
+
+    /* RTU frames are separated by at least 3.5 character times of silence */
+    charTime = (1.0 + (framing[0] - '0') + (toupper((int)framing[1]) != 'N') + (framing[2] - '0')) / baud;
+    if( broker.gap < 0.0 )
+        broker.gap = (broker.isRtu)?(4.5 * charTime):K_GAP;
+
+    broker.lfd = openSocket(argv[optind + 1]);
+    if( broker.lfd < 0 )
+        return( 1 );
+
+    for( i = 0; i < K_CLIENTMAX; ++i )
+        broker.clients[i].fd = -1;
+
+    /* Progress lines reach a log file as they happen */
+    setvbuf(stdout,NULL,_IOLBF,0);
+    signal(SIGPIPE,SIG_IGN);
+    signal(SIGUSR1,onReport);
+    printf("loveBroker::serving %s (%s, %d %s, gap %.3f sec, cache %.3f sec) on %s\n",argv[optind],(broker.isRtu)?"RTU":"ASCII",
+           baud,framing,broker.gap,broker.age,argv[optind + 1]);
+
+    for( ;; )
+    {
+        /* Start what is due on the bus, the wait is up to the next gap or deadline */
+        wait = busStep(timeNow());
+
+        nfds = 0;
+        pfds[nfds].fd = broker.lfd;
+        pfds[nfds++].events = POLLIN;
+        for( i = 0; i < K_CLIENTMAX; ++i )
+            if( broker.clients[i].fd >= 0 )
+            {
+                map[nfds - 1] = i;
+                pfds[nfds].fd = broker.clients[i].fd;
+                pfds[nfds++].events = POLLIN;
+            }
+        ttyIdx = -1;
+        if( broker.state == busRecv )
+        {
+            ttyIdx = nfds;
+            pfds[nfds].fd = broker.fd;
+            pfds[nfds++].events = POLLIN;
+        }
+
+        n = poll(pfds,nfds,(wait < 0.0)?1000:((int)(wait * 1000.0) + 1));
+        if( (n < 0) && (errno != EINTR) )
+        {
+            printf("loveBroker::poll failed - %s\n",strerror(errno));
+            return( 1 );
+        }
+
+        if( n > 0 )
+        {
+            if( (ttyIdx > 0) && pfds[ttyIdx].revents )
+                busRead(timeNow());
+            for( i = 1; i < nfds; ++i )
+                if( (i != ttyIdx) && pfds[i].revents )
+                    readClient(map[i - 1]);
+            if( pfds[0].revents & POLLIN )
+                acceptClient();
+        }
+
+        if( reportFlag )
+        {
+            reportFlag = 0;
+            report();
+        }
+    }
+
+    return( 0 );
+}
+
+
+/****************************************************************************
+ * Define private methods
+ ****************************************************************************/
+static double timeNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+
+    return( ts.tv_sec + (ts.tv_nsec * 1e-9) );
+}
+
+
+static void usage(const char* name)
+{
+    printf("Usage: %s [-r] [-b baud] [-f framing] [-g gap] [-t timeout] [-a age] [-v] device socket\n",name);
+}
+
+
+static int openTty(const char* dev,int baud,const char* framing)
+{
+    int i,fd;
+    speed_t speed;
+    struct termios tio;
+    static const struct {int baud; speed_t speed;} speeds[] =
+    {
+        {1200,B1200},{2400,B2400},{4800,B4800},{9600,B9600},{19200,B19200},{38400,B38400},{57600,B57600},{115200,B115200}
+    };
+
+    if( (strlen(framing) != 3) || (strchr("78",framing[0]) == NULL) || (strchr("NEO",toupper((int)framing[1])) == NULL) || (strchr("12",framing[2]) == NULL) )
+    {
+        printf("loveBroker::illegal framing \"%s\", expected e.g. 8N1\n",framing);
+        return( -1 );
+    }
+
+    for( speed = 0, i = 0; i < (int)(sizeof(speeds) / sizeof(speeds[0])); ++i )
+        if( speeds[i].baud == baud )
+            speed = speeds[i].speed;
+    if( speed == 0 )
+    {
+        printf("loveBroker::unsupported baud rate %d\n",baud);
+        return( -1 );
+    }
+
+    fd = open(dev,O_RDWR | O_NOCTTY);
+    if( fd < 0 )
+    {
+        printf("loveBroker::failure to open %s - %s\n",dev,strerror(errno));
+        return( -1 );
+    }
+
+    /* Raw mode, same settings as the drvLove direct tty transport */
+    memset(&tio,0,sizeof(tio));
+    tio.c_cflag = CREAD | CLOCAL | ((framing[0] == '7')?CS7:CS8);
+    if( toupper((int)framing[1]) != 'N' )
+        tio.c_cflag |= (toupper((int)framing[1]) == 'O')?(PARENB | PARODD):PARENB;
+    if( framing[2] == '2' )
+        tio.c_cflag |= CSTOPB;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio,speed);
+    cfsetospeed(&tio,speed);
+    if( tcsetattr(fd,TCSANOW,&tio) != 0 )
+    {
+        printf("loveBroker::failure to configure %s - %s\n",dev,strerror(errno));
+        close(fd);
+        return( -1 );
+    }
+    tcflush(fd,TCIOFLUSH);
+
+    return( fd );
+}
+
+
+static int openSocket(const char* path)
+{
+    int fd;
+    struct sockaddr_un addr;
+
+    if( strlen(path) >= sizeof(addr.sun_path) )
+    {
+        printf("loveBroker::socket path %s is too long\n",path);
+        return( -1 );
+    }
+
+    memset(&addr,0,sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path,path);
+
+    /* A previous broker may have left its socket behind */
+    unlink(path);
+    fd = socket(AF_UNIX,SOCK_STREAM,0);
+    if( (fd < 0) || (bind(fd,(struct sockaddr*)&addr,sizeof(addr)) != 0) || (listen(fd,K_CLIENTMAX) != 0) )
+    {
+        printf("loveBroker::failure to listen on %s - %s\n",path,strerror(errno));
+        if( fd >= 0 )
+            close(fd);
+        return( -1 );
+    }
+
+    return( fd );
+}
+
+
+static void acceptClient(void)
+{
+    int i,fd;
+
+    fd = accept(broker.lfd,NULL,NULL);
+    if( fd < 0 )
+        return;
+
+    for( i = 0; i < K_CLIENTMAX; ++i )
+        if( broker.clients[i].fd < 0 )
+            break;
+    if( i == K_CLIENTMAX )
+    {
+        printf("loveBroker::client limit %d reached\n",K_CLIENTMAX);
+        close(fd);
+        return;
+    }
+
+    /* A client that stops reading is dropped rather than stalling the bus */
+    fcntl(fd,F_SETFL,fcntl(fd,F_GETFL) | O_NONBLOCK);
+    memset(&broker.clients[i],0,sizeof(Client));
+    broker.clients[i].fd = fd;
+
+    if( broker.isVerbose )
+        printf("loveBroker::client %d connected\n",i);
+}
+
+
+static void closeClient(int idx)
+{
+    int i,j;
+    Pend* ppend;
+
+    close(broker.clients[idx].fd);
+    broker.clients[idx].fd = -1;
+
+    /* Requests nobody waits for any more are not sent */
+    for( i = 0; i < K_PENDMAX; ++i )
+    {
+        ppend = &broker.pends[i];
+        if( ppend->inUse == 0 )
+            continue;
+        for( j = 0; j < ppend->nWaiters; )
+            if( ppend->waiters[j].client == idx )
+                ppend->waiters[j] = ppend->waiters[--ppend->nWaiters];
+            else
+                ++j;
+        if( ppend->nWaiters == 0 )
+            ppend->inUse = 0;
+    }
+
+    /* A transaction on the wire runs to its end, one still in its gap is dropped */
+    ppend = &broker.cur;
+    if( broker.state != busIdle )
+    {
+        for( j = 0; j < ppend->nWaiters; )
+            if( ppend->waiters[j].client == idx )
+                ppend->waiters[j] = ppend->waiters[--ppend->nWaiters];
+            else
+                ++j;
+    }
+    if( (broker.state == busGap) && (ppend->nWaiters == 0) )
+        broker.state = busIdle;
+
+    if( broker.isVerbose )
+        printf("loveBroker::client %d disconnected\n",idx);
+}
+
+
+static void readClient(int idx)
+{
+    ssize_t len;
+    size_t msgLen;
+    LoveBrokerHdr hdr;
+    Client* pclient = &broker.clients[idx];
+
+    len = read(pclient->fd,pclient->inBuf + pclient->inLen,sizeof(pclient->inBuf) - pclient->inLen);
+    if( len <= 0 )
+    {
+        if( (len < 0) && ((errno == EINTR) || (errno == EAGAIN)) )
+            return;
+        closeClient(idx);
+        return;
+    }
+    pclient->inLen += (size_t)len;
+
+    while( pclient->inLen >= sizeof(hdr) )
+    {
+        memcpy(&hdr,pclient->inBuf,sizeof(hdr));
+        if( (hdr.magic != LOVEBROKER_MAGIC) || (hdr.length == 0) || (hdr.length > LOVEBROKER_FRAMEMAX) )
+        {
+            printf("loveBroker::client %d sent a malformed request\n",idx);
+            closeClient(idx);
+            return;
+        }
+
+        msgLen = sizeof(hdr) + hdr.length;
+        if( pclient->inLen < msgLen )
+            break;
+
+        handleRequest(idx,&hdr,pclient->inBuf + sizeof(hdr));
+        if( pclient->fd < 0 )
+            return;
+
+        pclient->inLen -= msgLen;
+        memmove(pclient->inBuf,pclient->inBuf + msgLen,pclient->inLen);
+    }
+}
+
+
+static void handleRequest(int idx,const LoveBrokerHdr* phdr,const unsigned char* frame)
+{
+    int i,isRead;
+    double now,timeout;
+    Pend* ppend;
+    Entry* pent;
+
+    ++broker.nRequests;
+    ++broker.clients[idx].nRequests;
+    isRead = loveFrameIsRead(broker.isRtu,frame,phdr->length);
+    timeout = (phdr->value)?(phdr->value / 1000.0):broker.timeout;
+
+    if( isRead && (broker.age > 0.0) )
+    {
+        now = timeNow();
+        for( i = 0; i < K_CACHEMAX; ++i )
+        {
+            pent = &broker.cache[i];
+            if( pent->inUse && (pent->len == phdr->length) && ((now - pent->when) <= broker.age) && (memcmp(pent->frame,frame,pent->len) == 0) )
+            {
+                ++broker.nCached;
+                sendReply(idx,phdr->seq,LOVEBROKER_OK,pent->reply,pent->repLen);
+                return;
+            }
+        }
+    }
+
+    /* An identical read already queued takes one more waiter */
+    if( isRead )
+        for( i = 0; i < K_PENDMAX; ++i )
+        {
+            ppend = &broker.pends[i];
+            if( ppend->inUse && ppend->isRead && (ppend->len == phdr->length) && (ppend->nWaiters < K_CLIENTMAX) && (memcmp(ppend->frame,frame,ppend->len) == 0) )
+            {
+                ++broker.nShared;
+                ppend->waiters[ppend->nWaiters].client = idx;
+                ppend->waiters[ppend->nWaiters++].seq = phdr->seq;
+                if( timeout > ppend->timeout )
+                    ppend->timeout = timeout;
+                return;
+            }
+        }
+
+    for( i = 0; i < K_PENDMAX; ++i )
+        if( broker.pends[i].inUse == 0 )
+            break;
+    if( i == K_PENDMAX )
+    {
+        sendReply(idx,phdr->seq,LOVEBROKER_ERROR,NULL,0);
+        return;
+    }
+
+    ppend = &broker.pends[i];
+    ppend->inUse = 1;
+    ppend->isRead = isRead;
+    ppend->order = ++broker.order;
+    ppend->timeout = timeout;
+    ppend->len = phdr->length;
+    memcpy(ppend->frame,frame,ppend->len);
+    ppend->nWaiters = 1;
+    ppend->waiters[0].client = idx;
+    ppend->waiters[0].seq = phdr->seq;
+}
+
+
+static void sendReply(int idx,unsigned int seq,unsigned int status,const unsigned char* reply,size_t len)
+{
+    ssize_t sent;
+    LoveBrokerHdr hdr;
+    unsigned char msg[K_MSGMAX];
+    Client* pclient = &broker.clients[idx];
+
+    hdr.magic = LOVEBROKER_MAGIC;
+    hdr.length = (unsigned short)len;
+    hdr.seq = seq;
+    hdr.value = status;
+    memcpy(msg,&hdr,sizeof(hdr));
+    if( len )
+        memcpy(msg + sizeof(hdr),reply,len);
+
+    sent = send(pclient->fd,msg,sizeof(hdr) + len,MSG_NOSIGNAL);
+    if( sent != (ssize_t)(sizeof(hdr) + len) )
+    {
+        printf("loveBroker::client %d not reading, dropped\n",idx);
+        closeClient(idx);
+    }
+}
+
+
+static double busStep(double now)
+{
+    int i;
+    Pend* ppend;
+
+    for( ;; )
+    {
+        if( broker.state == busIdle )
+        {
+            for( ppend = NULL, i = 0; i < K_PENDMAX; ++i )
+                if( broker.pends[i].inUse && ((ppend == NULL) || (broker.pends[i].order < ppend->order)) )
+                    ppend = &broker.pends[i];
+            if( ppend == NULL )
+                return( -1.0 );
+
+            /* The slot is free again, the transaction keeps its own copy */
+            broker.cur = *ppend;
+            ppend->inUse = 0;
+
+            /* The gap runs from the end of the previous frame on the bus */
+            broker.due = broker.lastBus + broker.gap;
+            broker.state = busGap;
+        }
+
+        if( broker.due > now )
+            return( broker.due - now );
+
+        if( broker.state == busGap )
+        {
+            tcflush(broker.fd,TCIFLUSH);
+            broker.repLen = 0;
+            if( write(broker.fd,broker.cur.frame,broker.cur.len) != (ssize_t)broker.cur.len )
+            {
+                busDone(LOVEBROKER_ERROR,now);
+                continue;
+            }
+
+            now = timeNow();
+            broker.due = now + broker.cur.timeout;
+            broker.state = busRecv;
+            continue;
+        }
+
+        /* No complete reply in time */
+        busDone(LOVEBROKER_TIMEOUT,now);
+    }
+}
+
+
+static void busRead(double now)
+{
+    ssize_t n;
+    size_t len;
+
+    n = read(broker.fd,broker.reply + broker.repLen,sizeof(broker.reply) - broker.repLen);
+    if( n <= 0 )
+    {
+        if( (n < 0) && ((errno == EINTR) || (errno == EAGAIN)) )
+            return;
+        busDone(LOVEBROKER_ERROR,now);
+        return;
+    }
+    broker.repLen += (size_t)n;
+
+    /* An ASCII reply ends with ACK; RTU address, function and byte count tell the length */
+    len = loveFrameLength(broker.isRtu,broker.reply,broker.repLen);
+    if( len && (len <= broker.repLen) )
+    {
+        broker.repLen = len;
+        busDone(LOVEBROKER_OK,now);
+    }
+    else if( (len > sizeof(broker.reply)) || (broker.repLen == sizeof(broker.reply)) )
+        busDone(LOVEBROKER_ERROR,now);
+}
+
+
+static void busDone(int sts,double now)
+{
+    int i;
+    size_t repLen;
+    Pend pend;
+    Entry* pent;
+    Entry* pold;
+    unsigned char reply[LOVEBROKER_FRAMEMAX];
+
+    /* The bus is free before replies can drop clients */
+    pend = broker.cur;
+    repLen = (sts == LOVEBROKER_OK)?broker.repLen:0;
+    memcpy(reply,broker.reply,repLen);
+    broker.state = busIdle;
+    broker.lastBus = now;
+
+    ++broker.nTransactions;
+    if( sts == LOVEBROKER_TIMEOUT )
+        ++broker.nTimeouts;
+    else if( sts != LOVEBROKER_OK )
+        ++broker.nErrors;
+
+    if( pend.isRead == 0 )
+        invalidate(pend.frame,pend.len);
+    else if( (sts == LOVEBROKER_OK) && (broker.age > 0.0) )
+    {
+        for( pold = pent = &broker.cache[0], i = 0; i < K_CACHEMAX; ++i )
+        {
+            pent = &broker.cache[i];
+            if( (pent->inUse == 0) || ((pent->len == pend.len) && (memcmp(pent->frame,pend.frame,pend.len) == 0)) )
+                break;
+            if( pent->when < pold->when )
+                pold = pent;
+        }
+        if( i == K_CACHEMAX )
+            pent = pold;
+
+        pent->inUse = 1;
+        pent->when = now;
+        pent->len = pend.len;
+        memcpy(pent->frame,pend.frame,pend.len);
+        pent->repLen = repLen;
+        memcpy(pent->reply,reply,repLen);
+    }
+
+    if( broker.isVerbose )
+        printf("loveBroker::%s %d bytes, %d waiters, status %d, %d bytes\n",(pend.isRead)?"read":"write",(int)pend.len,pend.nWaiters,sts,(int)repLen);
+
+    for( i = 0; i < pend.nWaiters; ++i )
+        if( broker.clients[pend.waiters[i].client].fd >= 0 )
+            sendReply(pend.waiters[i].client,pend.waiters[i].seq,sts,reply,repLen);
+}
+
+
+static void invalidate(const unsigned char* frame,size_t len)
+{
+    int i,addr;
+
+    addr = loveFrameAddr(broker.isRtu,frame,len);
+    for( i = 0; i < K_CACHEMAX; ++i )
+        if( broker.cache[i].inUse && (loveFrameAddr(broker.isRtu,broker.cache[i].frame,broker.cache[i].len) == addr) )
+            broker.cache[i].inUse = 0;
+}
+
+
+static void report(void)
+{
+    int i;
+
+    printf("loveBroker::%lu requests, %lu transactions, %lu shared, %lu cached, %lu timeouts, %lu errors\n",
+           broker.nRequests,broker.nTransactions,broker.nShared,broker.nCached,broker.nTimeouts,broker.nErrors);
+    for( i = 0; i < K_CLIENTMAX; ++i )
+        if( broker.clients[i].fd >= 0 )
+            printf("loveBroker::client %d, %lu requests\n",i,broker.clients[i].nRequests);
+}
+
+
+static void onReport(int sig)
+{
+    reportFlag = 1;
+}
@@ -0,0 +1,41 @@
+/*
+
+                          Love Controller Bus Broker
+
+ -----------------------------------------------------------------------------
+ Description
+    Wire format shared by loveBroker and the drvLove broker transport.
+    Every message on the Unix-domain socket is a LoveBrokerHdr followed by
+    'length' bytes of frame, exactly as written to or read from the tty.
+
+    Request: value is the reply timeout in milliseconds (0 = broker default).
+    Reply:   seq echoes the request, value is one of the LOVEBROKER_ codes
+             and the frame is the controller reply (empty unless OK).
+
+ History:
+ -----------------------------------------------------------------------------
+ 2026-Oct-18       Initial version.
+ -----------------------------------------------------------------------------
+
+*/
+
+#ifndef LOVEBROKER_H
+#define LOVEBROKER_H
+
+#define LOVEBROKER_MAGIC    ( 0x4C42 )
+#define LOVEBROKER_FRAMEMAX ( 256 )
+
+#define LOVEBROKER_OK       ( 0 )
+#define LOVEBROKER_TIMEOUT  ( 1 )
+#define LOVEBROKER_ERROR    ( 2 )
+
+/* Host byte order, both ends run on the same machine */
+typedef struct LoveBrokerHdr
+{
+    unsigned short magic;
+    unsigned short length;
+    unsigned int   seq;
+    unsigned int   value;
+} LoveBrokerHdr;
+
+#endif /* LOVEBROKER_H */
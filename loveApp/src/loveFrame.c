@@ -0,0 +1,192 @@
+/*
+
+                          Love Controller Frame Codec
+
+ -----------------------------------------------------------------------------
+ Description
+    Builds, checks and delimits the frames of the Love ASCII protocol and
+    of Modbus RTU, and holds the model and register tables expanded from
+    loveModels.def. See loveFrame.h.
+
+ History:
+ -----------------------------------------------------------------------------
+ 2026-Oct-18       Moved out of drvLove.c and loveBroker.c.
+ -----------------------------------------------------------------------------
+
+*/
+
+
+/* System related include files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Local related include files */
+#include "loveFrame.h"
+
+
+/* Define symbolic constants */
+#define K_CMDMAX   ( 32 )
+#define K_RTUMIN   ( 3 )
+
+
+/* Define global variables */
+const LoveModel loveModelTable[modelCount] =
+{
+#define LOVE_MODEL(id,name,signFmt,signMask,negSign,rtu) {name,signFmt,signMask,negSign,rtu},
+#include "loveModels.def"
+};
+
+const LoveCodes loveRegTable[modelCount][cmdTotal] =
+{
+#define LOVE_REG(id,name,read,write) [model##id][cmd##name] = {read,write},
+#include "loveModels.def"
+};
+
+
+/****************************************************************************
+ * Define public ASCII methods
+ ****************************************************************************/
+unsigned char loveFrameChecksum(const char* pdata,size_t count)
+{
+    size_t i;
+    unsigned long cs;
+
+    for( cs = 0, i = 0; i < count; ++i )
+        cs += pdata[i];
+
+    return( (unsigned char)(cs & 0xFF) );
+}
+
+
+int loveFrameBuild(char* pout,size_t size,int addr,const char* pcmd)
+{
+    char tmp[K_CMDMAX + 3];
+
+    /* The command may be read from the output buffer, it is copied first */
+    if( strlen(pcmd) > K_CMDMAX )
+        return( -1 );
+    sprintf(tmp,"%02X%s",addr,pcmd);
+    if( (strlen(tmp) + 5) > size )
+        return( -1 );
+
+    return( sprintf(pout,"\002L%s%2X",tmp,loveFrameChecksum(tmp,strlen(tmp))) );
+}
+
+
+int loveFrameCheck(const char* pinp,size_t count,int* perr)
+{
+    unsigned int cs;
+
+    *perr = 0;
+    if( (count == 0) || (pinp[0] != LOVEFRAME_STX) )
+        return( LOVEFRAME_NOSTX );
+    if( count < 7 )
+        return( LOVEFRAME_SHORT );
+
+    /* STX 'L' AA 'N' EE is the controller's error reply */
+    if( count == 7 )
+    {
+        *perr = atoi(pinp + 5);
+        return( LOVEFRAME_NAK );
+    }
+
+    /* The checksum covers everything between STX and itself */
+    if( (sscanf(&pinp[count - 2],"%2x",&cs) != 1) || (cs != loveFrameChecksum(&pinp[1],count - 3)) )
+        return( LOVEFRAME_CHECKSUM );
+
+    return( LOVEFRAME_OK );
+}
+
+
+/****************************************************************************
+ * Define public Modbus RTU methods
+ ****************************************************************************/
+unsigned short loveFrameCrc(const unsigned char* pdata,size_t count)
+{
+    int i;
+    unsigned short crc = 0xFFFF;
+
+    while( count-- )
+    {
+        crc ^= *pdata++;
+        for( i = 0; i < 8; ++i )
+            crc = (crc & 0x0001)?((crc >> 1) ^ 0xA001):(crc >> 1);
+    }
+
+    return( crc );
+}
+
+
+/****************************************************************************
+ * Define public methods for both protocols
+ ****************************************************************************/
+size_t loveFrameLength(int isRtu,const unsigned char* pdata,size_t count)
+{
+    size_t i;
+
+    /* An ASCII reply ends with ACK */
+    if( isRtu == 0 )
+    {
+        for( i = 0; i < count; ++i )
+            if( pdata[i] == LOVEFRAME_ACK )
+                return( i + 1 );
+        return( 0 );
+    }
+
+    /* Address, function and the first data byte tell the RTU reply length */
+    if( count < K_RTUMIN )
+        return( 0 );
+    if( pdata[1] & 0x80 )
+        return( 5 );
+    if( pdata[1] == 0x03 )
+        return( 5 + (size_t)pdata[2] );
+
+    return( 8 );
+}
+
+
+int loveFrameIsRead(int isRtu,const unsigned char* pdata,size_t count)
+{
+    int i,j;
+    size_t len;
+    const char* pread;
+
+    if( isRtu )
+        return( (count > 2) && (pdata[1] == 0x03) );
+
+    /* An ASCII request is a read when its command is a read code of a model */
+    if( count && (pdata[count - 1] == LOVEFRAME_ETX) )
+        --count;
+    if( count < 7 )
+        return( 0 );
+    len = count - 6;
+
+    for( i = 0; i < modelCount; ++i )
+        for( j = 0; j < cmdTotal; ++j )
+        {
+            pread = loveRegTable[i][j].read;
+            if( pread && (strlen(pread) == len) && (memcmp(pread,pdata + 4,len) == 0) )
+                return( 1 );
+        }
+
+    return( 0 );
+}
+
+
+int loveFrameAddr(int isRtu,const unsigned char* pdata,size_t count)
+{
+    char hex[3];
+
+    if( isRtu )
+        return( (count > 0)?pdata[0]:-1 );
+
+    if( count < 4 )
+        return( -1 );
+    hex[0] = (char)pdata[2];
+    hex[1] = (char)pdata[3];
+    hex[2] = '\0';
+
+    return( (int)strtol(hex,NULL,16) );
+}
@@ -0,0 +1,84 @@
+/*
+
+                          Love Controller Frame Codec
+
+ -----------------------------------------------------------------------------
+ Description
+    Frames of the Love ASCII protocol and of Modbus RTU, and the command,
+    model and register tables of loveModels.def. Compiled into drvLove
+    and loveBroker, so that both build, check and delimit frames and tell
+    reads from writes the same way. Plain C without EPICS.
+
+    ASCII request: STX 'L' AA command checksum, the ETX is the output EOS.
+    ASCII reply:   STX 'L' AA data checksum ACK, or STX 'L' AA 'N' EE ACK
+                   with error code EE.
+    RTU:           address function data CRC, CRC low byte first.
+
+ History:
+ -----------------------------------------------------------------------------
+ 2026-Oct-18       Moved out of drvLove.c and loveBroker.c.
+ -----------------------------------------------------------------------------
+
+*/
+
+#ifndef LOVEFRAME_H
+#define LOVEFRAME_H
+
+#include <stddef.h>
+
+/* Frame delimiters */
+#define LOVEFRAME_STX      ( 0x02 )
+#define LOVEFRAME_ETX      ( 0x03 )
+#define LOVEFRAME_ACK      ( 0x06 )
+
+/* loveFrameCheck() results */
+#define LOVEFRAME_OK       ( 0 )
+#define LOVEFRAME_NOSTX    ( 1 )
+#define LOVEFRAME_SHORT    ( 2 )
+#define LOVEFRAME_CHECKSUM ( 3 )
+#define LOVEFRAME_NAK      ( 4 )
+
+/* Controller models and commands, in loveModels.def order */
+typedef enum
+{
+#define LOVE_MODEL(id,name,signFmt,signMask,negSign,rtu) model##id,
+#include "loveModels.def"
+    modelCount
+} Model;
+
+typedef enum
+{
+#define LOVE_CMD(name,read,write,warm,rtuRd,rtuWr) cmd##name,
+#include "loveModels.def"
+    cmdTotal
+} Cmd;
+
+/* Declare model structure */
+typedef struct LoveModel
+{
+    const char* pname;
+    const char* signFmt;
+    int signMask;
+    int negSign;
+    int isRtu;
+} LoveModel;
+
+/* Declare command codes structure, NULL when the model has no such access */
+typedef struct LoveCodes
+{
+    const char* read;
+    const char* write;
+} LoveCodes;
+
+extern const LoveModel loveModelTable[modelCount];
+extern const LoveCodes loveRegTable[modelCount][cmdTotal];
+
+unsigned char loveFrameChecksum(const char* pdata,size_t count);
+int loveFrameBuild(char* pout,size_t size,int addr,const char* pcmd);
+int loveFrameCheck(const char* pinp,size_t count,int* perr);
+unsigned short loveFrameCrc(const unsigned char* pdata,size_t count);
+size_t loveFrameLength(int isRtu,const unsigned char* pdata,size_t count);
+int loveFrameIsRead(int isRtu,const unsigned char* pdata,size_t count);
+int loveFrameAddr(int isRtu,const unsigned char* pdata,size_t count);
+
+#endif
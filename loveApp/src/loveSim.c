@@ -0,0 +1,843 @@
+/*
+
+                        Love Controller Bus Simulator
+
+ -----------------------------------------------------------------------------
+ Description
+    This program simulates an RS-485 bus of Love controllers on a pty, so
+    drvLove, its tests and benchmarks run without hardware. The slave end
+    of the pty is published under a fixed path that drvLoveInit() or
+    drvAsynSerialPortConfigure() opens like a tty.
+
+        loveSim [-r] [-m model] [-a addr] [-n count] [-b baud] [-f framing]
+                [-d delay] [-x faults] [-s file] [-v] link
+
+        Where:
+            -r       - Modbus RTU framing (default Love ASCII)
+            -m       - Controller model of loveModels.def (default 1600,
+                       16A with -r)
+            -a       - Address of the first controller (default 1)
+            -n       - Number of controllers (default 1)
+            -b       - Simulated baud rate (default 19200)
+            -f       - Simulated framing (default 8N1)
+            -d       - Controller turnaround in seconds (default 0.002)
+            -x       - Fraction of the addressed frames that are faulted
+                       (default 0)
+            -s       - Statistics file, written on SIGUSR1 and at exit
+            -v       - Print every frame
+            link     - Path of the pty slave (i.e. "/tmp/love0" )
+
+    Each controller keeps the registers of its model, as listed by the
+    LOVE_REG rows of loveModels.def, and answers reads and writes with
+    the codes of that file. A pty moves bytes at memory speed, so every
+    reply is held back by the wire time of the request and reply at the
+    simulated baud rate plus the turnaround. Frames to other addresses
+    are ignored, as on a real bus.
+
+    ASCII requests are checked for their checksum and answered with an
+    N02 error when it is wrong, unknown commands with N01. RTU requests
+    with a bad CRC are ignored, function 03 and 06 are served and other
+    functions, or registers the model does not have, get a Modbus
+    exception.
+
+    With -x, that fraction of the addressed frames is faulted, in turn
+    by silence, a corrupted checksum or CRC, an error reply (N03, RTU
+    exception 04) and a reply cut off halfway. SIGUSR1 prints the frame,
+    reply and fault counters; SIGINT and SIGTERM write them and exit.
+
+ History:
+ -----------------------------------------------------------------------------
+ 2026-Oct-18       Initial version.
+ -----------------------------------------------------------------------------
+
+*/
+
+
+/* posix_openpt() and friends */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+
+/* System related include files */
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/* Define symbolic constants */
+#define K_INSTRMAX  ( 256 )
+#define K_FRAMEMAX  ( 300 )
+#define K_BAUD      ( 19200 )
+#define K_DELAY     ( 0.002 )
+#define K_STX       ( 0x02 )
+#define K_ETX       ( 0x03 )
+#define K_ACK       ( 0x06 )
+#define K_RTUREQ    ( 8 )
+#define K_RTUREGMAX ( 125 )
+
+
+/* Define fault kind enum */
+typedef enum {faultSilence,faultCorrupt,faultError,faultPartial,faultCount} FaultKind;
+
+
+/* Declare command, model and register tables expanded from the register map */
+typedef struct SimCmd
+{
+    const char* name;
+    const char* kind;
+    int         rtuRd;
+    int         rtuWr;
+} SimCmd;
+
+typedef struct SimModel
+{
+    const char* id;
+    const char* name;
+    int         rtu;
+} SimModel;
+
+typedef struct SimReg
+{
+    const char* model;
+    const char* cmd;
+    const char* read;
+    const char* write;
+} SimReg;
+
+static const SimCmd CmdTable[] =
+{
+#define LOVE_CMD(name,read,write,warm,rtuRd,rtuWr) {#name,#read,rtuRd,rtuWr},
+#include "loveModels.def"
+};
+
+static const SimModel ModelTable[] =
+{
+#define LOVE_MODEL(id,name,signFmt,signMask,negSign,rtu) {#id,name,rtu},
+#include "loveModels.def"
+};
+
+static const SimReg RegTable[] =
+{
+#define LOVE_REG(id,name,read,write) {#id,#name,read,write},
+#include "loveModels.def"
+};
+
+#define K_CMDCOUNT   ( (int)(sizeof(CmdTable) / sizeof(CmdTable[0])) )
+#define K_MODELCOUNT ( (int)(sizeof(ModelTable) / sizeof(ModelTable[0])) )
+#define K_REGCOUNT   ( (int)(sizeof(RegTable) / sizeof(RegTable[0])) )
+
+
+/* Declare simulated controller structure */
+typedef struct Instr
+{
+    int           isUsed;
+    int           values[K_CMDCOUNT];
+    unsigned long nFrames;
+} Instr;
+
+
+/* Declare simulator structure */
+typedef struct Sim
+{
+    int           isRtu;
+    int           isVerbose;
+    int           fd;
+    int           sfd;
+    const char*   link;
+    const char*   stats;
+    const SimModel* pmodel;
+    const SimReg* regs[K_CMDCOUNT];
+    double        charTime;
+    double        delay;
+    double        faults;
+    double        faultAcc;
+    size_t        inLen;
+    unsigned char inBuf[K_FRAMEMAX];
+    unsigned long nFrames;
+    unsigned long nReplies;
+    unsigned long nIgnored;
+    unsigned long nBadFrames;
+    unsigned long nErrors;
+    unsigned long nFaults[faultCount];
+    Instr         instr[K_INSTRMAX];
+} Sim;
+
+
+/* Forward references */
+static double timeNow(void);
+static void sleepFor(double seconds);
+static void usage(const char* name);
+static int openPty(const char* link);
+static int findCmd(const char* name);
+static void initInstr(int addr);
+static int takeFault(void);
+static void sendFrame(int addr,const unsigned char* frame,size_t len,size_t reqLen,int isError);
+static void asciiFrame(const unsigned char* frame,size_t len);
+static void asciiReply(int addr,const char* payload,size_t reqLen,int isError);
+static void asciiError(int addr,int code,size_t reqLen);
+static void rtuFrame(const unsigned char* frame,size_t len);
+static void rtuReply(int addr,unsigned char* frame,size_t len,size_t reqLen,int isError);
+static void rtuException(int addr,int fn,int code,size_t reqLen);
+static int rtuRegister(Instr* pinstr,int reg,int* pvalue);
+static unsigned short rtuCrc(const unsigned char* pdata,size_t count);
+static void report(FILE* fp);
+static void writeStats(void);
+static void onReport(int sig);
+static void onExit(int sig);
+
+
+/* Define global variables */
+static Sim sim;
+static volatile sig_atomic_t reportFlag = 0;
+static volatile sig_atomic_t exitFlag = 0;
+
+
+/****************************************************************************
+ * Define main program
+ ****************************************************************************/
+int main(int argc,char* argv[])
+{
+    int i,n,opt,baud,first,count,wait;
+    const char* model;
+    const char* framing;
+    ssize_t len;
+    unsigned char* pstx;
+    unsigned char* petx;
+    struct pollfd pfd;
+
+    baud = K_BAUD;
+    framing = "8N1";
+    model = NULL;
+    first = 1;
+    count = 1;
+    sim.delay = K_DELAY;
+    while( (opt = getopt(argc,argv,"rm:a:n:b:f:d:x:s:v")) != -1 )
+        switch( opt )
+        {
+        case 'r': sim.isRtu = 1; break;
+        case 'm': model = optarg; break;
+        case 'a': first = (int)strtol(optarg,NULL,0); break;
+        case 'n': count = atoi(optarg); break;
+        case 'b': baud = atoi(optarg); break;
+        case 'f': framing = optarg; break;
+        case 'd': sim.delay = atof(optarg); break;
+        case 'x': sim.faults = atof(optarg); break;
+        case 's': sim.stats = optarg; break;
+        case 'v': sim.isVerbose = 1; break;
+        default:  usage(argv[0]); return( 1 );
+        }
+    if( (argc - optind) != 1 )
+    {
+        usage(argv[0]);
+        return( 1 );
+    }
+
+    if( model == NULL )
+        model = (sim.isRtu)?"16A":"1600";
+    for( i = 0; i < K_MODELCOUNT; ++i )
+        if( strcmp(ModelTable[i].name,model) == 0 )
+            sim.pmodel = &ModelTable[i];
+    if( sim.pmodel == NULL )
+    {
+        printf("loveSim::unknown model %s\n",model);
+        return( 1 );
+    }
+    if( sim.isRtu && (sim.pmodel->rtu == 0) )
+    {
+        printf("loveSim::model %s does not speak Modbus RTU\n",model);
+        return( 1 );
+    }
+
+    if( (first < 1) || (count < 1) || ((first + count - 1) > K_INSTRMAX) )
+    {
+        printf("loveSim::illegal address range %d+%d\n",first,count);
+        return( 1 );
+    }
+
+    if( (baud <= 0) || (strlen(framing) != 3) || (strchr("78",framing[0]) == NULL) || (strchr("NEO",toupper((int)framing[1])) == NULL) || (strchr("12",framing[2]) == NULL) )
+    {
+        printf("loveSim::illegal baud rate %d or framing \"%s\"\n",baud,framing);
+        return( 1 );
+    }
+    sim.charTime = (1.0 + (framing[0] - '0') + (toupper((int)framing[1]) != 'N') + (framing[2] - '0')) / baud;
+
+    if( (sim.faults < 0.0) || (sim.faults > 1.0) )
+    {
+        printf("loveSim::illegal fault fraction %g\n",sim.faults);
+        return( 1 );
+    }
+
+    /* The model rows of loveModels.def give the registers of every controller */
+    for( i = 0; i < K_REGCOUNT; ++i )
+        if( strcmp(RegTable[i].model,sim.pmodel->id) == 0 )
+            sim.regs[findCmd(RegTable[i].cmd)] = &RegTable[i];
+    for( i = first; i < (first + count); ++i )
+        initInstr(i);
+
+    sim.link = argv[optind];
+    sim.fd = openPty(sim.link);
+    if( sim.fd < 0 )
+        return( 1 );
+
+    setvbuf(stdout,NULL,_IOLBF,0);
+    signal(SIGUSR1,onReport);
+    signal(SIGINT,onExit);
+    signal(SIGTERM,onExit);
+    printf("loveSim::%d %s controllers at 0x%02X-0x%02X (%s, %d %s, turnaround %.3f sec, %.1f%% faults) on %s\n",count,sim.pmodel->name,
+           first,first + count - 1,(sim.isRtu)?"RTU":"ASCII",baud,framing,sim.delay,sim.faults * 100.0,sim.link);
+
+    while( exitFlag == 0 )
+    {
+        /* An RTU frame ends with 3.5 character times of silence */
+        wait = (sim.isRtu && sim.inLen)?(int)(3500.0 * sim.charTime) + 1:1000;
+
+        pfd.fd = sim.fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        n = poll(&pfd,1,wait);
+        if( (n < 0) && (errno != EINTR) )
+        {
+            printf("loveSim::poll failed - %s\n",strerror(errno));
+            break;
+        }
+
+        if( reportFlag )
+        {
+            reportFlag = 0;
+            report(stdout);
+            writeStats();
+        }
+
+        if( n == 0 )
+        {
+            if( sim.isRtu && sim.inLen )
+            {
+                rtuFrame(sim.inBuf,sim.inLen);
+                sim.inLen = 0;
+            }
+            continue;
+        }
+        if( n < 0 )
+            continue;
+
+        len = read(sim.fd,sim.inBuf + sim.inLen,sizeof(sim.inBuf) - sim.inLen);
+        if( len <= 0 )
+        {
+            if( (len < 0) && (errno != EINTR) && (errno != EAGAIN) && (errno != EIO) )
+            {
+                printf("loveSim::read failed - %s\n",strerror(errno));
+                break;
+            }
+            continue;
+        }
+        sim.inLen += (size_t)len;
+
+        if( sim.isRtu )
+        {
+            /* Function 03 and 06 requests have a fixed length and are served without waiting for the silence */
+            if( (sim.inLen >= K_RTUREQ) && ((sim.inBuf[1] == 0x03) || (sim.inBuf[1] == 0x06)) )
+            {
+                rtuFrame(sim.inBuf,K_RTUREQ);
+                sim.inLen -= K_RTUREQ;
+                memmove(sim.inBuf,sim.inBuf + K_RTUREQ,sim.inLen);
+            }
+            else if( sim.inLen == sizeof(sim.inBuf) )
+                sim.inLen = 0;
+            continue;
+        }
+
+        /* ASCII frames run from STX to ETX, anything outside is line noise */
+        for( ;; )
+        {
+            pstx = memchr(sim.inBuf,K_STX,sim.inLen);
+            if( pstx == NULL )
+            {
+                sim.inLen = 0;
+                break;
+            }
+            sim.inLen -= (size_t)(pstx - sim.inBuf);
+            memmove(sim.inBuf,pstx,sim.inLen);
+
+            petx = memchr(sim.inBuf,K_ETX,sim.inLen);
+            if( petx == NULL )
+            {
+                if( sim.inLen == sizeof(sim.inBuf) )
+                    sim.inLen = 0;
+                break;
+            }
+
+            asciiFrame(sim.inBuf,(size_t)(petx - sim.inBuf));
+            sim.inLen -= (size_t)(petx - sim.inBuf) + 1;
+            memmove(sim.inBuf,petx + 1,sim.inLen);
+        }
+    }
+
+    report(stdout);
+    writeStats();
+    unlink(sim.link);
+
+    return( 0 );
+}
+
+
+/****************************************************************************
+ * Define private methods
+ ****************************************************************************/
+static double timeNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+
+    return( ts.tv_sec + (ts.tv_nsec * 1e-9) );
+}
+
+
+static void sleepFor(double seconds)
+{
+    double end;
+    struct timespec ts;
+
+    for( end = timeNow() + seconds; seconds > 0.0; seconds = end - timeNow() )
+    {
+        ts.tv_sec = (time_t)seconds;
+        ts.tv_nsec = (long)((seconds - ts.tv_sec) * 1e9);
+        nanosleep(&ts,NULL);
+    }
+}
+
+
+static void usage(const char* name)
+{
+    printf("Usage: %s [-r] [-m model] [-a addr] [-n count] [-b baud] [-f framing] [-d delay] [-x faults] [-s file] [-v] link\n",name);
+}
+
+
+static int openPty(const char* link)
+{
+    int fd;
+    char* pname;
+    struct termios tio;
+
+    fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if( (fd < 0) || (grantpt(fd) != 0) || (unlockpt(fd) != 0) || ((pname = ptsname(fd)) == NULL) )
+    {
+        printf("loveSim::failure to create a pty - %s\n",strerror(errno));
+        if( fd >= 0 )
+            close(fd);
+        return( -1 );
+    }
+
+    /* The slave stays open, so the master survives a client that closes and reopens */
+    sim.sfd = open(pname,O_RDWR | O_NOCTTY);
+    if( (sim.sfd < 0) || (tcgetattr(sim.sfd,&tio) != 0) )
+    {
+        printf("loveSim::failure to open %s - %s\n",pname,strerror(errno));
+        close(fd);
+        return( -1 );
+    }
+    cfmakeraw(&tio);
+    tcsetattr(sim.sfd,TCSANOW,&tio);
+
+    unlink(link);
+    if( symlink(pname,link) != 0 )
+    {
+        printf("loveSim::failure to link %s to %s - %s\n",link,pname,strerror(errno));
+        close(sim.sfd);
+        close(fd);
+        return( -1 );
+    }
+
+    return( fd );
+}
+
+
+static int findCmd(const char* name)
+{
+    int i;
+
+    for( i = 0; i < K_CMDCOUNT; ++i )
+        if( strcmp(CmdTable[i].name,name) == 0 )
+            return( i );
+
+    return( 0 );
+}
+
+
+static void initInstr(int addr)
+{
+    int i;
+    Instr* pinstr = &sim.instr[addr - 1];
+    static const struct {const char* name; int value;} inits[] =
+    {
+        {"SP1",250},{"SP2",300},{"AlLo",100},{"AlHi",400},{"Peak",450},{"Valley",50},
+        {"AlSts",0x0000},{"AlMode",1},{"InpTyp",2},{"ComSts",0},{"Decpts",1}
+    };
+
+    /* Each controller reads a different process value, so replies can be told apart */
+    pinstr->isUsed = 1;
+    pinstr->values[findCmd("Value")] = 200 + addr;
+    for( i = 0; i < (int)(sizeof(inits) / sizeof(inits[0])); ++i )
+        pinstr->values[findCmd(inits[i].name)] = inits[i].value;
+}
+
+
+static int takeFault(void)
+{
+    /* Every 1/faults-th addressed frame is faulted, the kinds in turn */
+    if( sim.faults <= 0.0 )
+        return( -1 );
+
+    sim.faultAcc += sim.faults;
+    if( sim.faultAcc < 1.0 )
+        return( -1 );
+    sim.faultAcc -= 1.0;
+
+    return( (int)((sim.nFaults[faultSilence] + sim.nFaults[faultCorrupt] + sim.nFaults[faultError] + sim.nFaults[faultPartial]) % faultCount) );
+}
+
+
+static void sendFrame(int addr,const unsigned char* frame,size_t len,size_t reqLen,int isError)
+{
+    int fault;
+    unsigned char buf[K_FRAMEMAX];
+
+    /* Error replies, including the injected ones, are sent as they are */
+    memcpy(buf,frame,len);
+    fault = (isError)?-1:takeFault();
+    if( fault >= 0 )
+    {
+        ++sim.nFaults[fault];
+        if( sim.isVerbose )
+            printf("loveSim::0x%02X fault %d\n",addr,fault);
+    }
+
+    if( fault == faultSilence )
+        return;
+
+    /* The checksum or CRC is the last byte before the ASCII ACK */
+    if( fault == faultCorrupt )
+        buf[(sim.isRtu)?(len - 1):(len - 2)] ^= 0x01;
+    else if( fault == faultError )
+    {
+        if( sim.isRtu )
+            rtuException(addr,buf[1] & 0x7F,0x04,reqLen);
+        else
+            asciiError(addr,3,reqLen);
+        return;
+    }
+    else if( fault == faultPartial )
+        len /= 2;
+
+    /* Request and reply both cross the wire at the simulated baud rate */
+    sleepFor(((reqLen + len) * sim.charTime) + sim.delay);
+    if( write(sim.fd,buf,len) != (ssize_t)len )
+        printf("loveSim::write failed - %s\n",strerror(errno));
+
+    ++sim.nReplies;
+    if( isError )
+        ++sim.nErrors;
+}
+
+
+static void asciiFrame(const unsigned char* frame,size_t len)
+{
+    int i,addr,cs,csMsg,data,sign;
+    size_t cmdLen;
+    char payload[32];
+    const char* pcmd;
+    const SimReg* preg;
+    Instr* pinstr;
+
+    /* STX, 'L', two address digits, a command and two checksum digits */
+    ++sim.nFrames;
+    if( (len < 7) || (frame[1] != 'L') || !isxdigit(frame[2]) || !isxdigit(frame[3]) )
+    {
+        ++sim.nBadFrames;
+        return;
+    }
+
+    sscanf((const char*)frame + 2,"%2x",&addr);
+    if( (addr < 1) || (addr > K_INSTRMAX) || (sim.instr[addr - 1].isUsed == 0) )
+    {
+        ++sim.nIgnored;
+        return;
+    }
+    pinstr = &sim.instr[addr - 1];
+    ++pinstr->nFrames;
+
+    if( sim.isVerbose )
+        printf("loveSim::0x%02X request \"%.*s\"\n",addr,(int)(len - 1),frame + 1);
+
+    /* The request checksum covers the address and the command, drvLove pads it with a blank */
+    for( cs = 0, i = 2; i < (int)(len - 2); ++i )
+        cs += frame[i];
+    csMsg = -1;
+    sscanf((const char*)frame + len - 2,"%2x",&csMsg);
+    if( (cs & 0xFF) != csMsg )
+    {
+        ++sim.nBadFrames;
+        asciiError(addr,2,len + 1);
+        return;
+    }
+
+    pcmd = (const char*)frame + 4;
+    cmdLen = len - 6;
+    for( i = 0; i < K_CMDCOUNT; ++i )
+    {
+        preg = sim.regs[i];
+        if( preg == NULL )
+            continue;
+
+        if( preg->read && (strlen(preg->read) == cmdLen) && (strncmp(pcmd,preg->read,cmdLen) == 0) )
+        {
+            /* Command 00 returns the status word, with the sign of the value in bit 0, and the value */
+            if( (strcmp(CmdTable[i].kind,"getValue") == 0) || (strcmp(CmdTable[i].kind,"getStatus") == 0) )
+                sprintf(payload,"%4.4X%4.4d",(pinstr->values[findCmd("AlSts")] & ~0x0001) | (pinstr->values[findCmd("Value")] < 0),
+                        abs(pinstr->values[findCmd("Value")]) % 10000);
+            else if( strcmp(CmdTable[i].kind,"getSignedValue") == 0 )
+                sprintf(payload,"%2.2X%4.4d",(pinstr->values[i] < 0),abs(pinstr->values[i]) % 10000);
+            else
+                sprintf(payload,"%2.2X",pinstr->values[i] & 0xFF);
+
+            asciiReply(addr,payload,len + 1,0);
+            return;
+        }
+
+        /* Writes are the code, four decimal digits and a two digit sign byte */
+        if( preg->write && (cmdLen == (strlen(preg->write) + 6)) && (strncmp(pcmd,preg->write,strlen(preg->write)) == 0) )
+        {
+            pcmd += strlen(preg->write);
+            for( data = 0; data < 4; ++data )
+                if( !isdigit((int)pcmd[data]) )
+                    break;
+            if( (data < 4) || !isxdigit((int)pcmd[4]) || !isxdigit((int)pcmd[5]) )
+            {
+                asciiError(addr,5,len + 1);
+                return;
+            }
+
+            sscanf(pcmd,"%4d%2x",&data,&sign);
+            pinstr->values[i] = (sign)?-data:data;
+            asciiReply(addr,"00",len + 1,0);
+            return;
+        }
+    }
+
+    asciiError(addr,1,len + 1);
+}
+
+
+static void asciiReply(int addr,const char* payload,size_t reqLen,int isError)
+{
+    int i,cs;
+    size_t len;
+    char frame[K_FRAMEMAX];
+
+    /* The reply checksum covers the 'L', the address and the payload */
+    len = (size_t)sprintf(frame,"\002L%2.2X%s",addr,payload);
+    for( cs = 0, i = 1; i < (int)len; ++i )
+        cs += (unsigned char)frame[i];
+    if( isError == 0 )
+        len += (size_t)sprintf(frame + len,"%2.2X",cs & 0xFF);
+    frame[len++] = K_ACK;
+
+    sendFrame(addr,(unsigned char*)frame,len,reqLen,isError);
+}
+
+
+static void asciiError(int addr,int code,size_t reqLen)
+{
+    char payload[8];
+
+    /* An error reply is 'N' and the error number, without a checksum */
+    sprintf(payload,"N%2.2d",code);
+    asciiReply(addr,payload,reqLen,1);
+}
+
+
+static void rtuFrame(const unsigned char* frame,size_t len)
+{
+    int i,addr,fn,reg,count,value,found;
+    unsigned char reply[K_FRAMEMAX];
+    Instr* pinstr;
+
+    /* A frame with a bad CRC is not answered, the master times out */
+    ++sim.nFrames;
+    if( (len < 4) || (rtuCrc(frame,len - 2) != (unsigned short)(frame[len - 2] | (frame[len - 1] << 8))) )
+    {
+        ++sim.nBadFrames;
+        return;
+    }
+
+    addr = frame[0];
+    fn = frame[1];
+    if( (addr < 1) || (sim.instr[addr - 1].isUsed == 0) )
+    {
+        ++sim.nIgnored;
+        return;
+    }
+    pinstr = &sim.instr[addr - 1];
+    ++pinstr->nFrames;
+
+    if( sim.isVerbose )
+        printf("loveSim::0x%02X function %d, %d bytes\n",addr,fn,(int)len);
+
+    if( ((fn != 0x03) && (fn != 0x06)) || (len != K_RTUREQ) )
+    {
+        rtuException(addr,fn,0x01,len);
+        return;
+    }
+
+    reg = (frame[2] << 8) | frame[3];
+    if( fn == 0x06 )
+    {
+        for( i = 0; i < K_CMDCOUNT; ++i )
+            if( (CmdTable[i].rtuWr == reg) && sim.regs[i] && sim.regs[i]->write )
+                break;
+        if( i == K_CMDCOUNT )
+        {
+            rtuException(addr,fn,0x02,len);
+            return;
+        }
+
+        /* Written values are signed 16-bit, a good write is echoed */
+        pinstr->values[i] = (short)((frame[4] << 8) | frame[5]);
+        memcpy(reply,frame,6);
+        rtuReply(addr,reply,6,len,0);
+        return;
+    }
+
+    count = (frame[4] << 8) | frame[5];
+    if( (count < 1) || (count > K_RTUREGMAX) )
+    {
+        rtuException(addr,fn,0x03,len);
+        return;
+    }
+
+    /* Gaps in a block read as 0, a block without any register of the model is refused */
+    reply[0] = (unsigned char)addr;
+    reply[1] = 0x03;
+    reply[2] = (unsigned char)(2 * count);
+    for( found = 0, i = 0; i < count; ++i )
+    {
+        value = 0;
+        found |= rtuRegister(pinstr,reg + i,&value);
+        reply[3 + (2 * i)] = (unsigned char)((value >> 8) & 0xFF);
+        reply[4 + (2 * i)] = (unsigned char)(value & 0xFF);
+    }
+    if( found == 0 )
+    {
+        rtuException(addr,fn,0x02,len);
+        return;
+    }
+
+    rtuReply(addr,reply,3 + (2 * count),len,0);
+}
+
+
+static void rtuReply(int addr,unsigned char* frame,size_t len,size_t reqLen,int isError)
+{
+    unsigned short crc;
+
+    crc = rtuCrc(frame,len);
+    frame[len++] = (unsigned char)(crc & 0xFF);
+    frame[len++] = (unsigned char)(crc >> 8);
+
+    sendFrame(addr,frame,len,reqLen,isError);
+}
+
+
+static void rtuException(int addr,int fn,int code,size_t reqLen)
+{
+    unsigned char frame[5];
+
+    frame[0] = (unsigned char)addr;
+    frame[1] = (unsigned char)(fn | 0x80);
+    frame[2] = (unsigned char)code;
+    rtuReply(addr,frame,3,reqLen,1);
+}
+
+
+static int rtuRegister(Instr* pinstr,int reg,int* pvalue)
+{
+    int i;
+
+    for( i = 0; i < K_CMDCOUNT; ++i )
+        if( (CmdTable[i].rtuRd == reg) && sim.regs[i] && sim.regs[i]->read )
+        {
+            *pvalue = pinstr->values[i] & 0xFFFF;
+            return( 1 );
+        }
+
+    return( 0 );
+}
+
+
+static unsigned short rtuCrc(const unsigned char* pdata,size_t count)
+{
+    int i;
+    unsigned short crc = 0xFFFF;
+
+    while( count-- )
+    {
+        crc ^= *pdata++;
+        for( i = 0; i < 8; ++i )
+            crc = (crc & 0x0001)?((crc >> 1) ^ 0xA001):(crc >> 1);
+    }
+
+    return( crc );
+}
+
+
+static void report(FILE* fp)
+{
+    int i;
+
+    fprintf(fp,"loveSim::%lu frames, %lu replies, %lu ignored, %lu bad frames, %lu error replies\n",
+            sim.nFrames,sim.nReplies,sim.nIgnored,sim.nBadFrames,sim.nErrors);
+    fprintf(fp,"loveSim::faults %lu silence, %lu corrupt, %lu error, %lu partial\n",
+            sim.nFaults[faultSilence],sim.nFaults[faultCorrupt],sim.nFaults[faultError],sim.nFaults[faultPartial]);
+    for( i = 0; i < K_INSTRMAX; ++i )
+        if( sim.instr[i].isUsed )
+            fprintf(fp,"loveSim::0x%02X %lu frames\n",i + 1,sim.instr[i].nFrames);
+}
+
+
+static void writeStats(void)
+{
+    FILE* fp;
+
+    if( sim.stats == NULL )
+        return;
+
+    fp = fopen(sim.stats,"w");
+    if( fp == NULL )
+    {
+        printf("loveSim::failure to write %s - %s\n",sim.stats,strerror(errno));
+        return;
+    }
+    report(fp);
+    fclose(fp);
+}
+
+
+static void onReport(int sig)
+{
+    reportFlag = 1;
+}
+
+
+static void onExit(int sig)
+{
+    exitFlag = 1;
+}
@@ -0,0 +1,123 @@
+/*
+
+                          Love Controller Test Support
+
+ -----------------------------------------------------------------------------
+ Description
+    Runs loveSim as a child process on a pty under /tmp for the unit
+    tests. See loveTestSim.h.
+
+ History:
+ -----------------------------------------------------------------------------
+ 2026-Oct-18       Initial version.
+ -----------------------------------------------------------------------------
+
+*/
+
+
+/* System related include files */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+
+/* EPICS system related include files */
+#include <epicsThread.h>
+
+
+/* Local related include files */
+#include "loveTestSim.h"
+
+
+/* Define symbolic constants */
+#define K_STARTWAIT ( 50 )
+
+
+int loveSimStart(LoveSim* psim,const char* name,const char* args)
+{
+    int i;
+    const char* pexe;
+    char cmd[512];
+    struct stat st;
+
+    pexe = getenv("LOVESIM");
+    if( (pexe == NULL) || (strlen(pexe) == 0) )
+        pexe = LOVESIM;
+
+    sprintf(psim->link,"/tmp/%s.%d",name,(int)getpid());
+    sprintf(psim->stats,"/tmp/%s.%d.stats",name,(int)getpid());
+    sprintf(cmd,"exec %s %s -s %s %s >/dev/null",pexe,args,psim->stats,psim->link);
+
+    psim->pid = (int)fork();
+    if( psim->pid == 0 )
+    {
+        execl("/bin/sh","sh","-c",cmd,(char*)NULL);
+        _exit(127);
+    }
+    if( psim->pid < 0 )
+    {
+        printf("loveSimStart::failure to start %s\n",pexe);
+        return( -1 );
+    }
+
+    /* The link appears once the pty is ready */
+    for( i = 0; i < K_STARTWAIT; ++i )
+    {
+        if( lstat(psim->link,&st) == 0 )
+            return( 0 );
+        epicsThreadSleep(0.1);
+    }
+
+    printf("loveSimStart::%s did not come up on %s\n",pexe,psim->link);
+    loveSimStop(psim);
+    return( -1 );
+}
+
+
+int loveSimStats(LoveSim* psim,LoveSimStats* pstats)
+{
+    int i,n;
+    FILE* fp;
+    char line[256];
+
+    /* SIGUSR1 makes the simulator rewrite its statistics file, it is read once complete */
+    unlink(psim->stats);
+    kill((pid_t)psim->pid,SIGUSR1);
+    for( i = 0; i < K_STARTWAIT; ++i )
+    {
+        epicsThreadSleep(0.1);
+        fp = fopen(psim->stats,"r");
+        if( fp == NULL )
+            continue;
+
+        n = 0;
+        memset(pstats,0,sizeof(LoveSimStats));
+        if( fgets(line,sizeof(line),fp) )
+            n += sscanf(line,"loveSim::%lu frames, %lu replies, %lu ignored, %lu bad frames, %lu error replies",
+                        &pstats->frames,&pstats->replies,&pstats->ignored,&pstats->badFrames,&pstats->errors);
+        if( fgets(line,sizeof(line),fp) )
+            n += sscanf(line,"loveSim::faults %lu silence, %lu corrupt, %lu error, %lu partial",
+                        &pstats->silence,&pstats->corrupt,&pstats->error,&pstats->partial);
+        fclose(fp);
+        if( n == 9 )
+            return( 0 );
+    }
+
+    return( -1 );
+}
+
+
+void loveSimStop(LoveSim* psim)
+{
+    if( psim->pid <= 0 )
+        return;
+
+    kill((pid_t)psim->pid,SIGTERM);
+    waitpid((pid_t)psim->pid,NULL,0);
+    psim->pid = 0;
+    unlink(psim->stats);
+}
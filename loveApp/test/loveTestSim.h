@@ -0,0 +1,53 @@
+/*
+
+                          Love Controller Test Support
+
+ -----------------------------------------------------------------------------
+ Description
+    Starts and stops a loveSim bus simulator for the unit tests and reads
+    its counters. The simulator binary is taken from the LOVESIM
+    environment variable, or from the install location of this build.
+
+ History:
+ -----------------------------------------------------------------------------
+ 2026-Oct-18       Initial version.
+ -----------------------------------------------------------------------------
+
+*/
+
+#ifndef LOVETESTSIM_H
+#define LOVETESTSIM_H
+
+/* Declare running simulator structure */
+typedef struct LoveSim
+{
+    int  pid;
+    char link[64];
+    char stats[64];
+} LoveSim;
+
+/* Declare simulator counters, as written by its -s file */
+typedef struct LoveSimStats
+{
+    unsigned long frames;
+    unsigned long replies;
+    unsigned long ignored;
+    unsigned long badFrames;
+    unsigned long errors;
+    unsigned long silence;
+    unsigned long corrupt;
+    unsigned long error;
+    unsigned long partial;
+} LoveSimStats;
+
+int loveSimStart(LoveSim* psim,const char* name,const char* args);
+int loveSimStats(LoveSim* psim,LoveSimStats* pstats);
+void loveSimStop(LoveSim* psim);
+
+/* Driver configuration commands, normally called from iocsh */
+int drvLoveInit(const char* lovPort,const char* serPort,int serAddr,const char* protocol);
+int drvLoveConfig(const char* lovPort,int addr,const char *model);
+int drvLoveSoak(const char* lovPort,double period,double hours,double faults,int churn);
+int drvLoveGap(const char* lovPort,double seconds);
+
+#endif
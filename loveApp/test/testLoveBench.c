@@ -0,0 +1,467 @@
+/*
+
+                          Love Controller Transport Benchmark
+
+ -----------------------------------------------------------------------------
+ Description
+    Compares the transports of drvLove against loveSim on a pty: a
+    drvAsynSerialPort with asynInterposeEos, the direct tty transport
+    and the event-loop engine. Each port gets its own simulated bus with
+    one 1600, whose SP2 is read back to back.
+
+    The farm part then runs a number of simulated buses with four 1600
+    each, once as tty ports with a blocking port thread each and once
+    as event ports served by the one engine thread. A reader thread per
+    bus reads the set points back to back for a fixed time; the table
+    gives the transactions per second, the read time percentiles, the
+    CPU time per transaction and the number of threads of the process.
+
+        LOVE_BENCH_COUNT   - Reads per transport (default 200)
+        LOVE_BENCH_BUSES   - Simulated buses of the farm (default 8)
+        LOVE_BENCH_SECONDS - Duration of each farm run (default 30)
+        LOVE_BENCH_GAP     - ASCII gap of every port in sec (default 0)
+        LOVE_BENCH_OUT     - File the result tables are appended to
+
+    The simulator needs no gap, so by default the ports run without the
+    0.1 second gap a real bus is given and the read time is the wire
+    time at 19200 baud plus what the transport adds.
+
+    An event port does not block: its read returns the cache and queues
+    a refresh. There the read time runs from the read to the readback
+    callback of the reply, as a "I/O Intr" record would see it.
+
+    It is not part of runtests; "make bench" in this directory runs it.
+
+ History:
+ -----------------------------------------------------------------------------
+ 2026-Oct-18       Initial version.
+ 2026-Oct-18       Event port reads are timed to their readback callback.
+ 2026-Oct-18       Ports run with the gap of LOVE_BENCH_GAP, none by default.
+ -----------------------------------------------------------------------------
+
+*/
+
+
+/* System related include files */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+
+/* EPICS system related include files */
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+
+/* EPICS synApps/Asyn related include files */
+#include <asynDriver.h>
+#include <asynDrvUser.h>
+#include <asynInt32.h>
+#include <asynInt32SyncIO.h>
+#include <asynShellCommands.h>
+#include <drvAsynSerialPort.h>
+
+
+/* Local related include files */
+#include "loveTestSim.h"
+
+
+/* Define symbolic constants */
+#define K_TIMEOUT ( 10.0 )
+#define K_COUNT   ( 200 )
+#define K_BUSES   ( 8 )
+#define K_SECONDS ( 30.0 )
+#define K_FARMMAX ( 64 )
+#define K_INSTR   ( 4 )
+#define K_LATMAX  ( 100000 )
+
+
+/* Declare register handle, an event port answers through the readback callback */
+typedef struct Handle
+{
+    int          isEvent;
+    asynUser*    pread;
+    asynUser*    pintr;
+    asynDrvUser* pdrvUser;
+    void*        drvUserPvt;
+    asynInt32*   pasynInt32;
+    void*        asynInt32Pvt;
+    void*        registrarPvt;
+    epicsEventId reply;
+    epicsInt32   value;
+    int          sts;
+} Handle;
+
+
+/* Declare farm reader structure, one per simulated bus */
+typedef struct Reader
+{
+    char         port[16];
+    int          isEvent;
+    epicsEventId done;
+    int          n;
+    int          nErr;
+    double*      lats;
+} Reader;
+
+
+/* Define global variables */
+static FILE* pout = NULL;
+static double gap = 0.0;
+static volatile int isStopped = 0;
+
+
+static double cpuNow(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF,&ru);
+
+    return( ru.ru_utime.tv_sec + (ru.ru_utime.tv_usec * 1e-6) + ru.ru_stime.tv_sec + (ru.ru_stime.tv_usec * 1e-6) );
+}
+
+
+static int compareDouble(const void* pa,const void* pb)
+{
+    double a = *(const double*)pa;
+    double b = *(const double*)pb;
+
+    return( (a < b)?-1:(a > b) );
+}
+
+
+static void printRow(const char* fmt,const char* label,int n,int nErr,double* lats,double cpu)
+{
+    char line[256];
+
+    /* Latencies in msec, CPU time of the whole process per transaction */
+    qsort(lats,n,sizeof(double),compareDouble);
+    sprintf(line,fmt,label,n,nErr,lats[n / 2] * 1e3,lats[(n * 99) / 100] * 1e3,lats[n - 1] * 1e3,(cpu * 1e3) / n);
+    testDiag("%s",line);
+    if( pout )
+        fprintf(pout,"%s\n",line);
+}
+
+
+static void replyCallback(void* userPvt,asynUser* pasynUser,epicsInt32 value)
+{
+    Handle* phdl = (Handle*)userPvt;
+
+    phdl->value = value;
+    phdl->sts = pasynUser->auxStatus;
+    epicsEventSignal(phdl->reply);
+}
+
+
+static int openHandle(Handle* phdl,const char* port,int addr,int isEvent)
+{
+    asynInterface* pif;
+
+    memset(phdl,0,sizeof(Handle));
+    phdl->isEvent = isEvent;
+    if( pasynInt32SyncIO->connect(port,addr,&phdl->pread,"SP2") != asynSuccess )
+        return( -1 );
+    if( isEvent == 0 )
+        return( 0 );
+
+    /* A second user of the register hears the replies, which arrive on the engine thread */
+    phdl->reply = epicsEventMustCreate(epicsEventEmpty);
+    phdl->pintr = pasynManager->createAsynUser(NULL,NULL);
+    if( pasynManager->connectDevice(phdl->pintr,port,addr) != asynSuccess )
+        return( -1 );
+    pif = pasynManager->findInterface(phdl->pintr,asynDrvUserType,1);
+    if( pif == NULL )
+        return( -1 );
+    phdl->pdrvUser = (asynDrvUser*)pif->pinterface;
+    phdl->drvUserPvt = pif->drvPvt;
+    if( phdl->pdrvUser->create(phdl->drvUserPvt,phdl->pintr,"SP2",NULL,NULL) != asynSuccess )
+        return( -1 );
+    pif = pasynManager->findInterface(phdl->pintr,asynInt32Type,1);
+    if( pif == NULL )
+        return( -1 );
+    phdl->pasynInt32 = (asynInt32*)pif->pinterface;
+    phdl->asynInt32Pvt = pif->drvPvt;
+
+    return( (phdl->pasynInt32->registerInterruptUser(phdl->asynInt32Pvt,phdl->pintr,replyCallback,phdl,&phdl->registrarPvt) == asynSuccess)?0:-1 );
+}
+
+
+static asynStatus readHandle(Handle* phdl,epicsInt32* value)
+{
+    if( phdl->isEvent == 0 )
+        return( pasynInt32SyncIO->read(phdl->pread,value,K_TIMEOUT) );
+
+    /* The read queues the refresh and returns the cache, the reply is what is timed */
+    epicsEventTryWait(phdl->reply);
+    pasynInt32SyncIO->read(phdl->pread,value,K_TIMEOUT);
+    if( epicsEventWaitWithTimeout(phdl->reply,K_TIMEOUT) != epicsEventOK )
+        return( asynTimeout );
+    *value = phdl->value;
+
+    return( (asynStatus)phdl->sts );
+}
+
+
+static void closeHandle(Handle* phdl)
+{
+    if( phdl->pread )
+        pasynInt32SyncIO->disconnect(phdl->pread);
+    if( phdl->registrarPvt )
+        phdl->pasynInt32->cancelInterruptUser(phdl->asynInt32Pvt,phdl->pintr,phdl->registrarPvt);
+    if( phdl->pdrvUser && phdl->pintr->drvUser )
+        phdl->pdrvUser->destroy(phdl->drvUserPvt,phdl->pintr);
+    if( phdl->pintr )
+    {
+        pasynManager->disconnect(phdl->pintr);
+        pasynManager->freeAsynUser(phdl->pintr);
+    }
+    if( phdl->reply )
+        epicsEventDestroy(phdl->reply);
+    memset(phdl,0,sizeof(Handle));
+}
+
+
+static void benchPort(const char* label,const char* port,int isEvent,int count)
+{
+    int i,nErr;
+    double cpu;
+    double* lats;
+    Handle hdl;
+    epicsInt32 value;
+    epicsTimeStamp start,end;
+
+    if( openHandle(&hdl,port,1,isEvent) )
+    {
+        closeHandle(&hdl);
+        testFail("%s connect",label);
+        return;
+    }
+
+    /* The first read sets the EOS and opens the line */
+    lats = calloc(count,sizeof(double));
+    readHandle(&hdl,&value);
+
+    cpu = cpuNow();
+    for( nErr = 0, i = 0; i < count; ++i )
+    {
+        epicsTimeGetCurrent(&start);
+        if( (readHandle(&hdl,&value) != asynSuccess) || (value != 300) )
+            ++nErr;
+        epicsTimeGetCurrent(&end);
+        lats[i] = epicsTimeDiffInSeconds(&end,&start);
+    }
+    cpu = cpuNow() - cpu;
+    closeHandle(&hdl);
+
+    printRow("%-24s %6d %5d %8.2f %8.2f %8.2f %8.3f",label,count,nErr,lats,cpu);
+    testOk(nErr == 0,"%s %d reads, %d failed",label,count,nErr);
+    free(lats);
+}
+
+
+static long threadCount(void)
+{
+    long count;
+    FILE* fp;
+    char line[128];
+
+    fp = fopen("/proc/self/status","r");
+    if( fp == NULL )
+        return( -1 );
+    for( count = -1; fgets(line,sizeof(line),fp); )
+        if( sscanf(line,"Threads: %ld",&count) == 1 )
+            break;
+    fclose(fp);
+
+    return( count );
+}
+
+
+static void readerThread(void* parm)
+{
+    int i,addr;
+    int isOpen[K_INSTR];
+    Handle hdls[K_INSTR];
+    epicsInt32 value;
+    epicsTimeStamp start,end;
+    Reader* preader = (Reader*)parm;
+
+    for( addr = 0; addr < K_INSTR; ++addr )
+        isOpen[addr] = (openHandle(&hdls[addr],preader->port,addr + 1,preader->isEvent) == 0);
+
+    /* The controllers of the bus in turn, as a scan of their records would */
+    for( i = 0; isStopped == 0; ++i )
+    {
+        addr = i % K_INSTR;
+        epicsTimeGetCurrent(&start);
+        if( (isOpen[addr] == 0) || (readHandle(&hdls[addr],&value) != asynSuccess) || (value != 300) )
+            ++preader->nErr;
+        epicsTimeGetCurrent(&end);
+        if( preader->n < K_LATMAX )
+            preader->lats[preader->n] = epicsTimeDiffInSeconds(&end,&start);
+        ++preader->n;
+    }
+
+    for( addr = 0; addr < K_INSTR; ++addr )
+        closeHandle(&hdls[addr]);
+    epicsEventSignal(preader->done);
+}
+
+
+static void benchFarm(const char* mode,int buses,double seconds)
+{
+    int i,addr,count,n,nErr;
+    long threads,total;
+    double cpu,wall;
+    double* lats;
+    char name[32];
+    char spec[96];
+    Reader readers[K_FARMMAX];
+    LoveSim sims[K_FARMMAX];
+    epicsTimeStamp start,end;
+
+    /* One simulator, port and reader per bus */
+    memset(readers,0,sizeof(readers));
+    memset(sims,0,sizeof(sims));
+    for( count = 0, i = 0; i < buses; ++i )
+    {
+        sprintf(name,"loveFarm%c%d",mode[0],i);
+        if( loveSimStart(&sims[i],name,"-n 4") )
+            break;
+        sprintf(readers[i].port,"F%c%d",toupper((int)mode[0]),i);
+        readers[i].isEvent = (strcmp(mode,"event") == 0);
+        sprintf(spec,"%s%s,19200,8N1",(strcmp(mode,"event") == 0)?"event:":"",sims[i].link);
+        if( drvLoveInit(readers[i].port,spec,0,NULL) || drvLoveGap(readers[i].port,gap) )
+            break;
+        for( addr = 1; addr <= K_INSTR; ++addr )
+            count += (drvLoveConfig(readers[i].port,addr,"1600") == 0);
+    }
+    if( (i < buses) || (count != (buses * K_INSTR)) )
+    {
+        testFail("%s farm of %d buses not set up",mode,buses);
+        testSkip(1,"farm not set up");
+        for( i = 0; i < buses; ++i )
+            loveSimStop(&sims[i]);
+        return;
+    }
+    testPass("%s farm of %d buses, %d controllers",mode,buses,count);
+
+    isStopped = 0;
+    cpu = cpuNow();
+    epicsTimeGetCurrent(&start);
+    for( i = 0; i < buses; ++i )
+    {
+        readers[i].done = epicsEventMustCreate(epicsEventEmpty);
+        readers[i].lats = calloc(K_LATMAX,sizeof(double));
+        epicsThreadMustCreate("loveFarm",epicsThreadPriorityMedium,epicsThreadGetStackSize(epicsThreadStackSmall),readerThread,&readers[i]);
+    }
+
+    epicsThreadSleep(seconds);
+    threads = threadCount();
+    isStopped = 1;
+    for( i = 0; i < buses; ++i )
+        epicsEventMustWait(readers[i].done);
+    epicsTimeGetCurrent(&end);
+    cpu = cpuNow() - cpu;
+    wall = epicsTimeDiffInSeconds(&end,&start);
+
+    /* All reads of the farm together */
+    for( total = n = nErr = 0, i = 0; i < buses; ++i )
+    {
+        total += readers[i].n;
+        n += (readers[i].n < K_LATMAX)?readers[i].n:K_LATMAX;
+        nErr += readers[i].nErr;
+    }
+    lats = calloc((n)?n:1,sizeof(double));
+    for( n = 0, i = 0; i < buses; ++i )
+    {
+        memcpy(lats + n,readers[i].lats,((readers[i].n < K_LATMAX)?readers[i].n:K_LATMAX) * sizeof(double));
+        n += (readers[i].n < K_LATMAX)?readers[i].n:K_LATMAX;
+    }
+
+    if( n )
+    {
+        qsort(lats,n,sizeof(double),compareDouble);
+        sprintf(spec,"%-6s %5d %8ld %5d %8.1f %8.2f %8.2f %8.2f %8.3f %7ld",mode,buses,total,nErr,total / wall,lats[n / 2] * 1e3,lats[(n * 99) / 100] * 1e3,
+                lats[n - 1] * 1e3,(cpu * 1e3) / total,threads);
+        testDiag("%s",spec);
+        if( pout )
+            fprintf(pout,"%s\n",spec);
+    }
+    testOk((n > 0) && (nErr == 0),"%s farm %ld reads, %d failed",mode,total,nErr);
+
+    free(lats);
+    for( i = 0; i < buses; ++i )
+    {
+        free(readers[i].lats);
+        epicsEventDestroy(readers[i].done);
+        loveSimStop(&sims[i]);
+    }
+}
+
+
+MAIN(testLoveBench)
+{
+    int count,buses;
+    double seconds;
+    char spec[96];
+    const char* penv;
+    LoveSim ref,tty,evt;
+
+    penv = getenv("LOVE_BENCH_COUNT");
+    count = (penv && strlen(penv))?atoi(penv):K_COUNT;
+    penv = getenv("LOVE_BENCH_BUSES");
+    buses = (penv && strlen(penv))?atoi(penv):K_BUSES;
+    if( (buses < 1) || (buses > K_FARMMAX) )
+        buses = K_BUSES;
+    penv = getenv("LOVE_BENCH_SECONDS");
+    seconds = (penv && strlen(penv))?atof(penv):K_SECONDS;
+    penv = getenv("LOVE_BENCH_GAP");
+    gap = (penv && strlen(penv))?atof(penv):0.0;
+    penv = getenv("LOVE_BENCH_OUT");
+    if( penv && strlen(penv) )
+        pout = fopen(penv,"a");
+
+    testPlan(10);
+
+    if( loveSimStart(&ref,"loveBenchRef","-n 1") || loveSimStart(&tty,"loveBenchTty","-n 1") || loveSimStart(&evt,"loveBenchEvt","-n 1") )
+        testAbort("loveSim did not start");
+
+    testOk((drvAsynSerialPortConfigure("SB",ref.link,0,0,0) == 0) && (asynSetOption("SB",0,"baud","19200") == 0) &&
+           (drvLoveInit("LB1","SB",0,NULL) == 0) && (drvLoveGap("LB1",gap) == 0) && (drvLoveConfig("LB1",1,"1600") == 0),"drvAsynSerialPort port");
+    sprintf(spec,"%s,19200,8N1",tty.link);
+    testOk((drvLoveInit("LB2",spec,0,NULL) == 0) && (drvLoveGap("LB2",gap) == 0) && (drvLoveConfig("LB2",1,"1600") == 0),"tty port");
+    sprintf(spec,"event:%s,19200,8N1",evt.link);
+    testOk((drvLoveInit("LB3",spec,0,NULL) == 0) && (drvLoveGap("LB3",gap) == 0) && (drvLoveConfig("LB3",1,"1600") == 0),"event port");
+
+    testDiag("gap %.3f sec",gap);
+    if( pout )
+        fprintf(pout,"gap %.3f sec\n",gap);
+    testDiag("%-24s %6s %5s %8s %8s %8s %8s","transport","reads","err","p50","p99","max","cpu msec");
+    if( pout )
+        fprintf(pout,"%-24s %6s %5s %8s %8s %8s %8s\n","transport","reads","err","p50","p99","max","cpu msec");
+    benchPort("drvAsynSerialPort+EOS","LB1",0,count);
+    benchPort("tty","LB2",0,count);
+    benchPort("event","LB3",1,count);
+
+    loveSimStop(&ref);
+    loveSimStop(&tty);
+    loveSimStop(&evt);
+
+    /* Thread per port against the engine, on the same number of buses */
+    testDiag("%-6s %5s %8s %5s %8s %8s %8s %8s %8s %7s","ports","buses","reads","err","tps","p50","p99","max","cpu msec","threads");
+    if( pout )
+        fprintf(pout,"%-6s %5s %8s %5s %8s %8s %8s %8s %8s %7s\n","ports","buses","reads","err","tps","p50","p99","max","cpu msec","threads");
+    benchFarm("tty",buses,seconds);
+    benchFarm("event",buses,seconds);
+
+    if( pout )
+        fclose(pout);
+
+    return( testDone() );
+}
@@ -0,0 +1,349 @@
+/*
+
+                          Love Controller Modbus RTU Test
+
+ -----------------------------------------------------------------------------
+ Description
+    Runs the Modbus RTU transport of drvLove against loveSim on a pty.
+    The simulator ignores requests with a bad CRC and the driver rejects
+    replies with one, so every successful read checks the CRC and the
+    length framing in both directions. A second, fully faulted bus
+    checks that silence, a corrupted CRC, an exception and a cut-off
+    reply each fail the attempt and are retried.
+    Since the driver and loveSim share the register map, the test also
+    checks the CRC against a published CRC-16/MODBUS vector and plays
+    the controller itself on a pty: every request must match a frame
+    written out by hand and is answered with a hand-written reply.
+
+ History:
+ -----------------------------------------------------------------------------
+ 2026-Oct-18       Initial version.
+ 2026-Oct-18       Hand-written reference frames and CRC vector.
+ -----------------------------------------------------------------------------
+
+*/
+
+
+/* posix_openpt() and friends */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+
+/* System related include files */
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/* EPICS system related include files */
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+
+/* EPICS synApps/Asyn related include files */
+#include <asynDriver.h>
+#include <asynInt32SyncIO.h>
+
+
+/* Local related include files */
+#include "loveTestSim.h"
+
+
+/* Define symbolic constants */
+#define K_TIMEOUT ( 10.0 )
+#define K_REFMAX  ( 32 )
+
+
+/* Declare reference frame structure */
+typedef struct Ref
+{
+    const char* name;
+    int isWrite;
+    epicsInt32 value;
+    int reqLen;
+    unsigned char req[K_REFMAX];
+    int repLen;
+    unsigned char rep[K_REFMAX];
+} Ref;
+
+
+/*
+ * Frames of a 16A at 0x01, written out from the register map and the
+ * CRC-16/MODBUS definition rather than produced by the driver or loveSim.
+ * The read replies hold AlSts 0 and Value 201; SP1 -25, SP2 300, AlLo 100
+ * and AlHi 400; Peak 450 and Valley -200; InpTyp 2, Decpts 1 and AlMode
+ * 3; ComSts 5. A write is answered with its echo.
+ */
+static const Ref refs[] =
+{
+    {"Value", 0,201,8,{0x01,0x03,0x00,0x00,0x00,0x02,0xC4,0x0B},
+                    9,{0x01,0x03,0x04,0x00,0x00,0x00,0xC9,0x3A,0x65}},
+    {"SP1",   0,-25,8,{0x01,0x03,0x01,0x01,0x00,0x07,0x54,0x34},
+                   19,{0x01,0x03,0x0E,0xFF,0xE7,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x2C,0x00,0x64,0x01,0x90,0xB5,0xF8}},
+    {"Peak",  0,450,8,{0x01,0x03,0x01,0x1D,0x00,0x02,0x55,0xF1},
+                    9,{0x01,0x03,0x04,0x01,0xC2,0xFF,0x38,0x1A,0x11}},
+    {"InpTyp",0,2,  8,{0x01,0x03,0x03,0x17,0x00,0x07,0xB4,0x48},
+                   19,{0x01,0x03,0x0E,0x00,0x02,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x03,0xB8,0x96}},
+    {"ComSts",0,5,  8,{0x01,0x03,0x03,0x24,0x00,0x01,0xC4,0x45},
+                    7,{0x01,0x03,0x02,0x00,0x05,0x78,0x47}},
+    {"SP1",   1,250,8,{0x01,0x06,0x02,0x00,0x00,0xFA,0x08,0x31},
+                    8,{0x01,0x06,0x02,0x00,0x00,0xFA,0x08,0x31}},
+    {"SP2",   1,-10,8,{0x01,0x06,0x02,0x04,0xFF,0xF6,0x08,0x05},
+                    8,{0x01,0x06,0x02,0x04,0xFF,0xF6,0x08,0x05}},
+    {"AlLo",  1,100,8,{0x01,0x06,0x02,0x07,0x00,0x64,0x38,0x58},
+                    8,{0x01,0x06,0x02,0x07,0x00,0x64,0x38,0x58}},
+    {"AlHi",  1,400,8,{0x01,0x06,0x02,0x08,0x01,0x90,0x08,0x4C},
+                    8,{0x01,0x06,0x02,0x08,0x01,0x90,0x08,0x4C}}
+};
+#define K_REFCOUNT ( (int)(sizeof(refs) / sizeof(refs[0])) )
+
+
+/* Declare reference controller structure */
+typedef struct Responder
+{
+    int fd;
+    int step;
+    int isMatch;
+    unsigned char got[K_REFMAX];
+    int gotLen;
+    epicsEventId go;
+    epicsEventId done;
+} Responder;
+
+
+static epicsUInt16 crc16(const unsigned char* pdata,size_t count)
+{
+    int bit;
+    size_t i;
+    epicsUInt16 crc = 0xFFFF;
+
+    /* CRC-16/MODBUS: reflected polynomial 0xA001, initial value 0xFFFF */
+    for( i = 0; i < count; ++i )
+    {
+        crc ^= pdata[i];
+        for( bit = 0; bit < 8; ++bit )
+            crc = (crc & 1)?((crc >> 1) ^ 0xA001):(crc >> 1);
+    }
+
+    return( crc );
+}
+
+
+static int crcTrails(const unsigned char* pframe,int len)
+{
+    epicsUInt16 crc = crc16(pframe,len - 2);
+
+    /* The CRC is sent low byte first */
+    return( (pframe[len - 2] == (crc & 0xFF)) && (pframe[len - 1] == (crc >> 8)) );
+}
+
+
+static void responderThread(void* parm)
+{
+    int len;
+    ssize_t got;
+    struct pollfd pfd;
+    const Ref* pref;
+    Responder* presp = (Responder*)parm;
+
+    for(;;)
+    {
+        epicsEventMustWait(presp->go);
+        if( presp->step < 0 )
+            break;
+        pref = &refs[presp->step];
+
+        /* Collect the request, the driver sends it as one frame */
+        for( len = 0; len < pref->reqLen; len += (int)got )
+        {
+            pfd.fd = presp->fd;
+            pfd.events = POLLIN;
+            if( poll(&pfd,1,(int)(K_TIMEOUT * 1000.0)) <= 0 )
+                break;
+            got = read(presp->fd,presp->got + len,pref->reqLen - len);
+            if( got <= 0 )
+                break;
+        }
+        presp->gotLen = len;
+
+        /* Only a request identical to the reference is answered */
+        presp->isMatch = (len == pref->reqLen) && (memcmp(presp->got,pref->req,len) == 0);
+        if( presp->isMatch && (write(presp->fd,pref->rep,pref->repLen) != pref->repLen) )
+            presp->isMatch = 0;
+
+        epicsEventSignal(presp->done);
+    }
+}
+
+
+static int openPty(char* pslave,size_t size)
+{
+    int fd;
+    const char* pname;
+
+    fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if( fd < 0 )
+        return( -1 );
+
+    pname = (grantpt(fd) == 0) && (unlockpt(fd) == 0)?ptsname(fd):NULL;
+    if( (pname == NULL) || (strlen(pname) >= size) )
+    {
+        close(fd);
+        return( -1 );
+    }
+    strcpy(pslave,pname);
+
+    return( fd );
+}
+
+
+static asynStatus readInt(const char* port,int addr,const char* name,epicsInt32* pvalue)
+{
+    asynStatus sts;
+    asynUser* pasynUser;
+
+    *pvalue = 0;
+    sts = pasynInt32SyncIO->connect(port,addr,&pasynUser,name);
+    if( sts != asynSuccess )
+        return( sts );
+
+    sts = pasynInt32SyncIO->read(pasynUser,pvalue,K_TIMEOUT);
+    pasynInt32SyncIO->disconnect(pasynUser);
+
+    return( sts );
+}
+
+
+static asynStatus writeInt(const char* port,int addr,const char* name,epicsInt32 value)
+{
+    asynStatus sts;
+    asynUser* pasynUser;
+
+    sts = pasynInt32SyncIO->connect(port,addr,&pasynUser,name);
+    if( sts != asynSuccess )
+        return( sts );
+
+    sts = pasynInt32SyncIO->write(pasynUser,value,K_TIMEOUT);
+    pasynInt32SyncIO->disconnect(pasynUser);
+
+    return( sts );
+}
+
+
+static void runReference(void)
+{
+    int i,ok;
+    asynStatus sts;
+    epicsInt32 value;
+    char slave[64];
+    Responder resp;
+    static const unsigned char vector[] = {0x01,0x03,0x00,0x00,0x00,0x01};
+
+    /* Published check frame: read one register at 0x0000 of address 1 ends in 84 0A */
+    testOk(crc16(vector,sizeof(vector)) == 0x0A84,"CRC-16/MODBUS of 01 03 00 00 00 01 is %4.4X",crc16(vector,sizeof(vector)));
+    for( ok = 1, i = 0; i < K_REFCOUNT; ++i )
+        ok = ok && crcTrails(refs[i].req,refs[i].reqLen) && crcTrails(refs[i].rep,refs[i].repLen);
+    testOk(ok,"every reference frame ends in its CRC");
+
+    memset(&resp,0,sizeof(resp));
+    resp.fd = openPty(slave,sizeof(slave));
+    if( resp.fd < 0 )
+        testAbort("no pty for the reference controller");
+    resp.go = epicsEventMustCreate(epicsEventEmpty);
+    resp.done = epicsEventMustCreate(epicsEventEmpty);
+    epicsThreadMustCreate("loveRef",epicsThreadPriorityMedium,epicsThreadGetStackSize(epicsThreadStackSmall),responderThread,&resp);
+
+    testOk(drvLoveInit("LP",slave,0,"RTU") == 0,"drvLoveInit RTU on %s",slave);
+    testOk(drvLoveConfig("LP",1,"16A") == 0,"16A at 0x01");
+
+    for( i = 0; i < K_REFCOUNT; ++i )
+    {
+        resp.step = i;
+        resp.isMatch = 0;
+        resp.gotLen = 0;
+        epicsEventSignal(resp.go);
+
+        value = refs[i].value;
+        if( refs[i].isWrite )
+            sts = writeInt("LP",1,refs[i].name,value);
+        else
+            sts = readInt("LP",1,refs[i].name,&value);
+
+        if( epicsEventWaitWithTimeout(resp.done,K_TIMEOUT) != epicsEventOK )
+            testAbort("reference controller did not finish %s",refs[i].name);
+        testOk(resp.isMatch && (sts == asynSuccess) && (value == refs[i].value),"%s %s %d matches the reference frames (%d request bytes)",
+               (refs[i].isWrite)?"write":"read",refs[i].name,value,resp.gotLen);
+    }
+
+    resp.step = -1;
+    epicsEventSignal(resp.go);
+}
+
+
+MAIN(testLoveRtu)
+{
+    asynStatus sts;
+    epicsInt32 value;
+    LoveSim bus,bad;
+    LoveSimStats stats;
+
+    testPlan(33);
+
+    runReference();
+
+    if( loveSimStart(&bus,"loveRtu","-r -n 2") )
+        testAbort("loveSim did not start");
+
+    testOk(drvLoveInit("LR",bus.link,0,"RTU") == 0,"drvLoveInit RTU on %s",bus.link);
+    testOk(drvLoveConfig("LR",1,"16A") == 0,"16A at 0x01");
+    testOk(drvLoveConfig("LR",2,"16A") == 0,"16A at 0x02");
+    testOk(drvLoveConfig("LR",3,"1600") != 0,"1600 rejected on an RTU port");
+
+    /* Register 0x0001 of each controller, each address answers with its own value */
+    sts = readInt("LR",1,"Value",&value);
+    testOk((sts == asynSuccess) && (value == 201),"Value of 0x01 is %d",value);
+    sts = readInt("LR",2,"Value",&value);
+    testOk((sts == asynSuccess) && (value == 202),"Value of 0x02 is %d",value);
+
+    /* One function 03 block covers 0x0101-0x0107, the neighbours come from the same frame */
+    sts = readInt("LR",1,"SP1",&value);
+    testOk((sts == asynSuccess) && (value == 250),"SP1 is %d",value);
+    sts = readInt("LR",1,"AlHi",&value);
+    testOk((sts == asynSuccess) && (value == 400),"AlHi is %d",value);
+    sts = readInt("LR",1,"Peak",&value);
+    testOk((sts == asynSuccess) && (value == 450),"Peak is %d",value);
+    sts = readInt("LR",1,"InpTyp",&value);
+    testOk((sts == asynSuccess) && (value == 2),"InpTyp is %d",value);
+
+    /* Function 06 to the 02## write code, checked against the echo */
+    testOk(writeInt("LR",1,"SP1",-25) == asynSuccess,"write SP1 -25");
+    sts = readInt("LR",1,"SP1",&value);
+    testOk((sts == asynSuccess) && (value == -25),"SP1 reads back %d",value);
+
+    testOk(loveSimStats(&bus,&stats) == 0,"simulator statistics");
+    testOk((stats.badFrames == 0) && (stats.errors == 0) && (stats.frames == stats.replies),
+           "%lu frames, %lu replies, %lu bad frames, %lu exceptions",stats.frames,stats.replies,stats.badFrames,stats.errors);
+    loveSimStop(&bus);
+
+    /* Every reply faulted: silence, bad CRC, exception 04 and a half frame in turn */
+    if( loveSimStart(&bad,"loveRtuBad","-r -x 1") )
+        testAbort("faulted loveSim did not start");
+
+    testOk(drvLoveInit("LF",bad.link,0,"RTU") == 0,"drvLoveInit RTU on %s",bad.link);
+    testOk(drvLoveConfig("LF",1,"16A") == 0,"16A at 0x01");
+    testOk(readInt("LF",1,"Value",&value) != asynSuccess,"silence, bad CRC and exception fail the read");
+    testOk(readInt("LF",1,"SP1",&value) != asynSuccess,"cut-off reply, silence and bad CRC fail the read");
+
+    testOk(loveSimStats(&bad,&stats) == 0,"faulted simulator statistics");
+    testOk((stats.frames == 6) && (stats.badFrames == 0) && (stats.silence == 2) && (stats.corrupt == 2) && (stats.error == 1) && (stats.partial == 1),
+           "%lu frames, %lu bad, faults %lu/%lu/%lu/%lu",stats.frames,stats.badFrames,stats.silence,stats.corrupt,stats.error,stats.partial);
+    loveSimStop(&bad);
+
+    return( testDone() );
+}
@@ -0,0 +1,167 @@
+/*
+
+                          Love Controller Soak Test
+
+ -----------------------------------------------------------------------------
+ Description
+    Soaks drvLove against loveSim on a pty. Four 1600 controllers are
+    read back to back for the whole run while drvLoveSoak() samples the
+    port, injects faults on the bus reads and churns record instances,
+    and the simulator adds faults of its own on the bus side. The test
+    passes when the soak monitor ends without a warning, every dropped
+    connection was opened again, the port still reads cleanly afterwards
+    and the driver never sent a broken frame.
+
+        LOVE_SOAK_HOURS  - Duration in hours (default 0.02)
+        LOVE_SOAK_PERIOD - Sample period in seconds (default 10)
+
+    It is not part of runtests; "make soak" in this directory runs it,
+    i.e. make soak LOVE_SOAK_HOURS=72.
+
+ History:
+ -----------------------------------------------------------------------------
+ 2026-Oct-18       Initial version.
+ 2026-Oct-18       Reads the soak state from the SoakBusy, SoakPeriods
+                   and SoakWarnings port parameters.
+ 2026-Oct-18       Checks that every dropped connection reconnected.
+ -----------------------------------------------------------------------------
+
+*/
+
+
+/* System related include files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* EPICS system related include files */
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+
+/* EPICS synApps/Asyn related include files */
+#include <asynDriver.h>
+#include <asynInt32SyncIO.h>
+
+
+/* Local related include files */
+#include "loveTestSim.h"
+
+
+/* Define symbolic constants */
+#define K_TIMEOUT ( 10.0 )
+#define K_HOURS   ( 0.02 )
+#define K_PERIOD  ( 10.0 )
+#define K_INSTR   ( 4 )
+#define K_FAULTS  ( 0.01 )
+
+
+static asynStatus readInt(const char* port,int addr,const char* name,epicsInt32* pvalue)
+{
+    asynStatus sts;
+    asynUser* pasynUser;
+
+    *pvalue = 0;
+    sts = pasynInt32SyncIO->connect(port,addr,&pasynUser,name);
+    if( sts != asynSuccess )
+        return( sts );
+
+    sts = pasynInt32SyncIO->read(pasynUser,pvalue,K_TIMEOUT);
+    pasynInt32SyncIO->disconnect(pasynUser);
+
+    return( sts );
+}
+
+
+static int soakState(const char* port,int* pdone,int* pperiods,int* pwarnings)
+{
+    epicsInt32 busy,periods,warnings;
+
+    /* The monitor publishes its state as port parameters; SoakBusy drops after the final counts */
+    if( readInt(port,-1,"SoakBusy",&busy) != asynSuccess )
+        return( -1 );
+    if( (readInt(port,-1,"SoakPeriods",&periods) != asynSuccess) || (readInt(port,-1,"SoakWarnings",&warnings) != asynSuccess) )
+        return( -1 );
+
+    *pdone = (busy == 0);
+    *pperiods = periods;
+    *pwarnings = warnings;
+
+    return( 0 );
+}
+
+
+MAIN(testLoveSoak)
+{
+    int i,addr,done,periods,warnings;
+    epicsInt32 faults,reconnects;
+    double hours,period,elapsed;
+    unsigned long nReads,nFailed;
+    const char* penv;
+    epicsInt32 value;
+    epicsTimeStamp start,now;
+    LoveSim bus;
+    LoveSimStats stats;
+    static const char* names[] = {"Value","SP1","AlSts","SP2"};
+
+    penv = getenv("LOVE_SOAK_HOURS");
+    hours = (penv && strlen(penv))?atof(penv):K_HOURS;
+    penv = getenv("LOVE_SOAK_PERIOD");
+    period = (penv && strlen(penv))?atof(penv):K_PERIOD;
+
+    testPlan(12);
+    testDiag("soak of %.2f hours, sampled every %.1f sec",hours,period);
+
+    if( loveSimStart(&bus,"loveSoak","-n 4 -x 0.01") )
+        testAbort("loveSim did not start");
+
+    testOk(drvLoveInit("LS",bus.link,0,NULL) == 0,"drvLoveInit on %s",bus.link);
+    for( done = 0, addr = 1; addr <= K_INSTR; ++addr )
+        done += (drvLoveConfig("LS",addr,"1600") == 0);
+    testOk(done == K_INSTR,"%d controllers configured",done);
+    testOk(drvLoveSoak("LS",period,hours,K_FAULTS,2) == 0,"soak started");
+
+    /* Keep the bus busy for the whole soak, failures are expected while faults are injected */
+    epicsTimeGetCurrent(&start);
+    for( nReads = nFailed = 0, i = 0, elapsed = 0.0; elapsed < ((hours * 3600.0) + (2.0 * period)); ++i )
+    {
+        ++nReads;
+        if( readInt("LS",(i % K_INSTR) + 1,names[(i / K_INSTR) % 4],&value) != asynSuccess )
+            ++nFailed;
+
+        if( ((i % 100) == 0) && (soakState("LS",&done,&periods,&warnings) == 0) && done )
+            break;
+
+        epicsTimeGetCurrent(&now);
+        elapsed = epicsTimeDiffInSeconds(&now,&start);
+    }
+    testDiag("%lu reads, %lu failed",nReads,nFailed);
+
+    /* The monitor stops by itself after the duration */
+    for( i = 0; (i < (int)(2.0 * period)) && ((soakState("LS",&done,&periods,&warnings) != 0) || (done == 0)); ++i )
+        epicsThreadSleep(1.0);
+
+    testOk(soakState("LS",&done,&periods,&warnings) == 0,"soak reported");
+    testOk(done,"soak finished after %d periods",periods);
+    testOk(warnings == 0,"%d soak warnings",warnings);
+    testOk((nReads > 0) && (nFailed < nReads),"%lu of %lu reads succeeded",nReads - nFailed,nReads);
+
+    /* Every third fault drops the connection, the tty is opened again each time */
+    testOk((readInt("LS",-1,"SoakFaults",&faults) == asynSuccess) && (readInt("LS",-1,"SoakReconnects",&reconnects) == asynSuccess),"soak counts read");
+    testOk((reconnects > 0) && (reconnects == (faults / 3)),"%d of %d faults dropped the connection and reconnected",reconnects,faults);
+
+    /* Driver faults end with the soak; one of the simulator's may still hit a single read */
+    for( i = 0; (i < 3) && (readInt("LS",1,"SP1",&value) != asynSuccess); ++i )
+        ;
+    testOk((i < 3) && (value == 250),"SP1 of 0x01 reads %d after the soak",value);
+
+    testOk(loveSimStats(&bus,&stats) == 0,"simulator statistics");
+    testOk(stats.badFrames == 0,"%lu frames, %lu bad frames, %lu simulator faults",stats.frames,stats.badFrames,
+           stats.silence + stats.corrupt + stats.error + stats.partial);
+    loveSimStop(&bus);
+
+    return( testDone() );
+}
@@ -0,0 +1,140 @@
+/*
+
+                          Love Controller Direct tty Test
+
+ -----------------------------------------------------------------------------
+ Description
+    Runs the direct tty transport of drvLove and, as the reference, a
+    drvAsynSerialPort with asynInterposeEos against loveSim, each port
+    on its own pty. Both must read the same values, write and read back
+    a negative set point, time out on an address nobody answers and
+    send only well-formed frames.
+
+ History:
+ -----------------------------------------------------------------------------
+ 2026-Oct-18       Initial version.
+ -----------------------------------------------------------------------------
+
+*/
+
+
+/* System related include files */
+#include <stdio.h>
+
+
+/* EPICS system related include files */
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+
+/* EPICS synApps/Asyn related include files */
+#include <asynDriver.h>
+#include <asynInt32SyncIO.h>
+#include <asynShellCommands.h>
+#include <drvAsynSerialPort.h>
+
+
+/* Local related include files */
+#include "loveTestSim.h"
+
+
+/* Define symbolic constants */
+#define K_TIMEOUT ( 10.0 )
+
+
+static asynStatus readInt(const char* port,int addr,const char* name,epicsInt32* pvalue)
+{
+    asynStatus sts;
+    asynUser* pasynUser;
+
+    *pvalue = 0;
+    sts = pasynInt32SyncIO->connect(port,addr,&pasynUser,name);
+    if( sts != asynSuccess )
+        return( sts );
+
+    sts = pasynInt32SyncIO->read(pasynUser,pvalue,K_TIMEOUT);
+    pasynInt32SyncIO->disconnect(pasynUser);
+
+    return( sts );
+}
+
+
+static asynStatus writeInt(const char* port,int addr,const char* name,epicsInt32 value)
+{
+    asynStatus sts;
+    asynUser* pasynUser;
+
+    sts = pasynInt32SyncIO->connect(port,addr,&pasynUser,name);
+    if( sts != asynSuccess )
+        return( sts );
+
+    sts = pasynInt32SyncIO->write(pasynUser,value,K_TIMEOUT);
+    pasynInt32SyncIO->disconnect(pasynUser);
+
+    return( sts );
+}
+
+
+static void checkPort(const char* port,LoveSim* psim)
+{
+    epicsInt32 value;
+    asynStatus sts;
+    LoveSimStats stats;
+
+    sts = readInt(port,1,"Value",&value);
+    testOk((sts == asynSuccess) && (value == 201),"%s Value of 0x01 is %d",port,value);
+    sts = readInt(port,2,"Value",&value);
+    testOk((sts == asynSuccess) && (value == 202),"%s Value of 0x02 is %d",port,value);
+    sts = readInt(port,1,"AlMode",&value);
+    testOk((sts == asynSuccess) && (value == 1),"%s AlMode is %d",port,value);
+
+    testOk(writeInt(port,1,"SP1",-25) == asynSuccess,"%s write SP1 -25",port);
+    sts = readInt(port,1,"SP1",&value);
+    testOk((sts == asynSuccess) && (value == -25),"%s SP1 reads back %d",port,value);
+
+    /* The simulator has no controller at 0x03, all three attempts time out */
+    testOk(readInt(port,3,"Value",&value) != asynSuccess,"%s read of a silent address fails",port);
+
+    testOk((loveSimStats(psim,&stats) == 0) && (stats.badFrames == 0) && (stats.ignored == 3),
+           "%s %lu frames, %lu bad frames, %lu to the silent address",port,stats.frames,stats.badFrames,stats.ignored);
+}
+
+
+MAIN(testLoveTty)
+{
+    int addr,count;
+    char spec[96];
+    LoveSim tty,ref;
+
+    testPlan(19);
+
+    if( loveSimStart(&tty,"loveTty","-n 2") || loveSimStart(&ref,"loveTtyRef","-n 2") )
+        testAbort("loveSim did not start");
+
+    /* Direct tty transport */
+    sprintf(spec,"%s,19200,8N1",tty.link);
+    testOk(drvLoveInit("LT",spec,0,NULL) == 0,"drvLoveInit on %s",spec);
+    for( count = 0, addr = 1; addr <= 3; ++addr )
+        count += (drvLoveConfig("LT",addr,"1600") == 0);
+    testOk(count == 3,"LT %d controllers configured",count);
+
+    /* drvAsynSerialPort with asynInterposeEos */
+    testOk(drvAsynSerialPortConfigure("SA",ref.link,0,0,0) == 0,"drvAsynSerialPortConfigure on %s",ref.link);
+    asynSetOption("SA",0,"baud","19200");
+    asynSetOption("SA",0,"bits","8");
+    asynSetOption("SA",0,"parity","none");
+    asynSetOption("SA",0,"stop","1");
+    asynSetOption("SA",0,"clocal","Y");
+    asynSetOption("SA",0,"crtscts","N");
+    testOk(drvLoveInit("LA","SA",0,NULL) == 0,"drvLoveInit on SA");
+    for( count = 0, addr = 1; addr <= 3; ++addr )
+        count += (drvLoveConfig("LA",addr,"1600") == 0);
+    testOk(count == 3,"LA %d controllers configured",count);
+
+    checkPort("LT",&tty);
+    checkPort("LA",&ref);
+    loveSimStop(&tty);
+    loveSimStop(&ref);
+
+    return( testDone() );
+}